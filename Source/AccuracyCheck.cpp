@@ -0,0 +1,434 @@
+#include "AccuracyCheck.h"
+#include "PluginProcessor.h"
+#include "BatchGenerator.h"
+
+#include <numeric>
+
+namespace
+{
+    constexpr int maxFftOrder = 17;
+    constexpr int maxWindowLength = 1 << 16;
+    constexpr int maxWindows = 61;
+    constexpr int maxHarmonic = 10;
+
+    // Bins either side of a peak that hold its Hann main lobe and near leakage
+    constexpr int peakHalfWidth = 4;
+
+    constexpr auto twoPi = juce::MathConstants<double>::twoPi;
+
+    double wrapCycles (double cycles) noexcept
+    {
+        return cycles - std::floor (cycles + 0.5);
+    }
+
+    double hann (int index, int length) noexcept
+    {
+        return 0.5 - 0.5 * std::cos (twoPi * (double) index / (double) length);
+    }
+
+    double toDecibels (double gain) noexcept
+    {
+        return 20.0 * std::log10 (juce::jmax (gain, 1.0e-15));
+    }
+
+    /** Hann-windowed magnitude spectrum of the longest power-of-two prefix. */
+    std::vector<float> getSpectrum (const float* samples, int numSamples, int& fftSize)
+    {
+        const auto order = juce::jmin (maxFftOrder, (int) std::floor (std::log2 ((double) juce::jmax (2, numSamples))));
+        fftSize = 1 << order;
+
+        std::vector<float> data ((size_t) fftSize * 2, 0.0f);
+
+        for (int i = 0; i < fftSize; ++i)
+            data[(size_t) i] = (float) (samples[i] * hann (i, fftSize));
+
+        juce::dsp::FFT (order).performFrequencyOnlyForwardTransform (data.data(), true);
+        data.resize ((size_t) fftSize / 2);
+        return data;
+    }
+
+    double getBandPower (const std::vector<float>& spectrum, double bin)
+    {
+        const auto centre = juce::roundToInt (bin);
+        double power = 0.0;
+
+        for (int i = juce::jmax (1, centre - peakHalfWidth); i <= juce::jmin ((int) spectrum.size() - 1, centre + peakHalfWidth); ++i)
+            power += (double) spectrum[(size_t) i] * (double) spectrum[(size_t) i];
+
+        return power;
+    }
+
+    /** Least-squares slope of values against times. */
+    double getSlope (const std::vector<double>& times, const std::vector<double>& values)
+    {
+        const auto count = (double) times.size();
+        const auto meanTime = std::accumulate (times.begin(), times.end(), 0.0) / count;
+        const auto meanValue = std::accumulate (values.begin(), values.end(), 0.0) / count;
+
+        double covariance = 0.0, variance = 0.0;
+
+        for (size_t i = 0; i < times.size(); ++i)
+        {
+            covariance += (times[i] - meanTime) * (values[i] - meanValue);
+            variance += (times[i] - meanTime) * (times[i] - meanTime);
+        }
+
+        return variance > 0.0 ? covariance / variance : 0.0;
+    }
+
+    /** Phase relative to the first window, unwrapped across windows. */
+    std::vector<double> getDrift (const std::vector<double>& phases)
+    {
+        std::vector<double> drift (phases.size(), 0.0);
+
+        for (size_t i = 1; i < phases.size(); ++i)
+            drift[i] = drift[i - 1] + wrapCycles (phases[i] - phases[i - 1]);
+
+        return drift;
+    }
+
+    double getLargestMagnitude (const std::vector<double>& values)
+    {
+        double largest = 0.0;
+
+        for (auto value : values)
+            largest = juce::jmax (largest, std::abs (value));
+
+        return largest;
+    }
+}
+
+//==============================================================================
+bool AccuracyCheck::Report::passed() const noexcept
+{
+    return std::all_of (measurements.begin(), measurements.end(), [] (const Measurement& m) { return m.passed(); });
+}
+
+juce::String AccuracyCheck::Report::toString() const
+{
+    juce::String text = description + (passed() ? "  [PASS]" : "  [FAIL]") + "\n";
+
+    for (const auto& m : measurements)
+        text << "    " << m.name.paddedRight (' ', 24)
+             << juce::String (m.value, 9).paddedLeft (' ', 18) << " " << m.unit.paddedRight (' ', 7)
+             << "limit " << juce::String (m.limit, 9) << (m.passed() ? "" : "   <-- out of tolerance") << "\n";
+
+    return text;
+}
+
+//==============================================================================
+double AccuracyCheck::measureFrequency (const float* samples, int numSamples, double sampleRate)
+{
+    int fftSize = 0;
+    const auto spectrum = getSpectrum (samples, numSamples, fftSize);
+
+    const auto peak = (int) (std::max_element (spectrum.begin() + 1, spectrum.end() - 1) - spectrum.begin());
+
+    const auto a = std::log (juce::jmax (1.0e-30, (double) spectrum[(size_t) peak - 1]));
+    const auto b = std::log (juce::jmax (1.0e-30, (double) spectrum[(size_t) peak]));
+    const auto c = std::log (juce::jmax (1.0e-30, (double) spectrum[(size_t) peak + 1]));
+    const auto curvature = a - 2.0 * b + c;
+    const auto offset = curvature < 0.0 ? 0.5 * (a - c) / curvature : 0.0;
+
+    return ((double) peak + offset) * sampleRate / (double) fftSize;
+}
+
+double AccuracyCheck::measureThd (const float* samples, int numSamples, double sampleRate, double fundamentalHz)
+{
+    int fftSize = 0;
+    const auto spectrum = getSpectrum (samples, numSamples, fftSize);
+    const auto binHz = sampleRate / (double) fftSize;
+
+    const auto fundamental = getBandPower (spectrum, fundamentalHz / binHz);
+    double harmonics = 0.0;
+
+    for (int harmonic = 2; harmonic <= maxHarmonic; ++harmonic)
+    {
+        const auto bin = harmonic * fundamentalHz / binHz;
+
+        if (bin + peakHalfWidth >= (double) spectrum.size())
+            break;
+
+        harmonics += getBandPower (spectrum, bin);
+    }
+
+    if (fundamental <= 0.0)
+        return 0.0;
+
+    return 10.0 * std::log10 (juce::jmax (harmonics / fundamental, 1.0e-30));
+}
+
+double AccuracyCheck::measurePhase (const float* samples, int numSamples, double sampleRate,
+                                    double frequencyHz, juce::int64 firstSample)
+{
+    // Single-bin DFT at exactly frequencyHz, with the reference phase taken
+    // from the absolute sample index so windows anywhere in the run agree
+    const auto cyclesPerSample = frequencyHz / sampleRate;
+    double inPhase = 0.0, quadrature = 0.0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto cycles = cyclesPerSample * (double) (firstSample + i);
+        const auto angle = twoPi * (cycles - std::floor (cycles));
+        const auto weighted = samples[i] * hann (i, numSamples);
+
+        inPhase += weighted * std::sin (angle);
+        quadrature += weighted * std::cos (angle);
+    }
+
+    return std::atan2 (quadrature, inPhase) / twoPi;
+}
+
+//==============================================================================
+AccuracyCheck::Report AccuracyCheck::checkGenerator (const OfflineRenderer::Settings& settings, double sampleRate,
+                                                     double durationSeconds, const Tolerances& tolerances)
+{
+    // The carriers run at the float frequencies the generator computes
+    const auto leftHz = (double) settings.baseFrequency;
+    const auto rightHz = (double) (settings.baseFrequency + settings.binauralOffset);
+    const auto beatHz = rightHz - leftHz;
+
+    Report report;
+    report.description = "Carriers " + juce::String (leftHz, 3) + " / " + juce::String (rightHz, 3) + " Hz, "
+                       + juce::String (durationSeconds) + " s at " + juce::String (sampleRate) + " Hz";
+
+    juce::AudioFormatManager formats;
+    OfflineRenderer renderer (formats);
+    constexpr int blockSize = 4096;
+
+    const auto totalSamples = (juce::int64) (sampleRate * durationSeconds);
+    const auto windowLength = (int) juce::jmin ((juce::int64) maxWindowLength, totalSamples / 2);
+
+    if (windowLength < 1024 || ! renderer.prepare (settings, sampleRate, blockSize))
+    {
+        report.measurements.push_back ({ "render", 1.0, 0.0, "" });
+        return report;
+    }
+
+    // Windows spread evenly from the first sample to the last, never overlapping
+    const auto numWindows = (int) juce::jlimit ((juce::int64) 2, (juce::int64) maxWindows, totalSamples / windowLength);
+    std::vector<juce::int64> windowStarts;
+
+    for (int w = 0; w < numWindows; ++w)
+        windowStarts.push_back ((totalSamples - windowLength) * w / (numWindows - 1));
+
+    juce::AudioBuffer<float> block (2, blockSize), window (2, windowLength);
+    std::vector<double> times, leftPhases, rightPhases;
+    double leftFrequency = 0.0, rightFrequency = 0.0, leftThd = -300.0, rightThd = -300.0;
+
+    size_t nextWindow = 0;
+
+    for (juce::int64 position = 0; position < totalSamples && nextWindow < windowStarts.size(); position += blockSize)
+    {
+        const auto numToRender = (int) juce::jmin ((juce::int64) blockSize, totalSamples - position);
+        renderer.render (block, numToRender);
+
+        // Copy the part of this block that falls in the current window
+        const auto windowStart = windowStarts[nextWindow];
+        const auto first = juce::jmax (position, windowStart);
+        const auto end = juce::jmin (position + numToRender, windowStart + windowLength);
+
+        for (int channel = 0; channel < 2 && first < end; ++channel)
+            window.copyFrom (channel, (int) (first - windowStart), block, channel, (int) (first - position), (int) (end - first));
+
+        if (end != windowStart + windowLength)
+            continue;
+
+        const auto* left = window.getReadPointer (0);
+        const auto* right = window.getReadPointer (1);
+
+        times.push_back ((double) windowStart / sampleRate);
+        leftPhases.push_back (measurePhase (left, windowLength, sampleRate, leftHz, windowStart));
+        rightPhases.push_back (measurePhase (right, windowLength, sampleRate, rightHz, windowStart));
+
+        if (nextWindow == 0)
+        {
+            leftFrequency = measureFrequency (left, windowLength, sampleRate);
+            rightFrequency = measureFrequency (right, windowLength, sampleRate);
+        }
+
+        if (nextWindow == 0 || nextWindow == windowStarts.size() - 1)
+        {
+            leftThd = juce::jmax (leftThd, measureThd (left, windowLength, sampleRate, leftHz));
+            rightThd = juce::jmax (rightThd, measureThd (right, windowLength, sampleRate, rightHz));
+        }
+
+        ++nextWindow;
+    }
+
+    std::vector<double> beatPhases;
+
+    for (size_t i = 0; i < leftPhases.size(); ++i)
+        beatPhases.push_back (rightPhases[i] - leftPhases[i]);
+
+    const auto leftDrift = getDrift (leftPhases);
+    const auto rightDrift = getDrift (rightPhases);
+    const auto beatDrift = getDrift (beatPhases);
+
+    // The phase slope is only meaningful once the FFT has found the carrier within a bin
+    const auto binHz = sampleRate / (double) (1 << juce::jmin (maxFftOrder, (int) std::floor (std::log2 ((double) windowLength))));
+
+    auto getError = [binHz] (double coarseError, double slope)
+    {
+        return std::abs (coarseError) > binHz ? std::abs (coarseError) : std::abs (slope);
+    };
+
+    const auto leftError = getError (leftFrequency - leftHz, getSlope (times, leftDrift));
+    const auto rightError = getError (rightFrequency - rightHz, getSlope (times, rightDrift));
+    const auto beatError = juce::jmax (leftError, rightError) > binHz
+                               ? std::abs ((rightFrequency - leftFrequency) - beatHz)
+                               : std::abs (getSlope (times, beatDrift));
+
+    report.measurements = {
+        { "left carrier error",  leftError,                         tolerances.carrierErrorHz,   "Hz" },
+        { "right carrier error", rightError,                        tolerances.carrierErrorHz,   "Hz" },
+        { "beat error",          beatError,                         tolerances.beatErrorHz,      "Hz" },
+        { "left phase drift",    getLargestMagnitude (leftDrift),   tolerances.phaseDriftCycles, "cycles" },
+        { "right phase drift",   getLargestMagnitude (rightDrift),  tolerances.phaseDriftCycles, "cycles" },
+        { "beat phase drift",    getLargestMagnitude (beatDrift),   tolerances.phaseDriftCycles, "cycles" },
+        { "left THD",            leftThd,                           tolerances.thdDb,            "dB" },
+        { "right THD",           rightThd,                          tolerances.thdDb,            "dB" }
+    };
+
+    return report;
+}
+
+//==============================================================================
+AccuracyCheck::Report AccuracyCheck::compareRealtimeWithExport (BinauralAudioProcessor& processor, double sampleRate,
+                                                                double durationSeconds, const Tolerances& tolerances)
+{
+    Report report;
+    report.description = "processBlock vs exportAudio, " + juce::String (durationSeconds) + " s at "
+                       + juce::String (sampleRate) + " Hz";
+
+    // A plain render: no cache hit, no checkpoints. The realtime side below
+    // uses another block size, which the output must not depend on either.
+    constexpr int exportBlockSize = 512;
+    constexpr int hostBlockSize = 480;
+
+    auto& cache = processor.getRenderCache();
+    auto& tuner = processor.getBlockSizeTuner();
+    const auto cacheWasEnabled = cache.isEnabled();
+    const auto checkpointInterval = processor.getExportCheckpointInterval();
+    const auto blockSizeOverride = tuner.getOverride();
+
+    cache.setEnabled (false);
+    processor.setExportCheckpointInterval (0.0);
+    tuner.setOverride (exportBlockSize);
+
+    juce::TemporaryFile exportFile (".wav");
+    const auto exported = processor.exportAudio (exportFile.getFile(), -1, durationSeconds,
+                                                 BinauralAudioProcessor::ExportFormat::WAV, 0, sampleRate, nullptr);
+
+    cache.setEnabled (cacheWasEnabled);
+    processor.setExportCheckpointInterval (checkpointInterval);
+    tuner.setOverride (blockSizeOverride);
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader (exported ? formats.createReaderFor (exportFile.getFile()) : nullptr);
+
+    if (reader == nullptr || reader->numChannels < 2)
+    {
+        report.measurements.push_back ({ "export", 1.0, 0.0, "" });
+        return report;
+    }
+
+    const auto numSamples = (int) reader->lengthInSamples;
+    juce::AudioBuffer<float> expected (2, numSamples);
+    reader->read (&expected, 0, numSamples, 0, true, true);
+
+    // Load the parameters with an empty block, then reset so they apply from
+    // the first sample instead of ramping from the defaults, as exports do
+    juce::MidiBuffer midi;
+    juce::AudioBuffer<float> buffer (2, hostBlockSize);
+
+    processor.prepareToPlay (sampleRate, hostBlockSize);
+    buffer.setSize (2, 0, false, false, true);
+    processor.processBlock (buffer, midi);
+    processor.releaseResources();
+    buffer.setSize (2, hostBlockSize);
+
+    // The realtime output runs the processor latency behind the export
+    const auto latency = processor.getLatencySamples();
+    const auto totalSamples = numSamples + latency;
+    double largestDifference = 0.0;
+
+    for (int position = 0; position < totalSamples; position += hostBlockSize)
+    {
+        const auto numToProcess = juce::jmin (hostBlockSize, totalSamples - position);
+        buffer.setSize (2, numToProcess, false, false, true);
+        processor.processBlock (buffer, midi);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = juce::jmax (0, latency - position); i < numToProcess; ++i)
+                largestDifference = juce::jmax (largestDifference,
+                                                (double) std::abs (buffer.getSample (channel, i)
+                                                                   - expected.getSample (channel, position + i - latency)));
+    }
+
+    report.measurements.push_back ({ "largest difference", toDecibels (largestDifference),
+                                     tolerances.equivalenceDb, "dBFS" });
+    return report;
+}
+
+AccuracyCheck::Report AccuracyCheck::compareBatchWithOscillator (const std::vector<OfflineRenderer::Settings>& streams,
+                                                                 double sampleRate, double durationSeconds,
+                                                                 const Tolerances& tolerances)
+{
+    Report report;
+    report.description = "BatchGenerator vs BinauralOscillator, " + juce::String ((int) streams.size()) + " streams, "
+                       + juce::String (durationSeconds) + " s at " + juce::String (sampleRate) + " Hz";
+
+    // Not a multiple of the tile length, so partial tiles are compared too
+    constexpr int blockSize = 1000;
+    const auto numStreams = (int) streams.size();
+    const auto numSamples = (juce::int64) (sampleRate * durationSeconds);
+
+    BatchGenerator batch (2);
+    batch.prepare (sampleRate, numStreams);
+
+    // Left then right for each stream, like the batch's outputs
+    std::vector<BinauralOscillator> oscillators ((size_t) numStreams * 2);
+
+    for (int stream = 0; stream < numStreams; ++stream)
+    {
+        const auto& settings = streams[(size_t) stream];
+        const auto leftGain = BinauralGenerator::volumeToGain (settings.leftVolumeDb);
+        const auto rightGain = BinauralGenerator::volumeToGain (settings.rightVolumeDb);
+
+        batch.setStream (stream, settings.baseFrequency, settings.binauralOffset, leftGain, rightGain);
+
+        for (int ear = 0; ear < 2; ++ear)
+        {
+            auto& oscillator = oscillators[(size_t) (2 * stream + ear)];
+            oscillator.prepare ({ sampleRate, (juce::uint32) blockSize, 1 });
+            oscillator.setFrequency (settings.baseFrequency + (ear == 0 ? 0.0f : settings.binauralOffset), true);
+            oscillator.setAmplitude (ear == 0 ? leftGain : rightGain);
+            oscillator.reset();
+        }
+    }
+
+    juce::AudioBuffer<float> batchOutput (2 * numStreams, blockSize);
+    std::vector<float> expected ((size_t) blockSize);
+    double largestDifference = 0.0;
+
+    for (juce::int64 position = 0; position < numSamples; position += blockSize)
+    {
+        const auto numToRender = (int) juce::jmin ((juce::int64) blockSize, numSamples - position);
+        batch.render (batchOutput.getArrayOfWritePointers(), numToRender);
+
+        for (int channel = 0; channel < 2 * numStreams; ++channel)
+        {
+            oscillators[(size_t) channel].renderBlock (expected.data(), numToRender);
+            const auto* actual = batchOutput.getReadPointer (channel);
+
+            for (int i = 0; i < numToRender; ++i)
+                largestDifference = juce::jmax (largestDifference, (double) std::abs (actual[i] - expected[(size_t) i]));
+        }
+    }
+
+    report.measurements.push_back ({ "largest difference", toDecibels (largestDifference),
+                                     tolerances.batchEquivalenceDb, "dBFS" });
+    return report;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "OfflineRenderer.h"
+
+class BinauralAudioProcessor;
+
+//==============================================================================
+/**
+    Accuracy and drift checks for the carrier DSP, for verifying that a
+    faster oscillator or render path still produces the right beat.
+
+    checkGenerator() renders through BinauralGenerator (via OfflineRenderer)
+    for any duration, keeping only short analysis windows spread over the
+    run, and measures:
+      - carrier and beat frequency error: an FFT peak finds each carrier, and
+        the phase slope across the windows refines it far below a bin
+      - phase drift: how far each carrier, and the beat, wander from an ideal
+        oscillator at the expected frequency over the whole run
+      - THD of each carrier, from the FFT of the first and last windows
+
+    compareRealtimeWithExport() renders the same settings through
+    processBlock and exportAudio and reports the largest difference, after
+    aligning for the latency the realtime path keeps.
+
+    compareBatchWithOscillator() renders streams through BatchGenerator and
+    each carrier through its own BinauralOscillator, and reports the largest
+    difference.
+
+    Measured values are compared with golden Tolerances; see the
+    binaural-accuracy-check tool for the standard set of cases.
+*/
+class AccuracyCheck
+{
+public:
+    struct Tolerances
+    {
+        double carrierErrorHz = 1.0e-6;
+        double beatErrorHz = 1.0e-6;
+        double phaseDriftCycles = 1.0e-4;
+        double thdDb = -100.0;
+
+        // Largest realtime/export difference, in dB full scale; 24-bit export quantisation is about -144
+        double equivalenceDb = -100.0;
+
+        // BatchGenerator's float phasors drift from the double-phase
+        // oscillator by up to about -70 dB over a second at 8 kHz
+        double batchEquivalenceDb = -60.0;
+    };
+
+    struct Measurement
+    {
+        juce::String name;
+        double value;
+        double limit;
+        juce::String unit;
+
+        bool passed() const noexcept  { return value <= limit; }
+    };
+
+    struct Report
+    {
+        juce::String description;
+        std::vector<Measurement> measurements;
+
+        bool passed() const noexcept;
+        juce::String toString() const;
+    };
+
+    static Report checkGenerator (const OfflineRenderer::Settings& settings, double sampleRate,
+                                  double durationSeconds, const Tolerances& tolerances);
+
+    /** Uses the processor's current parameters; it is left prepared at sampleRate. */
+    static Report compareRealtimeWithExport (BinauralAudioProcessor& processor, double sampleRate,
+                                             double durationSeconds, const Tolerances& tolerances);
+
+    /** Only each setting's carriers and left/right volumes are used. */
+    static Report compareBatchWithOscillator (const std::vector<OfflineRenderer::Settings>& streams, double sampleRate,
+                                              double durationSeconds, const Tolerances& tolerances);
+
+    //==============================================================================
+    /** Frequency of the strongest component: Hann-windowed FFT peak with
+        parabolic interpolation on the log magnitudes.
+    */
+    static double measureFrequency (const float* samples, int numSamples, double sampleRate);
+
+    /** Total harmonic distortion of a tone at fundamentalHz, in dB relative to the fundamental. */
+    static double measureThd (const float* samples, int numSamples, double sampleRate, double fundamentalHz);
+
+    /** Phase in cycles, [-0.5, 0.5), of the frequencyHz component relative to
+        sin (2 pi f t) with t counted from sample 0 of the render, where
+        firstSample is the render position of samples[0].
+    */
+    static double measurePhase (const float* samples, int numSamples, double sampleRate,
+                                double frequencyHz, juce::int64 firstSample);
+};
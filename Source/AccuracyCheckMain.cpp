@@ -0,0 +1,107 @@
+#include "AccuracyCheck.h"
+#include "PluginProcessor.h"
+
+//==============================================================================
+/*
+    binaural-accuracy-check [--seconds S | --hours H] [--sample-rate SR]
+
+    Runs AccuracyCheck over the standard carrier cases, the batch renderer
+    and the realtime/export equivalence check, prints every measurement and exits with 1 if any is
+    out of tolerance. The default 60 s run is registered with CTest as
+    accuracy-check; use --hours for long drift runs before swapping in a
+    faster kernel.
+*/
+namespace
+{
+    struct CarrierCase
+    {
+        float baseFrequency;
+        float binauralOffset;
+    };
+
+    // From the bottom of the carrier range to the top, with delta to gamma beats
+    const CarrierCase standardCases[] = {
+        { 100.0f,  4.0f },
+        { 200.0f,  6.0f },
+        { 440.0f,  10.0f },
+        { 1000.0f, 40.0f },
+        { 8000.0f, 0.5f }
+    };
+
+    void setParameter (BinauralAudioProcessor& processor, const char* parameterID, float value)
+    {
+        auto* parameter = processor.getValueTreeState().getParameter (parameterID);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList arguments (argc, argv);
+
+    auto durationSeconds = 60.0;
+
+    if (arguments.containsOption ("--seconds"))
+        durationSeconds = arguments.getValueForOption ("--seconds").getDoubleValue();
+    else if (arguments.containsOption ("--hours"))
+        durationSeconds = arguments.getValueForOption ("--hours").getDoubleValue() * 3600.0;
+
+    const auto sampleRate = arguments.containsOption ("--sample-rate")
+                                ? arguments.getValueForOption ("--sample-rate").getDoubleValue()
+                                : 48000.0;
+
+    if (durationSeconds < 1.0 || sampleRate < 8000.0)
+    {
+        std::cerr << "Needs at least 1 s at 8 kHz or more" << std::endl;
+        return 1;
+    }
+
+    // The processor's parameter state needs the message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const AccuracyCheck::Tolerances tolerances;
+    bool allPassed = true;
+
+    auto print = [&allPassed] (const AccuracyCheck::Report& report)
+    {
+        std::cout << report.toString() << std::endl;
+        allPassed = allPassed && report.passed();
+    };
+
+    for (const auto& carrierCase : standardCases)
+    {
+        OfflineRenderer::Settings settings;
+        settings.baseFrequency = carrierCase.baseFrequency;
+        settings.binauralOffset = carrierCase.binauralOffset;
+        settings.limiter = false;
+
+        print (AccuracyCheck::checkGenerator (settings, sampleRate, durationSeconds, tolerances));
+    }
+
+    // The batch renderer's streams against one oscillator per carrier: the
+    // standard cases at a few gains, enough streams to split over workers
+    std::vector<OfflineRenderer::Settings> batchStreams;
+
+    for (int stream = 0; stream < 600; ++stream)
+    {
+        const auto& carrierCase = standardCases[(size_t) stream % std::size (standardCases)];
+        OfflineRenderer::Settings settings;
+        settings.baseFrequency = carrierCase.baseFrequency;
+        settings.binauralOffset = carrierCase.binauralOffset;
+        settings.leftVolumeDb = -6.0f * (float) (stream % 3);
+        settings.rightVolumeDb = -6.0f * (float) (stream % 4);
+        batchStreams.push_back (settings);
+    }
+
+    print (AccuracyCheck::compareBatchWithOscillator (batchStreams, sampleRate, 1.0, tolerances));
+
+    // Equivalence compares every sample, so it keeps to a shorter render
+    BinauralAudioProcessor processor;
+    setParameter (processor, BinauralAudioProcessor::MODE_ID, 1.0f);
+    setParameter (processor, BinauralAudioProcessor::BASE_FREQUENCY_ID, 200.0f);
+    setParameter (processor, BinauralAudioProcessor::BINAURAL_OFFSET_ID, 6.0f);
+
+    print (AccuracyCheck::compareRealtimeWithExport (processor, sampleRate, juce::jmin (durationSeconds, 30.0), tolerances));
+
+    std::cout << (allPassed ? "All checks passed" : "Some checks FAILED") << std::endl;
+    return allPassed ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Single-producer/single-consumer stereo FIFO from the audio thread to the
+    editor's analyzer.
+
+    The audio thread only pushes while an editor has switched the feed on,
+    and never allocates, locks or waits: when the FIFO is full the block is
+    dropped. The message thread pulls whatever is ready on its own timer.
+*/
+class AnalyzerFeed
+{
+public:
+    static constexpr int capacity = 1 << 15;
+
+    AnalyzerFeed()
+    {
+        storage.setSize (2, capacity);
+    }
+
+    /** Message thread, like pull(). */
+    void setActive (bool shouldBeActive) noexcept
+    {
+        // Drop what was left from the last time, from the reading side only:
+        // a push() that saw the feed active may still be writing
+        if (shouldBeActive && ! active.load())
+            fifo.finishedRead (fifo.getNumReady());
+
+        active = shouldBeActive;
+    }
+
+    bool isActive() const noexcept  { return active.load (std::memory_order_relaxed); }
+
+    /** Audio thread. */
+    void push (const float* left, const float* right, int numSamples) noexcept
+    {
+        if (fifo.getFreeSpace() < numSamples)
+            return;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+        const float* const sources[] = { left, right };
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            juce::FloatVectorOperations::copy (storage.getWritePointer (channel, start1), sources[channel], size1);
+
+            if (size2 > 0)
+                juce::FloatVectorOperations::copy (storage.getWritePointer (channel, start2), sources[channel] + size1, size2);
+        }
+
+        fifo.finishedWrite (size1 + size2);
+    }
+
+    /** Message thread; returns the number of frames copied. */
+    int pull (float* left, float* right, int maxSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (maxSamples, start1, size1, start2, size2);
+
+        float* const destinations[] = { left, right };
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            juce::FloatVectorOperations::copy (destinations[channel], storage.getReadPointer (channel, start1), size1);
+
+            if (size2 > 0)
+                juce::FloatVectorOperations::copy (destinations[channel] + size1, storage.getReadPointer (channel, start2), size2);
+        }
+
+        fifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    juce::AudioBuffer<float> storage;
+    std::atomic<bool> active { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalyzerFeed)
+};
@@ -0,0 +1,222 @@
+#include "BackgroundLayer.h"
+#include "TraceProfiler.h"
+
+namespace
+{
+    constexpr int chunkSize = 4096;
+    constexpr double ringSeconds = 2.0;
+    constexpr int interpolatorPadding = 4;
+    constexpr int prefillChunks = 4;
+}
+
+//==============================================================================
+BackgroundLayer::BackgroundLayer()
+    : Thread ("BackgroundLayer reader")
+{
+}
+
+BackgroundLayer::~BackgroundLayer()
+{
+    unload();
+}
+
+bool BackgroundLayer::load (const juce::File& file, juce::AudioFormatManager& formatManager)
+{
+    std::unique_ptr<juce::AudioFormatReader> newReader (formatManager.createReaderFor (file));
+
+    if (newReader == nullptr || newReader->lengthInSamples <= 0 || newReader->numChannels == 0)
+        return false;
+
+    unload();
+
+    {
+        const juce::SpinLock::ScopedLockType lock (streamLock);
+
+        reader = std::move (newReader);
+        currentFile = file;
+        readPosition = 0;
+
+        const auto ringSize = juce::jmax (chunkSize * 8, (int) (reader->sampleRate * ringSeconds));
+        ring.setSize (2, ringSize);
+        fifo.setTotalSize (ringSize);
+        fifo.reset();
+        readBuffer.setSize (2, chunkSize);
+
+        configure();
+    }
+
+    // Have something ready before the first block asks for it
+    for (int i = 0; i < prefillChunks; ++i)
+        fillChunk();
+
+    loaded = true;
+    traceProfiler = TraceProfiler::getCurrent();
+    startThread();
+    return true;
+}
+
+void BackgroundLayer::unload()
+{
+    stopThread (2000);
+
+    const juce::SpinLock::ScopedLockType lock (streamLock);
+    loaded = false;
+    reader.reset();
+    currentFile = juce::File();
+}
+
+void BackgroundLayer::prepare (double newOutputRate, int newMaximumBlockSize)
+{
+    const juce::SpinLock::ScopedLockType lock (streamLock);
+
+    outputRate = newOutputRate;
+    maximumBlockSize = newMaximumBlockSize;
+    configure();
+}
+
+void BackgroundLayer::seek (juce::int64 outputSamplePosition)
+{
+    if (! loaded.load())
+        return;
+
+    stopThread (2000);
+
+    {
+        const juce::SpinLock::ScopedLockType lock (streamLock);
+
+        const auto filePosition = (juce::int64) std::llround ((double) outputSamplePosition * speedRatio);
+        readPosition = filePosition % reader->lengthInSamples;
+        fifo.reset();
+        configure();
+    }
+
+    for (int i = 0; i < prefillChunks; ++i)
+        fillChunk();
+
+    startThread();
+}
+
+void BackgroundLayer::configure()
+{
+    if (reader == nullptr)
+        return;
+
+    speedRatio = reader->sampleRate / outputRate;
+    staging.setSize (2, (int) std::ceil (maximumBlockSize * speedRatio) + interpolatorPadding);
+
+    for (auto& interpolator : interpolators)
+        interpolator.reset();
+}
+
+//==============================================================================
+void BackgroundLayer::addTo (float* left, float* right, int numSamples, float gain, bool waitForData)
+{
+    const juce::SpinLock::ScopedTryLockType lock (streamLock);
+
+    if (! lock.isLocked() || ! loaded.load())
+        return;
+
+    const auto resampling = speedRatio != 1.0;
+    const auto needed = resampling ? (int) std::ceil (numSamples * speedRatio) + interpolatorPadding
+                                   : numSamples;
+
+    if (needed > staging.getNumSamples())
+    {
+        jassertfalse; // block larger than the one passed to prepare()
+        return;
+    }
+
+    while (waitForData && fifo.getNumReady() < needed && isThreadRunning())
+    {
+        notify();
+        dataReady.wait (100);
+    }
+
+    // Reader fell behind: leave this block dry rather than wait on the disk
+    if (fifo.getNumReady() < needed)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (needed, start1, size1, start2, size2);
+
+    float* const destinations[] = { left, right };
+    auto consumed = numSamples;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* dest = destinations[channel];
+
+        if (! resampling)
+        {
+            juce::FloatVectorOperations::addWithMultiply (dest, ring.getReadPointer (channel, start1), gain, size1);
+
+            if (size2 > 0)
+                juce::FloatVectorOperations::addWithMultiply (dest + size1, ring.getReadPointer (channel, start2), gain, size2);
+
+            continue;
+        }
+
+        staging.copyFrom (channel, 0, ring, channel, start1, size1);
+
+        if (size2 > 0)
+            staging.copyFrom (channel, size1, ring, channel, start2, size2);
+
+        consumed = interpolators[(size_t) channel].processAdding (speedRatio, staging.getReadPointer (channel),
+                                                                  dest, numSamples, gain);
+    }
+
+    fifo.finishedRead (consumed);
+}
+
+//==============================================================================
+void BackgroundLayer::run()
+{
+    const TraceProfiler::ScopedAttach traceAttach (traceProfiler);
+
+    while (! threadShouldExit())
+    {
+        if (! fillChunk())
+            wait (10);
+    }
+}
+
+bool BackgroundLayer::fillChunk()
+{
+    if (reader == nullptr || fifo.getFreeSpace() < chunkSize)
+        return false;
+
+    BINAURAL_TRACE_SCOPE ("bed read");
+
+    // Read one chunk, wrapping at the end of the file for a seamless loop
+    const auto length = reader->lengthInSamples;
+
+    for (int done = 0; done < chunkSize;)
+    {
+        const auto numToRead = (int) juce::jmin ((juce::int64) (chunkSize - done), length - readPosition);
+        reader->read (&readBuffer, done, numToRead, readPosition, true, true);
+
+        done += numToRead;
+        readPosition += numToRead;
+
+        if (readPosition >= length)
+            readPosition = 0;
+    }
+
+    if (reader->numChannels == 1)
+        readBuffer.copyFrom (1, 0, readBuffer, 0, 0, chunkSize);
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (chunkSize, start1, size1, start2, size2);
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        ring.copyFrom (channel, start1, readBuffer, channel, 0, size1);
+
+        if (size2 > 0)
+            ring.copyFrom (channel, start2, readBuffer, channel, size1, size2);
+    }
+
+    fifo.finishedWrite (size1 + size2);
+    dataReady.signal();
+    return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+
+class TraceProfiler;
+
+//==============================================================================
+/**
+    Streams a long ambience recording (rain, ocean...) from disk as a looping
+    bed under the carriers.
+
+    A reader thread decodes the file ahead of playback into a fixed-size ring
+    buffer, wrapping to the start of the file so the loop is seamless. The
+    audio thread only pulls from that ring and resamples on the fly when the
+    file rate differs from the output rate, so it never touches the disk and
+    memory use does not depend on the file length. Files are always delivered
+    as stereo; mono files are copied to both channels.
+*/
+class BackgroundLayer : private juce::Thread
+{
+public:
+    BackgroundLayer();
+    ~BackgroundLayer() override;
+
+    /** Opens a file and starts streaming it. Call from the message thread,
+        or from an offline job's thread: the reader records its trace scopes
+        in the profiler attached there, if any.
+    */
+    bool load (const juce::File& file, juce::AudioFormatManager& formatManager);
+
+    /** Stops streaming and releases the file. */
+    void unload();
+
+    bool isLoaded() const noexcept              { return loaded.load(); }
+    const juce::File& getFile() const noexcept  { return currentFile; }
+
+    void prepare (double outputSampleRate, int maximumBlockSize);
+
+    /** Restarts the stream at the file sample nearest to an output sample
+        position, wrapping around the loop. For offline use: it stops the
+        reader thread while the ring is refilled.
+    */
+    void seek (juce::int64 outputSamplePosition);
+
+    /** Mixes the next numSamples of the bed into the two channels.
+
+        Never blocks in realtime use: if the reader has fallen behind, the block
+        is left untouched. When waitForData is true (offline rendering), the call
+        waits for the reader instead so exports never drop out.
+    */
+    void addTo (float* left, float* right, int numSamples, float gain, bool waitForData = false);
+
+private:
+    void run() override;
+    void configure();
+    bool fillChunk();
+
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    juce::File currentFile;
+    std::atomic<bool> loaded { false };
+    juce::SpinLock streamLock;
+
+    // Reader thread -> audio thread ring, in file samples
+    juce::AbstractFifo fifo { 1 };
+    juce::AudioBuffer<float> ring;
+    juce::AudioBuffer<float> readBuffer;
+    juce::int64 readPosition = 0;
+    juce::WaitableEvent dataReady;
+
+    // Profiler of the thread that loaded the file, attached to the reader
+    TraceProfiler* traceProfiler = nullptr;
+
+    // Audio thread resampling state
+    juce::AudioBuffer<float> staging;
+    std::array<juce::LagrangeInterpolator, 2> interpolators;
+    double outputRate = 44100.0;
+    int maximumBlockSize = 512;
+    double speedRatio = 1.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BackgroundLayer)
+};
@@ -0,0 +1,174 @@
+#include "BatchGenerator.h"
+
+namespace
+{
+    // Below this many streams per worker the hand-off costs more than it saves
+    constexpr int minStreamsPerJob = 4 * BatchGenerator::streamsPerTile;
+}
+
+//==============================================================================
+void BatchGenerator::Carriers::resize (size_t size)
+{
+    re.assign (size, 1.0f);
+    im.assign (size, 0.0f);
+    rotationRe.assign (size, 1.0f);
+    rotationIm.assign (size, 0.0f);
+    gain.assign (size, 0.0f);
+}
+
+//==============================================================================
+BatchGenerator::BatchGenerator (int numWorkerThreads)
+    : pool (juce::jmax (1, numWorkerThreads)),
+      numWorkers (juce::jmax (1, numWorkerThreads))
+{
+}
+
+BatchGenerator::~BatchGenerator()
+{
+    pool.removeAllJobs (true, 2000);
+}
+
+void BatchGenerator::prepare (double newSampleRate, int newNumStreams)
+{
+    jassert (newSampleRate > 0.0 && newNumStreams >= 0);
+
+    sampleRate = newSampleRate;
+    numStreams = newNumStreams;
+    left.resize ((size_t) numStreams);
+    right.resize ((size_t) numStreams);
+}
+
+void BatchGenerator::setStream (int index, float baseFrequency, float binauralOffset,
+                                float leftGain, float rightGain) noexcept
+{
+    jassert (juce::isPositiveAndBelow (index, numStreams));
+
+    const auto i = (size_t) index;
+    setRotation (left, i, baseFrequency);
+    setRotation (right, i, baseFrequency + binauralOffset);
+    left.gain[i] = leftGain;
+    right.gain[i] = rightGain;
+}
+
+void BatchGenerator::setRotation (Carriers& carriers, size_t index, float frequencyHz) noexcept
+{
+    const auto nyquist = (float) sampleRate * 0.5f;
+    const auto angle = juce::MathConstants<double>::twoPi * juce::jlimit (0.0f, nyquist, frequencyHz) / sampleRate;
+
+    carriers.rotationRe[index] = (float) std::cos (angle);
+    carriers.rotationIm[index] = (float) std::sin (angle);
+}
+
+void BatchGenerator::reset() noexcept
+{
+    for (auto* carriers : { &left, &right })
+    {
+        std::fill (carriers->re.begin(), carriers->re.end(), 1.0f);
+        std::fill (carriers->im.begin(), carriers->im.end(), 0.0f);
+    }
+}
+
+//==============================================================================
+void BatchGenerator::render (float* const* outputs, int numSamples)
+{
+    const auto numJobs = juce::jlimit (1, numWorkers, numStreams / minStreamsPerJob);
+
+    if (numJobs == 1)
+    {
+        renderRange (0, numStreams, outputs, numSamples);
+        return;
+    }
+
+    // Split on tile boundaries so no two workers share a tile
+    const auto numTiles = (numStreams + streamsPerTile - 1) / streamsPerTile;
+    std::atomic<int> pending { numJobs };
+    juce::WaitableEvent finished;
+
+    for (int job = 0; job < numJobs; ++job)
+    {
+        const auto first = juce::jmin (numStreams, numTiles * job / numJobs * streamsPerTile);
+        const auto end = juce::jmin (numStreams, numTiles * (job + 1) / numJobs * streamsPerTile);
+
+        pool.addJob ([this, first, end, outputs, numSamples, &pending, &finished]
+        {
+            renderRange (first, end, outputs, numSamples);
+
+            if (--pending == 0)
+                finished.signal();
+        });
+    }
+
+    finished.wait();
+}
+
+void BatchGenerator::renderRange (int firstStream, int endStream, float* const* outputs, int numSamples) noexcept
+{
+    // [sample][stream] for one tile, so the inner loop runs over contiguous streams
+    float tile[samplesPerTile * streamsPerTile];
+
+    for (auto tileStart = firstStream; tileStart < endStream; tileStart += streamsPerTile)
+    {
+        const auto numInTile = juce::jmin (streamsPerTile, endStream - tileStart);
+        const auto first = (size_t) tileStart;
+
+        for (int sampleStart = 0; sampleStart < numSamples; sampleStart += samplesPerTile)
+        {
+            const auto numTileSamples = juce::jmin (samplesPerTile, numSamples - sampleStart);
+
+            for (int ear = 0; ear < 2; ++ear)
+            {
+                renderTile (ear == 0 ? left : right, first, numInTile, tile, numTileSamples);
+
+                for (int stream = 0; stream < numInTile; ++stream)
+                {
+                    auto* dest = outputs[2 * (tileStart + stream) + ear] + sampleStart;
+
+                    for (int i = 0; i < numTileSamples; ++i)
+                        dest[i] = tile[i * streamsPerTile + stream];
+                }
+            }
+
+            renormalise (left, first, numInTile);
+            renormalise (right, first, numInTile);
+        }
+    }
+}
+
+void BatchGenerator::renderTile (Carriers& carriers, size_t first, int numStreams,
+                                 float* tile, int numSamples) noexcept
+{
+    auto* re = carriers.re.data() + first;
+    auto* im = carriers.im.data() + first;
+    const auto* rotationRe = carriers.rotationRe.data() + first;
+    const auto* rotationIm = carriers.rotationIm.data() + first;
+    const auto* gain = carriers.gain.data() + first;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto* row = tile + i * streamsPerTile;
+
+        for (int s = 0; s < numStreams; ++s)
+        {
+            row[s] = gain[s] * im[s];
+
+            const auto nextRe = re[s] * rotationRe[s] - im[s] * rotationIm[s];
+            const auto nextIm = re[s] * rotationIm[s] + im[s] * rotationRe[s];
+            re[s] = nextRe;
+            im[s] = nextIm;
+        }
+    }
+}
+
+void BatchGenerator::renormalise (Carriers& carriers, size_t first, int numStreams) noexcept
+{
+    // One Newton step towards |z| = 1 cancels the float rounding drift of the rotations
+    auto* re = carriers.re.data() + first;
+    auto* im = carriers.im.data() + first;
+
+    for (int s = 0; s < numStreams; ++s)
+    {
+        const auto correction = 1.5f - 0.5f * (re[s] * re[s] + im[s] * im[s]);
+        re[s] *= correction;
+        im[s] *= correction;
+    }
+}
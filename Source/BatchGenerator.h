@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+    Renders many independent binaural streams in one sweep.
+
+    Each stream is just a base frequency, an offset and two gains, so rather
+    than one BinauralAudioProcessor per listener the state lives in flat
+    structure-of-arrays vectors: every carrier is a unit phasor that is rotated
+    once per sample, which the compiler vectorises across streams. Streams are
+    processed in tiles of streamsPerTile x samplesPerTile so the working set of
+    a tile stays in L1, then transposed into the per-stream output channels.
+    Stream ranges are split across a worker pool.
+
+    A stream costs 40 bytes of state. Not meant for the audio thread: render()
+    blocks until every worker has finished.
+*/
+class BatchGenerator
+{
+public:
+    static constexpr int streamsPerTile = 64;
+    static constexpr int samplesPerTile = 64;
+
+    explicit BatchGenerator (int numWorkerThreads = juce::SystemStats::getNumCpus());
+    ~BatchGenerator();
+
+    /** Allocates state for numStreams streams, all silent until set. */
+    void prepare (double newSampleRate, int numStreams);
+
+    int getNumStreams() const noexcept  { return numStreams; }
+
+    /** Retunes a stream without resetting its phase. */
+    void setStream (int index, float baseFrequency, float binauralOffset,
+                    float leftGain, float rightGain) noexcept;
+
+    /** Restarts every stream at phase zero. */
+    void reset() noexcept;
+
+    /** Writes numSamples for every stream; outputs holds 2 * getNumStreams()
+        planar channels, left then right for each stream in order.
+    */
+    void render (float* const* outputs, int numSamples);
+
+private:
+    struct Carriers
+    {
+        // Current phasor and per-sample rotation, one entry per stream
+        std::vector<float> re, im, rotationRe, rotationIm;
+        std::vector<float> gain;
+
+        void resize (size_t size);
+    };
+
+    void renderRange (int firstStream, int endStream, float* const* outputs, int numSamples) noexcept;
+    void setRotation (Carriers& carriers, size_t index, float frequencyHz) noexcept;
+
+    static void renderTile (Carriers& carriers, size_t first, int numStreams,
+                            float* tile, int numSamples) noexcept;
+    static void renormalise (Carriers& carriers, size_t first, int numStreams) noexcept;
+
+    Carriers left, right;
+    int numStreams = 0;
+    double sampleRate = 48000.0;
+
+    juce::ThreadPool pool;
+    const int numWorkers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BatchGenerator)
+};
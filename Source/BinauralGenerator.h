@@ -1,11 +1,26 @@
 #pragma once
 
 #include <juce_dsp/juce_dsp.h>
-#include "BinauralOscillator.h"
+#include "RenderNodes.h"
+#include "ModulationEngine.h"
 
 //==============================================================================
 /**
     Main binaural generator class that manages two oscillators (left and right)
+
+    The carriers are rendered by a RenderGraph: one oscillator per ear (or a
+    pool of MIDI voices in polyphonic mode), the streamed bed mixed under
+    each, the master gain and a look-ahead safety limiter. The graph's two
+    outputs are then routed to the speakers of the current layout.
+
+    A ModulationEngine patch can move the carrier frequencies and the gains
+    from one block to the next; its per-sample arrays are handed to the
+    nodes for the duration of each graph pass.
+
+    A muted generator, or one with nothing left to hear once the limiter
+    has emptied, idles: blocks are cleared without running the graph and
+    the carriers only advance their phase, so rendering resumes without a
+    discontinuity. Muting and unmuting fade over muteFadeSeconds.
 */
 class BinauralGenerator
 {
@@ -17,33 +32,103 @@ public:
     };
 
     BinauralGenerator()
+        : leftOscillator (graph.addNode<OscillatorNode> (leftNode).getOscillator()),
+          rightOscillator (graph.addNode<OscillatorNode> (rightNode).getOscillator()),
+          backgroundPlayer (graph.addNode<FilePlayerNode> (backgroundNode)),
+          voicePool (graph.addNode<VoicePoolNode> (voicesNode)),
+          masterGain (graph.addNode<GainNode> (masterNode, 2)),
+          limiter (graph.addNode<LimiterNode> (limiterNode, 2).getLimiter())
     {
+        RenderGraph::NodeID leftMix, rightMix;
+        graph.addNode<MixNode> (leftMix, 3);
+        graph.addNode<MixNode> (rightMix, 3);
+
+        graph.connect (leftNode, 0, leftMix, 0);
+        graph.connect (backgroundNode, 0, leftMix, 1);
+        graph.connect (voicesNode, 0, leftMix, 2);
+        graph.connect (rightNode, 0, rightMix, 0);
+        graph.connect (backgroundNode, 1, rightMix, 1);
+        graph.connect (voicesNode, 1, rightMix, 2);
+        graph.connect (leftMix, 0, masterNode, 0);
+        graph.connect (rightMix, 0, masterNode, 1);
+        graph.connect (masterNode, 0, limiterNode, 0);
+        graph.connect (masterNode, 1, limiterNode, 1);
+        graph.setOutput (0, limiterNode, 0);
+        graph.setOutput (1, limiterNode, 1);
+
+        setChannelLayout (juce::AudioChannelSet::stereo());
     }
 
     void prepare (const juce::dsp::ProcessSpec& spec)
     {
-        leftOscillator.prepare (spec);
-        rightOscillator.prepare (spec);
-        masterGain.prepare (spec);
+        graph.prepare (spec, 2);
+        carrierBuffer.setSize (2, (int) spec.maximumBlockSize);
+        modulation.prepare (spec.sampleRate, (int) spec.maximumBlockSize);
+        rightFrequencyModulation.resize ((size_t) spec.maximumBlockSize);
+        outputGain.reset (spec.sampleRate, muteFadeSeconds);
         processSpec = spec;
+
+        if (speakerRoutes.size() != (size_t) spec.numChannels)
+            setChannelLayout (juce::AudioChannelSet::canonicalChannelSet ((int) spec.numChannels));
+    }
+
+    /** Computes the carrier routing for each output speaker.
+
+        Left-side speakers take the left carrier, right-side speakers the right
+        one, centre speakers (and mono) a monaural mix of both, LFE stays silent.
+        First-order ambisonic outputs (ACN/SN3D) encode the carriers hard left
+        and hard right. Call this from prepare time, never from the audio thread.
+    */
+    void setChannelLayout (const juce::AudioChannelSet& layout)
+    {
+        speakerRoutes.clear();
+
+        for (int channel = 0; channel < layout.size(); ++channel)
+            speakerRoutes.push_back (getRouteForChannel (layout.getTypeOfChannel (channel)));
     }
 
     void reset()
     {
-        leftOscillator.reset();
-        rightOscillator.reset();
-        masterGain.reset();
+        graph.reset();
+        modulation.reset();
+        outputGain.setCurrentAndTargetValue (outputGain.getTargetValue());
+        silentSamples = 0;
+        idle = false;
     }
 
-    void setBaseFrequency (float frequencyHz)
+    /** Fades out and then idles; unmuting fades back in on the carriers'
+        continuing phase.
+    */
+    void setMuted (bool shouldBeMuted) noexcept
+    {
+        outputGain.setTargetValue (shouldBeMuted ? 0.0f : 1.0f);
+    }
+
+    /** True when the last block was skipped rather than rendered. */
+    bool isIdle() const noexcept  { return idle; }
+
+    /** Volume parameters to gain. Their minimum is silence rather than a
+        quiet tone, so a channel pulled all the way down is not synthesized.
+    */
+    static float volumeToGain (float decibels, float trimDecibels = 0.0f) noexcept
+    {
+        return decibels <= minimumVolumeDb ? 0.0f : juce::Decibels::decibelsToGain (decibels + trimDecibels);
+    }
+
+    static constexpr float minimumVolumeDb = -60.0f;
+    static constexpr double muteFadeSeconds = 0.01;
+
+    /** Pass immediately = true to jump rather than glide (MIDI notes and bends). */
+    void setBaseFrequency (float frequencyHz, bool immediately = false)
     {
         baseFrequency = frequencyHz;
-        updateFrequencies();
+        updateFrequencies (immediately);
     }
 
     void setBinauralOffset (float offsetHz)
     {
         binauralOffset = offsetHz;
+        voicePool.setBinauralOffset (offsetHz);
         updateFrequencies();
     }
 
@@ -63,12 +148,57 @@ public:
 
     void setLeftVolume (float amplitude)
     {
-        leftOscillator.setAmplitude (amplitude);
+        leftVolume = amplitude;
+        leftOscillator.setAmplitude (polyphonic ? 0.0f : amplitude);
+        voicePool.setVolumes (leftVolume, rightVolume);
     }
 
     void setRightVolume (float amplitude)
     {
-        rightOscillator.setAmplitude (amplitude);
+        rightVolume = amplitude;
+        rightOscillator.setAmplitude (polyphonic ? 0.0f : amplitude);
+        voicePool.setVolumes (leftVolume, rightVolume);
+    }
+
+    //==============================================================================
+    /** In polyphonic mode the two main oscillators fade out and each MIDI note
+        plays its own binaural pair (base = note frequency, right = base + offset).
+    */
+    void setPolyphonic (bool shouldBePolyphonic)
+    {
+        if (polyphonic == shouldBePolyphonic)
+            return;
+
+        polyphonic = shouldBePolyphonic;
+
+        if (! polyphonic)
+            voicePool.allNotesOff();
+
+        setLeftVolume (leftVolume);
+        setRightVolume (rightVolume);
+    }
+
+    bool isPolyphonic() const noexcept  { return polyphonic; }
+
+    void noteOn (int channel, int note, float frequencyHz, float velocity) noexcept
+    {
+        voicePool.noteOn (channel, note, frequencyHz, velocity);
+    }
+
+    void noteOff (int channel, int note) noexcept
+    {
+        voicePool.noteOff (channel, note);
+    }
+
+    void allNotesOff() noexcept
+    {
+        voicePool.allNotesOff();
+    }
+
+    /** Frequency ratio applied to the voices started on that MIDI channel. */
+    void setChannelPitchBend (int channel, float ratio) noexcept
+    {
+        voicePool.setPitchBend (channel, ratio);
     }
 
     void setMasterVolume (float amplitude)
@@ -76,6 +206,83 @@ public:
         masterGain.setGainLinear (amplitude);
     }
 
+    /** The master limiter is bypassed but still delays when disabled, so the
+        latency only changes with setLimiterLookAhead().
+    */
+    void setLimiterEnabled (bool shouldBeEnabled) noexcept
+    {
+        limiter.setEnabled (shouldBeEnabled);
+    }
+
+    void setLimiterCeiling (float amplitude) noexcept
+    {
+        limiter.setCeiling (amplitude);
+    }
+
+    /** Takes effect on the next prepare(). */
+    void setLimiterLookAhead (int numSamples)
+    {
+        limiter.setLookAhead (numSamples);
+    }
+
+    int getLatencySamples() const noexcept
+    {
+        return limiter.getLatencySamples();
+    }
+
+    /** Locks both carriers and the modulation to a timeline position (see
+        BinauralOscillator::syncToPosition). MIDI voices keep free-running.
+    */
+    void syncToPosition (juce::int64 samplePosition) noexcept
+    {
+        leftOscillator.syncToPosition (samplePosition);
+        rightOscillator.syncToPosition (samplePosition);
+        modulation.syncToPosition (samplePosition);
+    }
+
+    /** Audio-thread safe; see ModulationEngine::setPatch(). The frequency
+        targets only apply in Binaural mode and MIDI voices are not modulated.
+    */
+    void setModulation (const ModulationEngine::Patch& patch) noexcept
+    {
+        modulation.setPatch (patch);
+    }
+
+    /** Carrier phases and limiter state, for offline renders that stop and
+        continue later. Parameter ramps and MIDI voices are not included, so
+        this is only exact once the ramps have settled and no notes sound.
+    */
+    void writeState (juce::OutputStream& stream) const
+    {
+        stream.writeDouble (leftOscillator.getPhase());
+        stream.writeDouble (rightOscillator.getPhase());
+        limiter.writeState (stream);
+    }
+
+    bool readState (juce::InputStream& stream)
+    {
+        leftOscillator.setPhase (stream.readDouble());
+        rightOscillator.setPhase (stream.readDouble());
+        return limiter.readState (stream);
+    }
+
+    /** Mixes a streamed bed under the carriers; pass nullptr to remove it. */
+    void setBackgroundLayer (BackgroundLayer* layer) noexcept
+    {
+        backgroundPlayer.setLayer (layer);
+    }
+
+    void setBackgroundVolume (float amplitude) noexcept
+    {
+        backgroundPlayer.setGain (amplitude);
+    }
+
+    /** Offline renders wait for the bed reader instead of dropping out. */
+    void setOfflineRendering (bool shouldWaitForBackground) noexcept
+    {
+        backgroundPlayer.setWaitForData (shouldWaitForBackground);
+    }
+
     void setMode (Mode newMode)
     {
         mode = newMode;
@@ -86,37 +293,200 @@ public:
     void process (const ProcessContext& context)
     {
         auto&& outputBlock = context.getOutputBlock();
-        auto numChannels = outputBlock.getNumChannels();
+        const auto numChannels = outputBlock.getNumChannels();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert (numSamples <= (size_t) carrierBuffer.getNumSamples());
 
-        if (numChannels < 2)
+        if (canIdle())
+        {
+            skipBlock ((int) numSamples);
+            outputBlock.clear();
             return;
+        }
+
+        idle = false;
+        const auto startedSilent = sourcesAreSilent();
+
+        if (modulation.process ((int) numSamples))
+            applyModulation ((int) numSamples);
 
-        // Clear output
-        outputBlock.clear();
+        // Render both carriers once, whatever the output layout is
+        graph.process (carrierBuffer.getArrayOfWritePointers(), 2, (int) numSamples);
+        clearModulation();
 
-        // Create temporary buffers for left and right channels
-        juce::dsp::AudioBlock<float> leftBlock (outputBlock.getSingleChannelBlock (0));
-        juce::dsp::AudioBlock<float> rightBlock (outputBlock.getSingleChannelBlock (1));
+        if (outputGain.isSmoothing())
+            outputGain.applyGain (carrierBuffer, (int) numSamples);
 
-        // Generate left channel
-        juce::dsp::ProcessContextReplacing<float> leftContext (leftBlock);
-        leftOscillator.process (leftContext);
+        // Nothing went in: the limiter's delay line is emptying
+        silentSamples = startedSilent ? silentSamples + (int) numSamples : 0;
 
-        // Generate right channel
-        juce::dsp::ProcessContextReplacing<float> rightContext (rightBlock);
-        rightOscillator.process (rightContext);
+        // Route the carriers to each speaker
+        const auto* left = carrierBuffer.getReadPointer (0);
+        const auto* right = carrierBuffer.getReadPointer (1);
 
-        // Apply master gain to entire output
-        masterGain.process (context);
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            const auto route = channel < speakerRoutes.size() ? speakerRoutes[channel] : SpeakerRoute {};
+            mixCarriers (outputBlock.getChannelPointer (channel), left, right, route, (int) numSamples);
+        }
     }
 
 private:
-    void updateFrequencies()
+    struct SpeakerRoute
+    {
+        float leftGain = 0.0f;
+        float rightGain = 0.0f;
+    };
+
+    static SpeakerRoute getRouteForChannel (juce::AudioChannelSet::ChannelType type)
+    {
+        using Type = juce::AudioChannelSet;
+
+        switch (type)
+        {
+            case Type::left:
+            case Type::leftCentre:
+            case Type::leftSurround:
+            case Type::leftSurroundSide:
+            case Type::leftSurroundRear:
+            case Type::wideLeft:
+            case Type::topFrontLeft:
+            case Type::topRearLeft:
+                return { 1.0f, 0.0f };
+
+            case Type::right:
+            case Type::rightCentre:
+            case Type::rightSurround:
+            case Type::rightSurroundSide:
+            case Type::rightSurroundRear:
+            case Type::wideRight:
+            case Type::topFrontRight:
+            case Type::topRearRight:
+                return { 0.0f, 1.0f };
+
+            case Type::centre:
+            case Type::centreSurround:
+            case Type::topMiddle:
+            case Type::topFrontCentre:
+            case Type::topRearCentre:
+                return { 0.5f, 0.5f };
+
+            // W and Y of a source at +90 degrees (left) and -90 degrees (right);
+            // Z and X are zero for sources on the horizontal left/right axis
+            case Type::ambisonicACN0:
+                return { 1.0f, 1.0f };
+
+            case Type::ambisonicACN1:
+                return { 1.0f, -1.0f };
+
+            default:
+                return {};
+        }
+    }
+
+    // Writes one speaker in a single pass over the block
+    static void mixCarriers (float* dest, const float* left, const float* right,
+                             SpeakerRoute route, int numSamples) noexcept
+    {
+        if (route.rightGain == 0.0f)
+        {
+            juce::FloatVectorOperations::copyWithMultiply (dest, left, route.leftGain, numSamples);
+        }
+        else if (route.leftGain == 0.0f)
+        {
+            juce::FloatVectorOperations::copyWithMultiply (dest, right, route.rightGain, numSamples);
+        }
+        else
+        {
+            const auto leftGain = route.leftGain;
+            const auto rightGain = route.rightGain;
+
+            for (int i = 0; i < numSamples; ++i)
+                dest[i] = left[i] * leftGain + right[i] * rightGain;
+        }
+    }
+
+    bool sourcesAreSilent() const noexcept
+    {
+        return masterGain.isSilent()
+            || (leftOscillator.isSilent() && rightOscillator.isSilent()
+                && backgroundPlayer.isSilent() && ! voicePool.hasActiveVoices());
+    }
+
+    // Muted after the fade, or silent for longer than the limiter delays
+    bool canIdle() const noexcept
+    {
+        if (! outputGain.isSmoothing() && outputGain.getTargetValue() == 0.0f)
+            return true;
+
+        return silentSamples >= getLatencySamples() && sourcesAreSilent();
+    }
+
+    // The analytic side of an idle block: phases and ramps move on, nothing is rendered
+    void skipBlock (int numSamples) noexcept
+    {
+        // The limiter holds silence or faded-out audio; start it empty for the resume
+        if (! idle)
+            limiter.reset();
+
+        idle = true;
+
+        leftOscillator.advance (numSamples);
+        rightOscillator.advance (numSamples);
+        voicePool.advance (numSamples);
+        masterGain.advance (numSamples);
+        modulation.advance (numSamples);
+    }
+
+    // Points the nodes at this block's modulation arrays
+    void applyModulation (int numSamples) noexcept
+    {
+        using Target = ModulationEngine::Target;
+
+        if (mode == Mode::Binaural)
+        {
+            const auto* base = modulation.getModulation (Target::baseFrequency);
+            const auto* offset = modulation.getModulation (Target::binauralOffset);
+            const float* right = base;
+
+            if (offset != nullptr)
+            {
+                if (base != nullptr)
+                    juce::FloatVectorOperations::add (rightFrequencyModulation.data(), base, offset, numSamples);
+                else
+                    juce::FloatVectorOperations::copy (rightFrequencyModulation.data(), offset, numSamples);
+
+                right = rightFrequencyModulation.data();
+            }
+
+            leftOscillator.setModulation (base, modulation.getModulation (Target::leftVolume));
+            rightOscillator.setModulation (right, modulation.getModulation (Target::rightVolume));
+        }
+        else
+        {
+            leftOscillator.setModulation (nullptr, modulation.getModulation (Target::leftVolume));
+            rightOscillator.setModulation (nullptr, modulation.getModulation (Target::rightVolume));
+        }
+
+        masterGain.setGainModulation (modulation.getModulation (Target::masterVolume));
+        backgroundPlayer.setGainModulation (modulation.getModulation (Target::backgroundVolume));
+    }
+
+    void clearModulation() noexcept
+    {
+        leftOscillator.setModulation (nullptr, nullptr);
+        rightOscillator.setModulation (nullptr, nullptr);
+        masterGain.setGainModulation (nullptr);
+        backgroundPlayer.setGainModulation (nullptr);
+    }
+
+    void updateFrequencies (bool immediately = false)
     {
         if (mode == Mode::Binaural)
         {
-            leftOscillator.setFrequency (baseFrequency);
-            rightOscillator.setFrequency (baseFrequency + binauralOffset);
+            leftOscillator.setFrequency (baseFrequency, immediately);
+            rightOscillator.setFrequency (baseFrequency + binauralOffset, immediately);
         }
         else
         {
@@ -125,15 +495,34 @@ private:
         }
     }
 
-    BinauralOscillator leftOscillator;
-    BinauralOscillator rightOscillator;
-    juce::dsp::Gain<float> masterGain;
+    RenderGraph graph;
+    RenderGraph::NodeID leftNode, rightNode, backgroundNode, voicesNode, masterNode, limiterNode;
+
+    BinauralOscillator& leftOscillator;
+    BinauralOscillator& rightOscillator;
+    FilePlayerNode& backgroundPlayer;
+    VoicePoolNode& voicePool;
+    GainNode& masterGain;
+    LookAheadLimiter& limiter;
+
+    juce::AudioBuffer<float> carrierBuffer;
+    std::vector<SpeakerRoute> speakerRoutes;
+
+    ModulationEngine modulation;
+    std::vector<float> rightFrequencyModulation;
+
+    juce::SmoothedValue<float> outputGain { 1.0f };
+    int silentSamples = 0;
+    bool idle = false;
 
     Mode mode = Mode::Binaural;
     float baseFrequency = 440.0f;
     float binauralOffset = 10.0f;
     float leftFrequency = 440.0f;
     float rightFrequency = 450.0f;
+    float leftVolume = 1.0f;
+    float rightVolume = 1.0f;
+    bool polyphonic = false;
 
     juce::dsp::ProcessSpec processSpec;
 };
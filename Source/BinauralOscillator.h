@@ -5,53 +5,184 @@
 //==============================================================================
 /**
     Simple sine wave oscillator for binaural generation
+
+    The phase is kept in cycles as a double so long renders do not drift,
+    and the sine is evaluated inline rather than through a std::function.
+    A silent oscillator only advances its phase, so parked channels cost
+    next to nothing and come back without a discontinuity.
 */
 class BinauralOscillator
 {
 public:
-    BinauralOscillator()
-    {
-        oscillator.initialise ([] (float x) { return std::sin (x); });
-    }
+    BinauralOscillator() = default;
 
     void prepare (const juce::dsp::ProcessSpec& spec)
     {
         sampleRate = spec.sampleRate;
-        oscillator.prepare (spec);
+        frequency.reset (sampleRate, 0.05);
+        amplitude.reset (sampleRate, 0.02);
     }
 
     void reset()
     {
-        oscillator.reset();
+        phase = 0.0;
+        frequency.setCurrentAndTargetValue (frequency.getTargetValue());
+        amplitude.setCurrentAndTargetValue (amplitude.getTargetValue());
+    }
+
+    /** Glides to the new frequency unless immediately is true (e.g. MIDI notes). */
+    void setFrequency (float frequencyHz, bool immediately = false)
+    {
+        if (frequencyHz <= 0.0f || frequencyHz > sampleRate * 0.5f)
+            return;
+
+        if (immediately)
+            frequency.setCurrentAndTargetValue (frequencyHz);
+        else
+            frequency.setTargetValue (frequencyHz);
+    }
+
+    void setAmplitude (float newAmplitude)
+    {
+        amplitude.setTargetValue (newAmplitude);
     }
 
-    void setFrequency (float frequencyHz)
+    /** True once the amplitude has settled at zero. */
+    bool isSilent() const noexcept
     {
-        if (frequencyHz > 0.0f && frequencyHz <= sampleRate * 0.5f)
-            oscillator.setFrequency (frequencyHz);
+        return ! amplitude.isSmoothing() && amplitude.getTargetValue() == 0.0f;
     }
 
-    void setAmplitude (float amplitude)
+    /** Jumps to the phase an oscillator started at sample 0 and running at
+        the target frequency would have at samplePosition, ending any glide.
+        Called with the host position whenever playback starts or jumps,
+        this makes the output a function of the timeline.
+    */
+    void syncToPosition (juce::int64 samplePosition) noexcept
     {
-        gain.setGainLinear (amplitude);
+        frequency.setCurrentAndTargetValue (frequency.getTargetValue());
+        setPhase ((double) frequency.getTargetValue() / sampleRate * (double) samplePosition);
+    }
+
+    /** Current phase in cycles, [0, 1). */
+    double getPhase() const noexcept        { return phase; }
+    void setPhase (double newPhase) noexcept  { phase = newPhase - std::floor (newPhase); }
+
+    /** Per-sample modulation for the next renderBlock() call: hertz added to
+        the frequency and a factor on the amplitude. Either may be nullptr;
+        the arrays must hold at least that block's samples.
+    */
+    void setModulation (const float* frequencyOffsets, const float* gainFactors) noexcept
+    {
+        frequencyModulation = frequencyOffsets;
+        gainModulation = gainFactors;
+    }
+
+    /** Moves on numSamples without rendering them: the ramps progress as
+        they would and the phase advances by the frequency over that time,
+        so a later renderBlock() continues exactly where a rendered run
+        would be. Uses the modulation set for this block, if any.
+    */
+    void advance (int numSamples) noexcept
+    {
+        amplitude.skip (numSamples);
+
+        if (frequencyModulation == nullptr && ! frequency.isSmoothing())
+        {
+            setPhase (phase + (double) frequency.getTargetValue() / sampleRate * (double) numSamples);
+            return;
+        }
+
+        // Only while gliding or modulated: a sum, still no sine
+        const auto nyquist = (float) sampleRate * 0.5f;
+        double cycles = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto hz = frequency.getNextValue() + (frequencyModulation != nullptr ? frequencyModulation[i] : 0.0f);
+            cycles += (double) juce::jlimit (0.0f, nyquist, hz);
+        }
+
+        setPhase (phase + cycles / sampleRate);
+    }
+
+    /** Writes numSamples of the sine into dest. */
+    void renderBlock (float* dest, int numSamples) noexcept
+    {
+        constexpr auto twoPi = juce::MathConstants<double>::twoPi;
+
+        if (isSilent())
+        {
+            juce::FloatVectorOperations::clear (dest, numSamples);
+            advance (numSamples);
+            return;
+        }
+
+        if (frequencyModulation != nullptr || gainModulation != nullptr)
+        {
+            const auto nyquist = (float) sampleRate * 0.5f;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto hz = frequency.getNextValue() + (frequencyModulation != nullptr ? frequencyModulation[i] : 0.0f);
+                const auto gain = amplitude.getNextValue() * (gainModulation != nullptr ? gainModulation[i] : 1.0f);
+
+                dest[i] = gain * (float) std::sin (twoPi * phase);
+                phase += (double) juce::jlimit (0.0f, nyquist, hz) / sampleRate;
+
+                if (phase >= 1.0)
+                    phase -= 1.0;
+            }
+
+            return;
+        }
+
+        if (! frequency.isSmoothing() && ! amplitude.isSmoothing())
+        {
+            const auto increment = (double) frequency.getTargetValue() / sampleRate;
+            const auto gain = amplitude.getTargetValue();
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                dest[i] = gain * (float) std::sin (twoPi * phase);
+                phase += increment;
+
+                if (phase >= 1.0)
+                    phase -= 1.0;
+            }
+
+            return;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            dest[i] = amplitude.getNextValue() * (float) std::sin (twoPi * phase);
+            phase += (double) frequency.getNextValue() / sampleRate;
+
+            if (phase >= 1.0)
+                phase -= 1.0;
+        }
     }
 
     template <typename ProcessContext>
     void process (const ProcessContext& context)
     {
-        // Clear output first
-        context.getOutputBlock().clear();
-        
-        // Generate oscillator signal (adds to output)
-        oscillator.process (context);
+        auto&& outputBlock = context.getOutputBlock();
+        const auto numSamples = (int) outputBlock.getNumSamples();
+
+        renderBlock (outputBlock.getChannelPointer (0), numSamples);
 
-        // Apply gain
-        gain.process (context);
+        for (size_t channel = 1; channel < outputBlock.getNumChannels(); ++channel)
+            juce::FloatVectorOperations::copy (outputBlock.getChannelPointer (channel),
+                                               outputBlock.getChannelPointer (0), numSamples);
     }
 
 private:
-    juce::dsp::Oscillator<float> oscillator;
-    juce::dsp::Gain<float> gain;
+    juce::SmoothedValue<float> frequency { 440.0f };
+    juce::SmoothedValue<float> amplitude { 1.0f };
+    double phase = 0.0;
     double sampleRate = 44100.0;
-};
 
+    const float* frequencyModulation = nullptr;
+    const float* gainModulation = nullptr;
+};
@@ -0,0 +1,337 @@
+#include "BinauralRenderAPI.h"
+#include "OfflineRenderer.h"
+#include "BatchGenerator.h"
+
+//==============================================================================
+struct binaural_renderer
+{
+    binaural_renderer (double rate, int maximumBlockSize)
+        : sampleRate (rate), blockSize (maximumBlockSize), renderer (formats)
+    {
+        formats.registerBasicFormats();
+        buffer.setSize (2, blockSize);
+
+        // Cannot fail without a bed file
+        renderer.prepare (settings, sampleRate, blockSize);
+    }
+
+    const double sampleRate;
+    const int blockSize;
+
+    juce::AudioFormatManager formats;
+    OfflineRenderer::Settings settings;
+    OfflineRenderer renderer;
+    juce::AudioBuffer<float> buffer;
+};
+
+struct binaural_batch
+{
+    binaural_batch (double sampleRate, int numStreams, int numThreads)
+        : generator (numThreads > 0 ? numThreads : juce::SystemStats::getNumCpus())
+    {
+        generator.prepare (sampleRate, numStreams);
+    }
+
+    BatchGenerator generator;
+};
+
+namespace
+{
+    struct ParameterInfo
+    {
+        float OfflineRenderer::Settings::* floatField;
+        bool OfflineRenderer::Settings::* boolField;
+        float minimum, maximum;
+    };
+
+    // Indexed by binaural_parameter; the ranges are the plugin's
+    const ParameterInfo parameterInfo[] =
+    {
+        { &OfflineRenderer::Settings::baseFrequency,       nullptr, 20.0f, 20000.0f },
+        { &OfflineRenderer::Settings::binauralOffset,      nullptr, 0.0f, 100.0f },
+        { &OfflineRenderer::Settings::leftVolumeDb,        nullptr, -60.0f, 0.0f },
+        { &OfflineRenderer::Settings::rightVolumeDb,       nullptr, -60.0f, 0.0f },
+        { &OfflineRenderer::Settings::masterVolumeDb,      nullptr, -60.0f, 0.0f },
+        { nullptr, &OfflineRenderer::Settings::limiter,             0.0f, 1.0f },
+        { &OfflineRenderer::Settings::limiterCeilingDb,    nullptr, -12.0f, 0.0f },
+        { nullptr, &OfflineRenderer::Settings::spatializer,         0.0f, 1.0f },
+        { &OfflineRenderer::Settings::leftAzimuth,         nullptr, -180.0f, 180.0f },
+        { &OfflineRenderer::Settings::rightAzimuth,        nullptr, -180.0f, 180.0f },
+        { &OfflineRenderer::Settings::backgroundVolumeDb,  nullptr, -60.0f, 0.0f }
+    };
+
+    const ParameterInfo* getParameterInfo (binaural_parameter parameter)
+    {
+        const auto index = (int) parameter;
+        return juce::isPositiveAndBelow (index, (int) std::size (parameterInfo)) ? parameterInfo + index : nullptr;
+    }
+
+    // Renders in block-sized pieces, handing each one to the caller's layout
+    template <typename CopyFunction>
+    binaural_status renderFrames (binaural_renderer* renderer, int64_t numFrames, CopyFunction&& copy)
+    {
+        if (renderer == nullptr || numFrames < 0)
+            return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+        for (int64_t done = 0; done < numFrames;)
+        {
+            const auto numToRender = (int) juce::jmin ((int64_t) renderer->blockSize, numFrames - done);
+            renderer->renderer.render (renderer->buffer, numToRender);
+            copy (renderer->buffer, done, numToRender);
+            done += numToRender;
+        }
+
+        return BINAURAL_OK;
+    }
+}
+
+//==============================================================================
+int binaural_get_api_version (void)
+{
+    return BINAURAL_RENDER_API_VERSION;
+}
+
+const char* binaural_status_string (binaural_status status)
+{
+    switch (status)
+    {
+        case BINAURAL_OK:                       return "ok";
+        case BINAURAL_ERROR_INVALID_ARGUMENT:   return "invalid argument";
+        case BINAURAL_ERROR_FILE:               return "file cannot be read or written";
+        case BINAURAL_ERROR_FORMAT:             return "unsupported file format or bit depth";
+    }
+
+    return "unknown status";
+}
+
+binaural_renderer* binaural_create (double sample_rate, int max_block_size)
+{
+    if (! (sample_rate >= 8000.0 && sample_rate <= 384000.0) || max_block_size < 1)
+        return nullptr;
+
+    return new binaural_renderer (sample_rate, max_block_size);
+}
+
+void binaural_destroy (binaural_renderer* renderer)
+{
+    delete renderer;
+}
+
+//==============================================================================
+binaural_status binaural_set_parameter (binaural_renderer* renderer, binaural_parameter parameter, double value)
+{
+    const auto* info = getParameterInfo (parameter);
+
+    if (renderer == nullptr || info == nullptr || std::isnan (value))
+        return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    auto settings = renderer->settings;
+    const auto clamped = juce::jlimit (info->minimum, info->maximum, (float) value);
+
+    if (info->floatField != nullptr)
+        settings.*(info->floatField) = clamped;
+    else
+        settings.*(info->boolField) = clamped >= 0.5f;
+
+    renderer->settings = settings;
+
+    // A rebuild reopens the bed, which fails if the file has gone since
+    return renderer->renderer.updateSettings (settings) ? BINAURAL_OK : BINAURAL_ERROR_FILE;
+}
+
+binaural_status binaural_get_parameter (binaural_renderer* renderer, binaural_parameter parameter, double* value)
+{
+    const auto* info = getParameterInfo (parameter);
+
+    if (renderer == nullptr || info == nullptr || value == nullptr)
+        return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    *value = info->floatField != nullptr ? (double) (renderer->settings.*(info->floatField))
+                                         : (renderer->settings.*(info->boolField) ? 1.0 : 0.0);
+    return BINAURAL_OK;
+}
+
+binaural_status binaural_set_background_file (binaural_renderer* renderer, const char* path)
+{
+    if (renderer == nullptr)
+        return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    const auto pathString = juce::String::fromUTF8 (path != nullptr ? path : "");
+
+    if (pathString.isNotEmpty() && ! juce::File::isAbsolutePath (pathString))
+        return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    auto settings = renderer->settings;
+    settings.backgroundFile = pathString.isNotEmpty() ? juce::File (pathString) : juce::File();
+
+    if (! renderer->renderer.updateSettings (settings))
+    {
+        // The failed rebuild dropped the old bed as well, so put it back
+        renderer->renderer.updateSettings (renderer->settings);
+        return BINAURAL_ERROR_FILE;
+    }
+
+    renderer->settings = settings;
+    return BINAURAL_OK;
+}
+
+//==============================================================================
+binaural_status binaural_render_interleaved (binaural_renderer* renderer, float* output, int64_t num_frames)
+{
+    if (output == nullptr)
+        return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    return renderFrames (renderer, num_frames, [output] (const juce::AudioBuffer<float>& buffer, int64_t offset, int numFrames)
+    {
+        auto* dest = output + offset * 2;
+        const auto* left = buffer.getReadPointer (0);
+        const auto* right = buffer.getReadPointer (1);
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            dest[2 * i] = left[i];
+            dest[2 * i + 1] = right[i];
+        }
+    });
+}
+
+binaural_status binaural_render_planar (binaural_renderer* renderer, float* left, float* right, int64_t num_frames)
+{
+    if (left == nullptr || right == nullptr)
+        return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    return renderFrames (renderer, num_frames, [left, right] (const juce::AudioBuffer<float>& buffer, int64_t offset, int numFrames)
+    {
+        juce::FloatVectorOperations::copy (left + offset, buffer.getReadPointer (0), numFrames);
+        juce::FloatVectorOperations::copy (right + offset, buffer.getReadPointer (1), numFrames);
+    });
+}
+
+binaural_status binaural_seek (binaural_renderer* renderer, int64_t frame)
+{
+    if (renderer == nullptr || frame < 0)
+        return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    renderer->renderer.seek (frame);
+    return BINAURAL_OK;
+}
+
+int64_t binaural_get_position (binaural_renderer* renderer)
+{
+    return renderer != nullptr ? renderer->renderer.getPosition() : 0;
+}
+
+//==============================================================================
+binaural_status binaural_render_to_file (binaural_renderer* renderer, const char* path,
+                                         double duration_seconds, int bits_per_sample)
+{
+    if (renderer == nullptr || path == nullptr || ! (duration_seconds >= 0.0)
+        || ! juce::File::isAbsolutePath (juce::String::fromUTF8 (path)))
+        return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    const juce::File file (juce::String::fromUTF8 (path));
+    auto* format = renderer->formats.findFormatForFileExtension (file.getFileExtension());
+
+    if (format == nullptr || ! format->canHandleFile (file) || ! format->getPossibleBitDepths().contains (bits_per_sample))
+        return BINAURAL_ERROR_FORMAT;
+
+    // A render of its own, so the streaming position is left alone
+    OfflineRenderer fileRenderer (renderer->formats);
+
+    if (! fileRenderer.prepare (renderer->settings, renderer->sampleRate, renderer->blockSize))
+        return BINAURAL_ERROR_FILE;
+
+    file.deleteFile();
+    auto fileStream = std::make_unique<juce::FileOutputStream> (file);
+
+    if (fileStream->failedToOpen())
+        return BINAURAL_ERROR_FILE;
+
+    std::unique_ptr<juce::OutputStream> stream = std::move (fileStream);
+
+    std::unique_ptr<juce::AudioFormatWriter> writer (
+        format->createWriterFor (stream, juce::AudioFormatWriterOptions{}.withSampleRate (renderer->sampleRate)
+                                                                         .withNumChannels (2)
+                                                                         .withBitsPerSample (bits_per_sample)).release());
+
+    if (writer == nullptr)
+        return BINAURAL_ERROR_FORMAT;
+
+    juce::AudioBuffer<float> buffer (2, renderer->blockSize);
+    const auto totalFrames = (juce::int64) std::llround (renderer->sampleRate * duration_seconds);
+
+    for (juce::int64 done = 0; done < totalFrames;)
+    {
+        const auto numToRender = (int) juce::jmin ((juce::int64) renderer->blockSize, totalFrames - done);
+        fileRenderer.render (buffer, numToRender);
+
+        if (! writer->writeFromAudioSampleBuffer (buffer, 0, numToRender))
+            return BINAURAL_ERROR_FILE;
+
+        done += numToRender;
+    }
+
+    writer.reset();
+    return BINAURAL_OK;
+}
+
+//==============================================================================
+binaural_batch* binaural_batch_create (double sample_rate, int num_streams, int num_threads)
+{
+    if (! (sample_rate >= 8000.0 && sample_rate <= 384000.0) || num_streams < 1)
+        return nullptr;
+
+    return new binaural_batch (sample_rate, num_streams, num_threads);
+}
+
+void binaural_batch_destroy (binaural_batch* batch)
+{
+    delete batch;
+}
+
+int binaural_batch_get_num_streams (binaural_batch* batch)
+{
+    return batch != nullptr ? batch->generator.getNumStreams() : 0;
+}
+
+binaural_status binaural_batch_set_stream (binaural_batch* batch, int stream,
+                                           double base_frequency, double binaural_offset,
+                                           double left_gain, double right_gain)
+{
+    if (batch == nullptr || ! juce::isPositiveAndBelow (stream, batch->generator.getNumStreams())
+        || std::isnan (base_frequency) || std::isnan (binaural_offset) || std::isnan (left_gain) || std::isnan (right_gain))
+        return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    // Same ranges as the renderer's parameters
+    const auto& base = parameterInfo[BINAURAL_PARAM_BASE_FREQUENCY];
+    const auto& offset = parameterInfo[BINAURAL_PARAM_BINAURAL_OFFSET];
+
+    batch->generator.setStream (stream,
+                                juce::jlimit (base.minimum, base.maximum, (float) base_frequency),
+                                juce::jlimit (offset.minimum, offset.maximum, (float) binaural_offset),
+                                juce::jlimit (0.0f, 1.0f, (float) left_gain),
+                                juce::jlimit (0.0f, 1.0f, (float) right_gain));
+    return BINAURAL_OK;
+}
+
+binaural_status binaural_batch_reset (binaural_batch* batch)
+{
+    if (batch == nullptr)
+        return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    batch->generator.reset();
+    return BINAURAL_OK;
+}
+
+binaural_status binaural_batch_render (binaural_batch* batch, float* const* outputs, int num_frames)
+{
+    if (batch == nullptr || outputs == nullptr || num_frames < 0)
+        return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    for (int channel = 0; channel < 2 * batch->generator.getNumStreams(); ++channel)
+        if (outputs[channel] == nullptr)
+            return BINAURAL_ERROR_INVALID_ARGUMENT;
+
+    batch->generator.render (outputs, num_frames);
+    return BINAURAL_OK;
+}
@@ -0,0 +1,138 @@
+#ifndef BINAURAL_RENDER_API_H
+#define BINAURAL_RENDER_API_H
+
+/*
+    C interface to the binaural render core, built as the BinauralRender
+    shared library for services that are not JUCE applications.
+
+    The library has no GUI or message-thread dependencies. Each renderer is
+    independent and may be used from any thread, but not from two threads at
+    once. Strings are UTF-8. The ABI only grows: functions are added, never
+    changed, and BINAURAL_RENDER_API_VERSION is bumped when they are.
+
+    Typical use:
+
+        binaural_renderer* r = binaural_create (48000.0, 1024);
+        binaural_set_parameter (r, BINAURAL_PARAM_BASE_FREQUENCY, 200.0);
+        binaural_set_parameter (r, BINAURAL_PARAM_BINAURAL_OFFSET, 6.0);
+        binaural_render_interleaved (r, buffer, 48000);     // one second
+        binaural_render_to_file (r, "/tmp/theta.wav", 600.0, 24);
+        binaural_destroy (r);
+
+    Servers rendering one stream per listener can use a batch instead, which
+    renders thousands of plain carrier pairs together (see binaural_batch_*).
+*/
+
+#include <stdint.h>
+
+#if defined (_WIN32)
+ #if defined (BINAURAL_RENDER_BUILDING_LIBRARY)
+  #define BINAURAL_RENDER_API __declspec(dllexport)
+ #else
+  #define BINAURAL_RENDER_API __declspec(dllimport)
+ #endif
+#else
+ #define BINAURAL_RENDER_API __attribute__((visibility ("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BINAURAL_RENDER_API_VERSION 2
+
+typedef struct binaural_renderer binaural_renderer;
+
+typedef enum binaural_status
+{
+    BINAURAL_OK = 0,
+    BINAURAL_ERROR_INVALID_ARGUMENT = 1,
+    BINAURAL_ERROR_FILE = 2,        /* bed file unreadable, or output file not writable */
+    BINAURAL_ERROR_FORMAT = 3       /* no writer for the file extension and bit depth */
+} binaural_status;
+
+/* Ranges match the plugin parameters; values outside them are clamped. */
+typedef enum binaural_parameter
+{
+    BINAURAL_PARAM_BASE_FREQUENCY = 0,        /* Hz, 20 - 20000 */
+    BINAURAL_PARAM_BINAURAL_OFFSET = 1,       /* Hz, 0 - 100: right carrier minus left */
+    BINAURAL_PARAM_LEFT_VOLUME_DB = 2,        /* -60 - 0 */
+    BINAURAL_PARAM_RIGHT_VOLUME_DB = 3,       /* -60 - 0 */
+    BINAURAL_PARAM_MASTER_VOLUME_DB = 4,      /* -60 - 0 */
+    BINAURAL_PARAM_LIMITER = 5,               /* 0 or 1 */
+    BINAURAL_PARAM_LIMITER_CEILING_DB = 6,    /* -12 - 0 */
+    BINAURAL_PARAM_SPATIALIZER = 7,           /* 0 or 1 */
+    BINAURAL_PARAM_LEFT_AZIMUTH = 8,          /* degrees, -180 - 180 */
+    BINAURAL_PARAM_RIGHT_AZIMUTH = 9,         /* degrees, -180 - 180 */
+    BINAURAL_PARAM_BACKGROUND_VOLUME_DB = 10  /* -60 - 0 */
+} binaural_parameter;
+
+BINAURAL_RENDER_API int binaural_get_api_version (void);
+BINAURAL_RENDER_API const char* binaural_status_string (binaural_status status);
+
+/* Returns NULL for a sample rate outside 8 - 384 kHz or a block size below 1.
+   The block size only bounds the internal chunks; renders may be any length. */
+BINAURAL_RENDER_API binaural_renderer* binaural_create (double sample_rate, int max_block_size);
+BINAURAL_RENDER_API void binaural_destroy (binaural_renderer* renderer);
+
+/* Frequencies and gains glide from the next rendered frame; switching the
+   spatializer or moving its azimuths restarts the chain at the current frame. */
+BINAURAL_RENDER_API binaural_status binaural_set_parameter (binaural_renderer* renderer,
+                                                            binaural_parameter parameter, double value);
+BINAURAL_RENDER_API binaural_status binaural_get_parameter (binaural_renderer* renderer,
+                                                            binaural_parameter parameter, double* value);
+
+/* Loops an audio file under the carriers; NULL or "" removes it. */
+BINAURAL_RENDER_API binaural_status binaural_set_background_file (binaural_renderer* renderer, const char* path);
+
+/* Render the next num_frames stereo frames, either interleaved (L R L R...,
+   2 * num_frames floats) or into two separate channel buffers. */
+BINAURAL_RENDER_API binaural_status binaural_render_interleaved (binaural_renderer* renderer,
+                                                                 float* output, int64_t num_frames);
+BINAURAL_RENDER_API binaural_status binaural_render_planar (binaural_renderer* renderer,
+                                                            float* left, float* right, int64_t num_frames);
+
+/* Continues rendering from another frame, as if that many frames had been
+   rendered. The limiter and spatializer start from rest. */
+BINAURAL_RENDER_API binaural_status binaural_seek (binaural_renderer* renderer, int64_t frame);
+BINAURAL_RENDER_API int64_t binaural_get_position (binaural_renderer* renderer);
+
+/* Renders duration_seconds from frame 0 with the current parameters to a
+   file whose format follows its extension (.wav, .aiff, .flac, .ogg).
+   Independent of the streaming position. */
+BINAURAL_RENDER_API binaural_status binaural_render_to_file (binaural_renderer* renderer, const char* path,
+                                                             double duration_seconds, int bits_per_sample);
+
+/* Batches (API version 2): many independent streams rendered together, each
+   just a pair of carriers with a gain per ear, with no limiter, bed or
+   spatializer. Like renderers, a batch may be used from any thread but not
+   from two at once; rendering spreads the streams over the batch's own
+   worker threads and returns when they are done. */
+typedef struct binaural_batch binaural_batch;
+
+/* Returns NULL for a sample rate outside 8 - 384 kHz or a stream count
+   below 1. num_threads below 1 uses one per CPU. Streams start silent. */
+BINAURAL_RENDER_API binaural_batch* binaural_batch_create (double sample_rate, int num_streams, int num_threads);
+BINAURAL_RENDER_API void binaural_batch_destroy (binaural_batch* batch);
+BINAURAL_RENDER_API int binaural_batch_get_num_streams (binaural_batch* batch);
+
+/* Retunes a stream from the next frame, without a glide and keeping its
+   phase. Frequencies are clamped to the renderer's ranges, gains (linear)
+   to 0 - 1. */
+BINAURAL_RENDER_API binaural_status binaural_batch_set_stream (binaural_batch* batch, int stream,
+                                                               double base_frequency, double binaural_offset,
+                                                               double left_gain, double right_gain);
+
+/* Restarts every stream at phase zero. */
+BINAURAL_RENDER_API binaural_status binaural_batch_reset (binaural_batch* batch);
+
+/* Writes the next num_frames of every stream into 2 * num_streams channel
+   buffers: outputs[2 * s] is stream s's left ear, outputs[2 * s + 1] its right. */
+BINAURAL_RENDER_API binaural_status binaural_batch_render (binaural_batch* batch, float* const* outputs,
+                                                           int num_frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
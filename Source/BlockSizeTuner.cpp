@@ -0,0 +1,156 @@
+#include "BlockSizeTuner.h"
+
+namespace
+{
+    constexpr int candidateSizes[] = { 128, 256, 512, 1024, 2048, 4096, 8192 };
+
+    // Long enough to get past timer noise, short enough to go unnoticed before the first export
+    constexpr double calibrationSeconds = 2.0;
+    constexpr int calibrationRounds = 3;
+
+    double timeRender (juce::AudioFormatManager& formats, const OfflineRenderer::Settings& settings,
+                       double sampleRate, int blockSize)
+    {
+        OfflineRenderer renderer (formats);
+
+        if (! renderer.prepare (settings, sampleRate, blockSize))
+            return std::numeric_limits<double>::max();
+
+        // Encode as the export does, so the writer's per-call cost is part of the measurement
+        std::unique_ptr<juce::OutputStream> stream = std::make_unique<juce::MemoryOutputStream>();
+        juce::WavAudioFormat wavFormat;
+        std::unique_ptr<juce::AudioFormatWriter> writer (
+            wavFormat.createWriterFor (stream, juce::AudioFormatWriterOptions{}.withSampleRate (sampleRate)
+                                                                                .withNumChannels (2)
+                                                                                .withBitsPerSample (24)).release());
+
+        if (writer == nullptr)
+            return std::numeric_limits<double>::max();
+
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        const auto numSamples = (int) (sampleRate * calibrationSeconds);
+
+        // First block outside the timing: it includes the latency pre-roll
+        renderer.render (buffer, blockSize);
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int position = 0; position < numSamples; position += blockSize)
+        {
+            const auto numToRender = juce::jmin (blockSize, numSamples - position);
+            renderer.render (buffer, numToRender);
+            writer->writeFromAudioSampleBuffer (buffer, 0, numToRender);
+        }
+
+        return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+    }
+}
+
+//==============================================================================
+BlockSizeTuner::BlockSizeTuner (const juce::File& profileFile)
+    : profile (profileFile)
+{
+    setOverride (juce::SystemStats::getEnvironmentVariable ("BINAURAL_EXPORT_BLOCK_SIZE", {}).getIntValue());
+}
+
+void BlockSizeTuner::setOverride (int blockSize) noexcept
+{
+    overrideSize = blockSize > 0 ? sanitise (blockSize) : 0;
+}
+
+int BlockSizeTuner::sanitise (int blockSize) noexcept
+{
+    return juce::nextPowerOfTwo (juce::jlimit (minimumBlockSize, maximumBlockSize, blockSize));
+}
+
+int BlockSizeTuner::getBlockSize (juce::AudioFormatManager& formats, const OfflineRenderer::Settings& settings,
+                                  double sampleRate)
+{
+    if (overrideSize > 0)
+        return overrideSize;
+
+    const juce::ScopedLock sl (lock);
+
+    if (const auto storedSize = getStoredBlockSize (settings, sampleRate))
+        return *storedSize;
+
+    const auto hostId = getHostId();
+    const auto key = getConfigurationKey (settings, sampleRate);
+    auto stored = juce::JSON::parse (profile);
+    const auto blockSize = calibrate (formats, settings, sampleRate);
+
+    // Rewrite the whole profile: other hosts may share it through a network home directory
+    if (stored.getDynamicObject() == nullptr)
+        stored = juce::var (new juce::DynamicObject());
+
+    if (stored[juce::Identifier (hostId)].getDynamicObject() == nullptr)
+        stored.getDynamicObject()->setProperty (hostId, juce::var (new juce::DynamicObject()));
+
+    stored[juce::Identifier (hostId)].getDynamicObject()->setProperty (key, blockSize);
+
+    profile.getParentDirectory().createDirectory();
+    profile.replaceWithText (juce::JSON::toString (stored));
+    return blockSize;
+}
+
+std::optional<int> BlockSizeTuner::getStoredBlockSize (const OfflineRenderer::Settings& settings, double sampleRate)
+{
+    if (overrideSize > 0)
+        return overrideSize;
+
+    const juce::ScopedLock sl (lock);
+    const auto stored = juce::JSON::parse (profile);
+
+    if (auto* hostEntry = stored[juce::Identifier (getHostId())].getDynamicObject())
+    {
+        const auto key = getConfigurationKey (settings, sampleRate);
+
+        if (hostEntry->hasProperty (key))
+            return sanitise ((int) hostEntry->getProperty (key));
+    }
+
+    return std::nullopt;
+}
+
+int BlockSizeTuner::calibrate (juce::AudioFormatManager& formats, const OfflineRenderer::Settings& settings,
+                               double sampleRate)
+{
+    std::vector<double> fastest (std::size (candidateSizes), std::numeric_limits<double>::max());
+
+    // Interleaved rounds, keeping each size's best time, so a burst of
+    // background load does not count against whichever size it landed on
+    for (int round = 0; round < calibrationRounds; ++round)
+        for (size_t i = 0; i < fastest.size(); ++i)
+            fastest[i] = juce::jmin (fastest[i], timeRender (formats, settings, sampleRate, candidateSizes[i]));
+
+    const auto best = std::min_element (fastest.begin(), fastest.end()) - fastest.begin();
+    return candidateSizes[best];
+}
+
+void BlockSizeTuner::clearProfile()
+{
+    const juce::ScopedLock sl (lock);
+    auto stored = juce::JSON::parse (profile);
+
+    if (auto* object = stored.getDynamicObject())
+    {
+        object->removeProperty (getHostId());
+        profile.replaceWithText (juce::JSON::toString (stored));
+    }
+}
+
+//==============================================================================
+juce::String BlockSizeTuner::getHostId()
+{
+    return juce::SystemStats::getComputerName() + " / " + juce::SystemStats::getCpuModel()
+           + " / " + juce::String (juce::SystemStats::getNumPhysicalCpus()) + " cores";
+}
+
+juce::String BlockSizeTuner::getConfigurationKey (const OfflineRenderer::Settings& settings, double sampleRate)
+{
+    // Only what changes the per-sample work; the frequencies and gains do not
+    return juce::String (juce::roundToInt (sampleRate))
+           + (settings.limiter ? " limiter" : "")
+           + (settings.spatializer ? " spatializer" : "")
+           + (settings.backgroundFile != juce::File() ? " bed" : "");
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "OfflineRenderer.h"
+#include <optional>
+
+//==============================================================================
+/**
+    Picks the render block size for offline exports.
+
+    Small blocks pay the per-call overhead of the chain and the writer more
+    often; large ones push the working buffers out of the L1/L2 caches. The
+    best size depends on the machine and on which stages are active, so it
+    is measured: a short calibration renders and encodes a couple of seconds
+    at each candidate size and keeps the fastest. Results are kept in a
+    profile file, per host and per chain configuration, so each machine
+    calibrates once.
+
+    setOverride() (or the BINAURAL_EXPORT_BLOCK_SIZE environment variable)
+    skips all of this. The chain's output does not depend on the block size,
+    so any choice renders the same file.
+*/
+class BlockSizeTuner
+{
+public:
+    static constexpr int minimumBlockSize = 64;
+    static constexpr int maximumBlockSize = 16384;
+
+    explicit BlockSizeTuner (const juce::File& profileFile);
+
+    /** A fixed block size for every export, or 0 to tune. Clamped and rounded to a power of two. */
+    void setOverride (int blockSize) noexcept;
+    int getOverride() const noexcept  { return overrideSize; }
+
+    /** The override, else the profile entry for this configuration, else a
+        fresh calibration that is then stored in the profile.
+    */
+    int getBlockSize (juce::AudioFormatManager& formats, const OfflineRenderer::Settings& settings,
+                      double sampleRate);
+
+    /** The override or the profile entry for this configuration, without
+        ever calibrating; nullopt when neither exists.
+    */
+    std::optional<int> getStoredBlockSize (const OfflineRenderer::Settings& settings, double sampleRate);
+
+    /** Times each candidate size and returns the fastest. Does not touch the profile. */
+    static int calibrate (juce::AudioFormatManager& formats, const OfflineRenderer::Settings& settings,
+                          double sampleRate);
+
+    /** Forgets this host's measurements so the next export calibrates again. */
+    void clearProfile();
+
+    const juce::File& getProfileFile() const noexcept  { return profile; }
+
+private:
+    static juce::String getHostId();
+    static juce::String getConfigurationKey (const OfflineRenderer::Settings& settings, double sampleRate);
+    static int sanitise (int blockSize) noexcept;
+
+    juce::File profile;
+    juce::CriticalSection lock;
+    int overrideSize = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockSizeTuner)
+};
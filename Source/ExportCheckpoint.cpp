@@ -0,0 +1,124 @@
+#include "ExportCheckpoint.h"
+
+namespace
+{
+    constexpr int checkpointMagic = 0x4b434742; // "BGCK"
+    constexpr int checkpointVersion = 2;
+
+    void writeBlock (juce::OutputStream& stream, const juce::MemoryBlock& block)
+    {
+        stream.writeInt64 ((juce::int64) block.getSize());
+        stream.write (block.getData(), block.getSize());
+    }
+
+    bool readBlock (juce::InputStream& stream, juce::MemoryBlock& block)
+    {
+        const auto size = stream.readInt64();
+
+        if (size < 0 || size > stream.getNumBytesRemaining())
+            return false;
+
+        block.setSize ((size_t) size);
+        return stream.read (block.getData(), (int) size) == (int) size;
+    }
+}
+
+//==============================================================================
+juce::File ExportCheckpoint::getFileFor (const juce::File& exportFile)
+{
+    return exportFile.getSiblingFile (exportFile.getFileName() + ".checkpoint");
+}
+
+bool ExportCheckpoint::save (const juce::File& checkpointFile) const
+{
+    juce::MemoryOutputStream stream;
+    stream.writeInt (checkpointMagic);
+    stream.writeInt (checkpointVersion);
+    stream.writeString (renderKey);
+    stream.writeInt64 (samplesWritten);
+    stream.writeInt64 (dataStart);
+    stream.writeInt64 (byteOffset);
+    stream.writeFloat (masterTrimDb);
+    stream.writeInt (blockSize);
+    writeBlock (stream, rendererState);
+    writeBlock (stream, meterState);
+
+    return checkpointFile.replaceWithData (stream.getData(), stream.getDataSize());
+}
+
+bool ExportCheckpoint::load (const juce::File& checkpointFile)
+{
+    juce::MemoryBlock data;
+
+    if (! checkpointFile.loadFileAsData (data))
+        return false;
+
+    juce::MemoryInputStream stream (data, false);
+
+    if (stream.readInt() != checkpointMagic || stream.readInt() != checkpointVersion)
+        return false;
+
+    renderKey = stream.readString();
+    samplesWritten = stream.readInt64();
+    dataStart = stream.readInt64();
+    byteOffset = stream.readInt64();
+    masterTrimDb = stream.readFloat();
+    blockSize = stream.readInt();
+
+    return readBlock (stream, rendererState) && readBlock (stream, meterState)
+        && samplesWritten >= 0 && dataStart >= 0 && byteOffset >= dataStart && blockSize > 0;
+}
+
+//==============================================================================
+ResumingOutputStream::ResumingOutputStream (std::unique_ptr<juce::OutputStream> targetStream,
+                                            juce::int64 skipStartByte, juce::int64 skipEndByte)
+    : target (std::move (targetStream)),
+      skipStart (skipStartByte),
+      skipEnd (juce::jmax (skipStartByte, skipEndByte))
+{
+    target->setPosition (0);
+}
+
+void ResumingOutputStream::flush()
+{
+    target->flush();
+}
+
+bool ResumingOutputStream::setPosition (juce::int64 newPosition)
+{
+    position = newPosition;
+    return true;
+}
+
+bool ResumingOutputStream::write (const void* data, size_t numBytes)
+{
+    auto* bytes = static_cast<const char*> (data);
+    auto remaining = (juce::int64) numBytes;
+
+    while (remaining > 0)
+    {
+        // Already on disk from the interrupted run
+        if (position >= skipStart && position < skipEnd)
+        {
+            const auto skipped = juce::jmin (remaining, skipEnd - position);
+            position += skipped;
+            bytes += skipped;
+            remaining -= skipped;
+            continue;
+        }
+
+        const auto count = position < skipStart ? juce::jmin (remaining, skipStart - position) : remaining;
+
+        if (target->getPosition() != position && ! target->setPosition (position))
+            return false;
+
+        if (! target->write (bytes, (size_t) count))
+            return false;
+
+        position += count;
+        bytes += count;
+        remaining -= count;
+    }
+
+    return true;
+}
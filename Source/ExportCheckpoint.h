@@ -0,0 +1,70 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+    Progress record of a long export, kept next to the file being written
+    ("<file>.checkpoint") so an interrupted export can continue.
+
+    It ties the partial file to its render spec and stores how far the file
+    got (samples, and the byte range of audio data already on disk), plus
+    the render chain and loudness meter state at that point. Checkpoints are
+    only taken on block boundaries, so the resumed render sees the same
+    block sequence and the finished file is bit-identical to an
+    uninterrupted one.
+*/
+struct ExportCheckpoint
+{
+    juce::String renderKey;
+    juce::int64 samplesWritten = 0;
+
+    // Audio data occupies [dataStart, byteOffset) of the partial file
+    juce::int64 dataStart = 0;
+    juce::int64 byteOffset = 0;
+
+    float masterTrimDb = 0.0f;
+
+    // Render block size of the interrupted run, kept so the resumed one uses the same
+    int blockSize = 0;
+
+    juce::MemoryBlock rendererState;
+    juce::MemoryBlock meterState;
+
+    static juce::File getFileFor (const juce::File& exportFile);
+
+    /** Replaces the checkpoint file in one step, so a crash never leaves half of one. */
+    bool save (const juce::File& checkpointFile) const;
+
+    /** Returns false if the file is missing, truncated or of another version. */
+    bool load (const juce::File& checkpointFile);
+};
+
+//==============================================================================
+/**
+    File stream for resumed exports.
+
+    The writer is run again from the start of the file, but the bytes in
+    [skipStart, skipEnd) — the audio already on disk — are dropped instead
+    of written, so only the header and the new audio reach the file. Feeding
+    the writer silence for the skipped part keeps its own sample and byte
+    counts right, and with them the header it writes when it closes.
+*/
+class ResumingOutputStream : public juce::OutputStream
+{
+public:
+    ResumingOutputStream (std::unique_ptr<juce::OutputStream> targetStream,
+                          juce::int64 skipStart, juce::int64 skipEnd);
+
+    void flush() override;
+    bool setPosition (juce::int64 newPosition) override;
+    juce::int64 getPosition() override  { return position; }
+    bool write (const void* data, size_t numBytes) override;
+
+private:
+    std::unique_ptr<juce::OutputStream> target;
+    juce::int64 skipStart = 0, skipEnd = 0;
+    juce::int64 position = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResumingOutputStream)
+};
@@ -0,0 +1,400 @@
+#include "ExportPreview.h"
+
+namespace
+{
+    constexpr int renderBlockSize = 4096;
+
+    // Output before this is left out of the steady-state measurement: the
+    // limiter is still settling on the carriers there
+    constexpr int settleSamples = 4096;
+
+    bool sameSettings (const OfflineRenderer::Settings& a, const OfflineRenderer::Settings& b)
+    {
+        return a.baseFrequency == b.baseFrequency
+            && a.binauralOffset == b.binauralOffset
+            && a.leftVolumeDb == b.leftVolumeDb
+            && a.rightVolumeDb == b.rightVolumeDb
+            && a.masterVolumeDb == b.masterVolumeDb
+            && a.masterTrimDb == b.masterTrimDb
+            && a.limiter == b.limiter
+            && a.limiterCeilingDb == b.limiterCeilingDb
+            && a.limiterLookAhead == b.limiterLookAhead
+            && a.spatializer == b.spatializer
+            && a.leftAzimuth == b.leftAzimuth
+            && a.rightAzimuth == b.rightAzimuth
+            && a.spatializerLatency == b.spatializerLatency
+            && a.backgroundFile == b.backgroundFile
+            && a.backgroundVolumeDb == b.backgroundVolumeDb
+            && a.modulation == b.modulation;
+    }
+}
+
+//==============================================================================
+bool ExportPreview::Plan::operator== (const Plan& other) const
+{
+    return sampleRate == other.sampleRate
+        && durationSeconds == other.durationSeconds
+        && seamlessLoop == other.seamlessLoop
+        && sameSettings (settings, other.settings);
+}
+
+//==============================================================================
+ExportPreview::ExportPreview()
+    : Thread ("ExportPreview")
+{
+    formatManager.registerBasicFormats();
+}
+
+ExportPreview::~ExportPreview()
+{
+    signalThreadShouldExit();
+    workAvailable.signal();
+    stopThread (4000);
+}
+
+void ExportPreview::setPlan (const Plan& newPlan)
+{
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (generation > 0 && newPlan == plan)
+            return;
+
+        plan = newPlan;
+        ++generation;
+        lengthSamples = 0;
+        numLevels = 1;
+        tiles.clear();
+        wanted.clear();
+    }
+
+    if (! isThreadRunning())
+        startThread (juce::Thread::Priority::low);
+
+    workAvailable.signal();
+    sendChangeMessage();
+}
+
+juce::int64 ExportPreview::getLengthSamples() const
+{
+    const juce::ScopedLock sl (lock);
+    return lengthSamples;
+}
+
+//==============================================================================
+juce::int64 ExportPreview::getBucketSize (int level) const noexcept
+{
+    auto size = (juce::int64) finestBucketSize;
+
+    for (int i = 0; i < level; ++i)
+        size *= levelRatio;
+
+    return size;
+}
+
+int ExportPreview::getLevelFor (double samplesPerColumn) const noexcept
+{
+    int level = 0;
+
+    while (level + 1 < numLevels && (double) getBucketSize (level + 1) <= samplesPerColumn)
+        ++level;
+
+    return level;
+}
+
+const ExportPreview::Bucket* ExportPreview::findBucket (int level, juce::int64 bucketIndex) const
+{
+    const auto tile = tiles.find ({ level, bucketIndex / tileBuckets });
+
+    if (tile == tiles.end())
+        return nullptr;
+
+    const auto index = (size_t) (bucketIndex % tileBuckets);
+    return index < tile->second.buckets.size() ? &tile->second.buckets[index] : nullptr;
+}
+
+bool ExportPreview::getColumns (juce::int64 startSample, juce::int64 endSample, std::vector<Column>& columns)
+{
+    const juce::ScopedLock sl (lock);
+
+    startSample = juce::jlimit ((juce::int64) 0, lengthSamples, startSample);
+    endSample = juce::jlimit (startSample, lengthSamples, endSample);
+
+    const auto numColumns = (juce::int64) columns.size();
+
+    if (numColumns == 0 || endSample <= startSample)
+    {
+        std::fill (columns.begin(), columns.end(), Column());
+        return false;
+    }
+
+    const auto level = getLevelFor ((double) (endSample - startSample) / (double) numColumns);
+    const auto bucketSize = getBucketSize (level);
+    const auto lastBucket = (lengthSamples - 1) / bucketSize;
+
+    std::vector<TileKey> missing;
+    bool allExact = true;
+
+    for (juce::int64 i = 0; i < numColumns; ++i)
+    {
+        const auto columnStart = startSample + (endSample - startSample) * i / numColumns;
+        const auto columnEnd = startSample + (endSample - startSample) * (i + 1) / numColumns;
+
+        const auto firstBucket = columnStart / bucketSize;
+        const auto endBucket = juce::jlimit (firstBucket + 1, lastBucket + 1, (columnEnd + bucketSize - 1) / bucketSize);
+
+        Column column;
+        column.exact = true;
+        std::array<double, 2> sumOfSquares {};
+        int numMerged = 0;
+
+        for (auto b = firstBucket; b < endBucket; ++b)
+        {
+            auto* bucket = findBucket (level, b);
+
+            if (bucket == nullptr)
+            {
+                const TileKey key { level, b / tileBuckets };
+
+                if (std::find (missing.begin(), missing.end(), key) == missing.end())
+                    missing.push_back (key);
+
+                // Meanwhile, the bucket above it that is ready
+                for (int coarser = level + 1; coarser < numLevels && bucket == nullptr; ++coarser)
+                    bucket = findBucket (coarser, b * bucketSize / getBucketSize (coarser));
+
+                column.exact = false;
+
+                if (bucket == nullptr)
+                    continue;
+            }
+
+            for (size_t channel = 0; channel < 2; ++channel)
+            {
+                auto& range = column.channels[channel];
+                const auto& other = bucket->channels[channel];
+
+                range.minimum = numMerged == 0 ? other.minimum : juce::jmin (range.minimum, other.minimum);
+                range.maximum = numMerged == 0 ? other.maximum : juce::jmax (range.maximum, other.maximum);
+                sumOfSquares[channel] += (double) other.rms * (double) other.rms;
+            }
+
+            column.exact = column.exact && bucket->exact;
+            ++numMerged;
+        }
+
+        for (size_t channel = 0; channel < 2 && numMerged > 0; ++channel)
+            column.channels[channel].rms = (float) std::sqrt (sumOfSquares[channel] / numMerged);
+
+        column.exact = column.exact && numMerged > 0;
+        allExact = allExact && column.exact;
+        columns[(size_t) i] = column;
+    }
+
+    // Only the latest view matters: anything it no longer shows is dropped
+    if (! missing.empty())
+    {
+        wanted = std::move (missing);
+        workAvailable.signal();
+    }
+
+    return allExact;
+}
+
+//==============================================================================
+void ExportPreview::run()
+{
+    while (! threadShouldExit())
+    {
+        TileKey key;
+        bool haveWork = false;
+        int tileGeneration;
+
+        {
+            const juce::ScopedLock sl (lock);
+            tileGeneration = generation;
+
+            // The top tile spans the whole export and backs every other level
+            const TileKey top { numLevels - 1, 0 };
+
+            if (tiles.count (top) == 0)
+            {
+                key = top;
+                haveWork = true;
+            }
+
+            while (! haveWork && ! wanted.empty())
+            {
+                key = wanted.front();
+                wanted.erase (wanted.begin());
+                haveWork = tiles.count (key) == 0;
+            }
+        }
+
+        if (tileGeneration != renderGeneration)
+        {
+            startPlan (tileGeneration);
+            continue;
+        }
+
+        if (! haveWork)
+        {
+            workAvailable.wait (-1);
+            continue;
+        }
+
+        Tile tile;
+
+        if (! computeTile (key, tileGeneration, tile))
+            continue;
+
+        {
+            const juce::ScopedLock sl (lock);
+
+            if (generation != tileGeneration)
+                continue;
+
+            tiles[key] = std::move (tile);
+        }
+
+        sendChangeMessage();
+    }
+}
+
+void ExportPreview::startPlan (int planGeneration)
+{
+    Plan newPlan;
+
+    {
+        const juce::ScopedLock sl (lock);
+        newPlan = plan;
+    }
+
+    // Same length and carriers as exportAudio() would use
+    auto& settings = newPlan.settings;
+    renderLength = (juce::int64) (newPlan.sampleRate * newPlan.durationSeconds);
+
+    if (newPlan.seamlessLoop)
+    {
+        const auto loopPlan = OfflineRenderer::planLoop (settings, newPlan.sampleRate, newPlan.durationSeconds);
+        settings.baseFrequency = loopPlan.leftFrequency;
+        settings.binauralOffset = loopPlan.rightFrequency - loopPlan.leftFrequency;
+        renderLength = loopPlan.lengthSamples;
+    }
+
+    renderer = std::make_unique<OfflineRenderer> (formatManager);
+    renderBuffer.setSize (2, renderBlockSize);
+
+    if (! renderer->prepare (settings, newPlan.sampleRate, renderBlockSize))
+        renderer.reset();
+
+    // The carriers alone make a steady sine on each channel; a bed, modulation
+    // or the spatializer (which mixes both carriers into each ear) do not
+    const auto lowestHz = juce::jmin (settings.baseFrequency, settings.baseFrequency + settings.binauralOffset);
+
+    analytic = renderer != nullptr && settings.backgroundFile == juce::File() && ! settings.spatializer
+               && ! ModulationEngine::isActive (settings.modulation) && lowestHz >= 1.0f;
+
+    if (analytic)
+    {
+        periodSamples = (juce::int64) std::ceil (newPlan.sampleRate / lowestHz);
+        steadyState = measure (settleSamples, (int) juce::jmax ((juce::int64) probeLength, 4 * periodSamples));
+    }
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (generation == planGeneration)
+        {
+            lengthSamples = renderLength;
+
+            while (getBucketSize (numLevels - 1) * tileBuckets < lengthSamples)
+                ++numLevels;
+        }
+    }
+
+    // A newer plan arrived meanwhile: the next pass starts again
+    renderGeneration = planGeneration;
+    sendChangeMessage();
+}
+
+bool ExportPreview::computeTile (const TileKey& key, int tileGeneration, Tile& tile)
+{
+    const auto bucketSize = getBucketSize (key.first);
+    const auto firstBucket = key.second * tileBuckets;
+    const auto tileStart = firstBucket * bucketSize;
+    const auto tileLength = juce::jmin (bucketSize * tileBuckets, renderLength - tileStart);
+
+    if (tileLength <= 0)
+        return true;
+
+    tile.buckets.resize ((size_t) ((tileLength + bucketSize - 1) / bucketSize));
+
+    for (size_t i = 0; i < tile.buckets.size(); ++i)
+    {
+        if (threadShouldExit() || generation != tileGeneration)
+            return false;
+
+        const auto start = tileStart + (juce::int64) i * bucketSize;
+        const auto length = (int) juce::jmin (bucketSize, renderLength - start);
+
+        if (analytic && length >= periodSamples)
+        {
+            tile.buckets[i] = steadyState;
+        }
+        else if (bucketSize * tileBuckets <= maxExactSpan)
+        {
+            // Consecutive buckets carry on from each other: one seek per tile
+            tile.buckets[i] = measure (start, length);
+        }
+        else
+        {
+            const auto probe = juce::jmin (probeLength, length);
+            tile.buckets[i] = measure (start + (length - probe) / 2, probe);
+            tile.buckets[i].exact = false;
+        }
+    }
+
+    return true;
+}
+
+ExportPreview::Bucket ExportPreview::measure (juce::int64 startSample, int numSamples)
+{
+    Bucket bucket;
+    bucket.exact = true;
+
+    // A bed that cannot be opened fails the export too; show silence
+    if (renderer == nullptr)
+        return bucket;
+
+    if (renderer->getPosition() != startSample)
+        renderer->seek (startSample);
+
+    std::array<double, 2> sumOfSquares {};
+
+    for (int done = 0; done < numSamples;)
+    {
+        const auto numToRender = juce::jmin (renderBlockSize, numSamples - done);
+        renderer->render (renderBuffer, numToRender);
+
+        for (size_t channel = 0; channel < 2; ++channel)
+        {
+            const auto* data = renderBuffer.getReadPointer ((int) channel);
+            const auto range = juce::FloatVectorOperations::findMinAndMax (data, numToRender);
+            auto& result = bucket.channels[channel];
+
+            result.minimum = done == 0 ? range.getStart() : juce::jmin (result.minimum, range.getStart());
+            result.maximum = done == 0 ? range.getEnd() : juce::jmax (result.maximum, range.getEnd());
+
+            for (int i = 0; i < numToRender; ++i)
+                sumOfSquares[channel] += (double) data[i] * (double) data[i];
+        }
+
+        done += numToRender;
+    }
+
+    for (size_t channel = 0; channel < 2; ++channel)
+        bucket.channels[channel].rms = (float) std::sqrt (sumOfSquares[channel] / juce::jmax (1, numSamples));
+
+    return bucket;
+}
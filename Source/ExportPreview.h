@@ -0,0 +1,135 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_events/juce_events.h>
+#include "OfflineRenderer.h"
+
+#include <map>
+
+//==============================================================================
+/**
+    Overview of a planned export, built without rendering the whole file.
+
+    The overview is a pyramid of min/max/RMS buckets: level 0 holds
+    finestBucketSize samples per bucket and each level above holds
+    levelRatio times more, up to one tile that spans the whole export.
+    Tiles of tileBuckets buckets are computed lazily on a background thread,
+    the ones the view last asked for first, and sendChangeMessage() reports
+    each one that lands.
+
+    A tile is computed the cheapest way that is still right:
+      - analytically, when the export is the two carriers alone: each
+        channel is then a steady sine, measured once at the start, so any
+        bucket at least one carrier period long has a known range and RMS;
+      - by rendering the tile's span outright (via OfflineRenderer::seek, at
+        the exact carrier phase) when it is at most maxExactSpan samples;
+      - otherwise from one probeLength window per bucket, also at the exact
+        phase, marked as an estimate until the view zooms in far enough for
+        an exact level.
+
+    The overview shows the render before any loudness target trim, and a
+    seamless loop without the crossfade at its end.
+*/
+class ExportPreview  : public juce::ChangeBroadcaster,
+                       private juce::Thread
+{
+public:
+    /** What exportAudio() would be asked for. */
+    struct Plan
+    {
+        OfflineRenderer::Settings settings;
+        double sampleRate = 44100.0;
+        double durationSeconds = 0.0;
+        bool seamlessLoop = false;
+
+        bool operator== (const Plan& other) const;
+        bool operator!= (const Plan& other) const  { return ! operator== (other); }
+    };
+
+    struct Range
+    {
+        float minimum = 0.0f;
+        float maximum = 0.0f;
+        float rms = 0.0f;
+    };
+
+    struct Column
+    {
+        std::array<Range, 2> channels;
+
+        // False while the column comes from probe windows or a coarser level
+        bool exact = false;
+    };
+
+    ExportPreview();
+    ~ExportPreview() override;
+
+    /** Starts over for another export, unless it is the same one. Working
+        out the length (a seamless loop searches for it) and everything
+        after happen on the preview thread.
+    */
+    void setPlan (const Plan& newPlan);
+
+    /** Length of the planned file; 0 until the preview thread has worked it out. */
+    juce::int64 getLengthSamples() const;
+
+    /** Splits [startSample, endSample) into columns.size() equal spans and
+        fills them from the best level computed so far. Tiles still missing
+        at the level that matches the span are queued, replacing the last
+        request. Returns true when every column is exact.
+    */
+    bool getColumns (juce::int64 startSample, juce::int64 endSample, std::vector<Column>& columns);
+
+    static constexpr int finestBucketSize = 16;
+    static constexpr int levelRatio = 4;
+    static constexpr int tileBuckets = 256;
+    static constexpr int maxExactSpan = 1 << 20;
+    static constexpr int probeLength = 4096;
+
+private:
+    struct Bucket
+    {
+        std::array<Range, 2> channels;
+        bool exact = false;
+    };
+
+    struct Tile
+    {
+        std::vector<Bucket> buckets;
+    };
+
+    // Level and tile index
+    using TileKey = std::pair<int, juce::int64>;
+
+    void run() override;
+    void startPlan (int planGeneration);
+    bool computeTile (const TileKey& key, int tileGeneration, Tile& tile);
+    Bucket measure (juce::int64 startSample, int numSamples);
+
+    juce::int64 getBucketSize (int level) const noexcept;
+    int getLevelFor (double samplesPerColumn) const noexcept;
+    const Bucket* findBucket (int level, juce::int64 bucketIndex) const;
+
+    juce::AudioFormatManager formatManager;
+
+    // Guards plan, lengthSamples, numLevels, tiles and wanted
+    mutable juce::CriticalSection lock;
+    Plan plan;
+    juce::int64 lengthSamples = 0;
+    int numLevels = 1;
+    std::map<TileKey, Tile> tiles;
+    std::vector<TileKey> wanted;
+    std::atomic<int> generation { 0 };
+    juce::WaitableEvent workAvailable;
+
+    // Preview thread only
+    juce::int64 renderLength = 0;
+    std::unique_ptr<OfflineRenderer> renderer;
+    juce::AudioBuffer<float> renderBuffer;
+    int renderGeneration = -1;
+    bool analytic = false;
+    juce::int64 periodSamples = 0;
+    Bucket steadyState;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ExportPreview)
+};
@@ -0,0 +1,218 @@
+#include "ExportPreviewView.h"
+
+namespace
+{
+    // Views shorter than this show milliseconds
+    constexpr double fineTimeSeconds = 10.0;
+
+    // Zoom factor per unit of wheel travel, as a power of two
+    constexpr double wheelZoomOctaves = 4.0;
+}
+
+//==============================================================================
+ExportPreviewView::ExportPreviewView (std::function<ExportPreview::Plan()> planSource)
+    : getPlan (std::move (planSource))
+{
+    setOpaque (true);
+    setMouseCursor (juce::MouseCursor::LeftRightResizeCursor);
+    preview.addChangeListener (this);
+    startTimerHz (plansPerSecond);
+}
+
+ExportPreviewView::~ExportPreviewView()
+{
+    stopTimer();
+    preview.removeChangeListener (this);
+}
+
+//==============================================================================
+void ExportPreviewView::timerCallback()
+{
+    // Hidden (e.g. in the plugin build): no preview work at all
+    if (! isShowing() || getPlan == nullptr)
+        return;
+
+    const auto plan = getPlan();
+    sampleRate = plan.sampleRate > 0.0 ? plan.sampleRate : 44100.0;
+    preview.setPlan (plan);
+}
+
+void ExportPreviewView::changeListenerCallback (juce::ChangeBroadcaster*)
+{
+    const auto newLength = preview.getLengthSamples();
+
+    if (newLength != lengthSamples)
+    {
+        // Keep a zoomed-in view where it is; a full view follows the new length
+        const auto showingAll = viewStart == 0 && viewEnd == lengthSamples;
+        lengthSamples = newLength;
+
+        if (showingAll || viewEnd > lengthSamples)
+            setView (0, lengthSamples);
+    }
+
+    repaint();
+}
+
+void ExportPreviewView::setView (juce::int64 newStart, juce::int64 newEnd)
+{
+    const auto span = juce::jlimit (juce::jmin ((juce::int64) minimumViewSamples, lengthSamples), lengthSamples,
+                                    newEnd - newStart);
+
+    viewStart = juce::jlimit ((juce::int64) 0, lengthSamples - span, newStart);
+    viewEnd = viewStart + span;
+    repaint();
+}
+
+double ExportPreviewView::getSampleAt (float x) const noexcept
+{
+    const auto proportion = (x - (float) waveformArea.getX()) / (float) juce::jmax (1, waveformArea.getWidth());
+    return (double) viewStart + (double) proportion * (double) (viewEnd - viewStart);
+}
+
+juce::String ExportPreviewView::formatPosition (juce::int64 sample) const
+{
+    const auto seconds = (double) sample / sampleRate;
+    const auto minutes = (int) (seconds / 60.0);
+
+    if ((double) (viewEnd - viewStart) / sampleRate < fineTimeSeconds)
+        return juce::String::formatted ("%d:%06.3f", minutes, seconds - minutes * 60.0);
+
+    const auto totalSeconds = (int) seconds;
+
+    if (totalSeconds >= 3600)
+        return juce::String::formatted ("%d:%02d:%02d", totalSeconds / 3600, (totalSeconds % 3600) / 60, totalSeconds % 60);
+
+    return juce::String::formatted ("%d:%02d", minutes, totalSeconds % 60);
+}
+
+//==============================================================================
+void ExportPreviewView::resized()
+{
+    auto area = getLocalBounds().reduced (4);
+    area.removeFromBottom (18); // readout
+    waveformArea = area;
+}
+
+void ExportPreviewView::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colour (0xff1a1a1a));
+
+    g.setColour (juce::Colour (0xff2f2f2f));
+    g.fillRect (waveformArea);
+
+    g.setColour (juce::Colours::white);
+    g.setFont (13.0f);
+    const auto readoutArea = getLocalBounds().reduced (6, 2).removeFromBottom (16);
+
+    if (lengthSamples <= 0 || waveformArea.isEmpty())
+    {
+        g.drawText ("Preparing preview...", readoutArea, juce::Justification::centredLeft);
+        return;
+    }
+
+    columns.resize ((size_t) waveformArea.getWidth());
+    const auto exact = preview.getColumns (viewStart, viewEnd, columns);
+
+    // Left on top, right below, each around its own centre line
+    const juce::Colour channelColours[] = { juce::Colour (0xff4a9eff), juce::Colours::orange };
+    const auto laneHeight = (float) waveformArea.getHeight() / 2.0f;
+
+    for (size_t channel = 0; channel < 2; ++channel)
+    {
+        const auto centre = (float) waveformArea.getY() + laneHeight * ((float) channel + 0.5f);
+        const auto scale = laneHeight * 0.45f;
+
+        g.setColour (juce::Colour (0xff444444));
+        g.drawHorizontalLine (juce::roundToInt (centre), (float) waveformArea.getX(), (float) waveformArea.getRight());
+
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            const auto& column = columns[i];
+            const auto& range = column.channels[channel];
+            const auto x = waveformArea.getX() + (int) i;
+
+            const auto top = centre - juce::jlimit (-1.0f, 1.0f, range.maximum) * scale;
+            const auto bottom = centre - juce::jlimit (-1.0f, 1.0f, range.minimum) * scale;
+            const auto rms = juce::jmin (1.0f, range.rms) * scale;
+
+            g.setColour (channelColours[channel].withAlpha (column.exact ? 0.5f : 0.25f));
+            g.drawVerticalLine (x, top, juce::jmax (bottom, top + 1.0f));
+
+            g.setColour (channelColours[channel].withAlpha (column.exact ? 1.0f : 0.5f));
+            g.drawVerticalLine (x, centre - rms, centre + rms);
+        }
+    }
+
+    juce::String readout = formatPosition (viewStart) + " - " + formatPosition (viewEnd);
+
+    if (! exact)
+        readout += "   refining...";
+
+    g.setColour (juce::Colours::white);
+    g.drawText (readout, readoutArea, juce::Justification::centredLeft);
+
+    // Time and peak levels under the pointer
+    if (hoverX >= waveformArea.getX() && hoverX < waveformArea.getRight())
+    {
+        g.setColour (juce::Colours::white.withAlpha (0.5f));
+        g.drawVerticalLine (hoverX, (float) waveformArea.getY(), (float) waveformArea.getBottom());
+
+        const auto& column = columns[(size_t) (hoverX - waveformArea.getX())];
+
+        auto peakDb = [&column] (size_t channel)
+        {
+            const auto& range = column.channels[channel];
+            return juce::Decibels::gainToDecibels (juce::jmax (std::abs (range.minimum), std::abs (range.maximum)));
+        };
+
+        g.setColour (juce::Colours::white);
+        g.drawText (formatPosition ((juce::int64) getSampleAt ((float) hoverX))
+                        + "   L " + juce::String (peakDb (0), 1) + " dB   R " + juce::String (peakDb (1), 1) + " dB",
+                    readoutArea, juce::Justification::centredRight);
+    }
+}
+
+//==============================================================================
+void ExportPreviewView::mouseMove (const juce::MouseEvent& e)
+{
+    hoverX = e.x;
+    repaint();
+}
+
+void ExportPreviewView::mouseExit (const juce::MouseEvent&)
+{
+    hoverX = -1;
+    repaint();
+}
+
+void ExportPreviewView::mouseDown (const juce::MouseEvent&)
+{
+    dragViewStart = viewStart;
+}
+
+void ExportPreviewView::mouseDrag (const juce::MouseEvent& e)
+{
+    const auto span = viewEnd - viewStart;
+    const auto samplesPerPixel = (double) span / (double) juce::jmax (1, waveformArea.getWidth());
+    const auto newStart = dragViewStart - (juce::int64) (e.getDistanceFromDragStartX() * samplesPerPixel);
+
+    hoverX = e.x;
+    setView (newStart, newStart + span);
+}
+
+void ExportPreviewView::mouseDoubleClick (const juce::MouseEvent&)
+{
+    setView (0, lengthSamples);
+}
+
+void ExportPreviewView::mouseWheelMove (const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel)
+{
+    // Zoom around the sample under the pointer, so it stays put
+    const auto factor = std::pow (2.0, -(double) wheel.deltaY * wheelZoomOctaves);
+    const auto anchor = getSampleAt ((float) e.x);
+    const auto newStart = anchor - (anchor - (double) viewStart) * factor;
+    const auto newSpan = juce::jmax (1.0, (double) (viewEnd - viewStart) * factor);
+
+    setView ((juce::int64) newStart, (juce::int64) (newStart + newSpan));
+}
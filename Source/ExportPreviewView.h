@@ -0,0 +1,64 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "ExportPreview.h"
+
+//==============================================================================
+/**
+    Overview of the export the editor's controls describe, next to them.
+
+    Polls the plan a few times a second while showing and hands it to an
+    ExportPreview, which only starts over when something changed. Left and
+    right are drawn as min/max bands with their RMS inside; columns still
+    waiting for an exact level are dimmed.
+
+    Mouse wheel zooms around the pointer, dragging scrolls, a double-click
+    shows the whole file. Hovering reads out the time and the peak level of
+    both channels there.
+*/
+class ExportPreviewView final : public juce::Component,
+                                private juce::ChangeListener,
+                                private juce::Timer
+{
+public:
+    explicit ExportPreviewView (std::function<ExportPreview::Plan()> planSource);
+    ~ExportPreviewView() override;
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+    void mouseMove (const juce::MouseEvent&) override;
+    void mouseExit (const juce::MouseEvent&) override;
+    void mouseDown (const juce::MouseEvent&) override;
+    void mouseDrag (const juce::MouseEvent&) override;
+    void mouseDoubleClick (const juce::MouseEvent&) override;
+    void mouseWheelMove (const juce::MouseEvent&, const juce::MouseWheelDetails&) override;
+
+private:
+    void timerCallback() override;
+    void changeListenerCallback (juce::ChangeBroadcaster*) override;
+
+    void setView (juce::int64 newStart, juce::int64 newEnd);
+    double getSampleAt (float x) const noexcept;
+    juce::String formatPosition (juce::int64 sample) const;
+
+    static constexpr int plansPerSecond = 4;
+
+    // Closest zoom: this many samples across the waveform
+    static constexpr int minimumViewSamples = 64;
+
+    ExportPreview preview;
+    std::function<ExportPreview::Plan()> getPlan;
+
+    juce::int64 lengthSamples = 0;
+    juce::int64 viewStart = 0, viewEnd = 0;
+    double sampleRate = 44100.0;
+
+    std::vector<ExportPreview::Column> columns;
+    juce::Rectangle<int> waveformArea;
+    int hoverX = -1;
+
+    juce::int64 dragViewStart = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ExportPreviewView)
+};
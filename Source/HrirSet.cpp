@@ -0,0 +1,98 @@
+#include "HrirSet.h"
+
+namespace
+{
+    constexpr double headRadiusMetres = 0.0875;
+    constexpr double speedOfSound = 343.0;
+    constexpr double impulseDurationSeconds = 0.0025;
+    constexpr int sincHalfWidth = HrirSet::bulkDelaySamples;
+
+    // Brown-Duda head shadow: minimum high-frequency gain and the angle where it occurs
+    constexpr double shadowAlphaMin = 0.1;
+    constexpr double shadowThetaMin = 150.0 * juce::MathConstants<double>::pi / 180.0;
+}
+
+//==============================================================================
+HrirSet::HrirSet (double rate)
+    : sampleRate (rate),
+      impulseLength (juce::jmax (64, juce::nextPowerOfTwo ((int) std::ceil (impulseDurationSeconds * rate))))
+{
+    impulses.setSize (numAzimuths * 2, impulseLength);
+
+    const auto earAngle = juce::MathConstants<float>::halfPi;
+
+    for (int index = 0; index < numAzimuths; ++index)
+    {
+        const auto azimuth = juce::degreesToRadians (getAzimuthDegrees (index));
+        renderEar (impulses.getWritePointer (index * 2),     azimuth,  earAngle);
+        renderEar (impulses.getWritePointer (index * 2 + 1), azimuth, -earAngle);
+    }
+}
+
+int HrirSet::getNearestIndex (float azimuthDegrees) noexcept
+{
+    const auto wrapped = std::fmod (std::fmod (azimuthDegrees, 360.0f) + 360.0f, 360.0f);
+    return juce::roundToInt (wrapped / azimuthStepDegrees) % numAzimuths;
+}
+
+juce::AudioBuffer<float> HrirSet::createImpulseResponse (int index) const
+{
+    jassert (juce::isPositiveAndBelow (index, numAzimuths));
+
+    juce::AudioBuffer<float> impulse (2, impulseLength);
+    impulse.copyFrom (0, 0, impulses, index * 2,     0, impulseLength);
+    impulse.copyFrom (1, 0, impulses, index * 2 + 1, 0, impulseLength);
+    return impulse;
+}
+
+//==============================================================================
+void HrirSet::renderEar (float* dest, float azimuthRadians, float earRadians) const
+{
+    using Constants = juce::MathConstants<double>;
+
+    // Angle between the source and the ear axis
+    const auto theta = std::acos (juce::jlimit (-1.0, 1.0, std::cos ((double) (azimuthRadians - earRadians))));
+
+    // Woodworth path difference, shifted so the nearest ear has zero delay
+    const auto headDelay = headRadiusMetres / speedOfSound;
+    const auto delaySeconds = theta < Constants::halfPi ? headDelay * (1.0 - std::cos (theta))
+                                                        : headDelay * (1.0 + theta - Constants::halfPi);
+    const auto delaySamples = (double) sincHalfWidth + delaySeconds * sampleRate;
+
+    // Band-limited fractional-delay impulse (Blackman-windowed sinc)
+    for (int n = 0; n < impulseLength; ++n)
+    {
+        const auto x = (double) n - delaySamples;
+
+        if (std::abs (x) >= (double) sincHalfWidth)
+        {
+            dest[n] = 0.0f;
+            continue;
+        }
+
+        const auto sinc = x == 0.0 ? 1.0 : std::sin (Constants::pi * x) / (Constants::pi * x);
+        const auto w = 0.5 + 0.5 * x / (double) sincHalfWidth;
+        const auto window = 0.42 - 0.5 * std::cos (Constants::twoPi * w) + 0.08 * std::cos (2.0 * Constants::twoPi * w);
+        dest[n] = (float) (sinc * window);
+    }
+
+    // Head shadow as a one-pole/one-zero shelf, bilinear-transformed
+    const auto alpha = (1.0 + shadowAlphaMin * 0.5)
+                     + (1.0 - shadowAlphaMin * 0.5) * std::cos (theta / shadowThetaMin * Constants::pi);
+    const auto tauK = 2.0 * sampleRate * headRadiusMetres / (2.0 * speedOfSound);
+    const auto norm = 1.0 / (1.0 + tauK);
+    const auto b0 = (1.0 + alpha * tauK) * norm;
+    const auto b1 = (1.0 - alpha * tauK) * norm;
+    const auto a1 = (1.0 - tauK) * norm;
+
+    double x1 = 0.0, y1 = 0.0;
+
+    for (int n = 0; n < impulseLength; ++n)
+    {
+        const auto x0 = (double) dest[n];
+        const auto y0 = b0 * x0 + b1 * x1 - a1 * y1;
+        dest[n] = (float) y0;
+        x1 = x0;
+        y1 = y0;
+    }
+}
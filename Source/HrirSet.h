@@ -0,0 +1,53 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Small set of head-related impulse responses on the horizontal plane.
+
+    The set is synthesised from a spherical head model (Woodworth interaural
+    delay plus the Brown-Duda head-shadow filter) instead of being loaded from
+    measured data, so it ships inside the binary, works at any sample rate and
+    only costs a few kilobytes.
+
+    Azimuths are in degrees, 0 is straight ahead and positive values turn to
+    the listener's left.
+*/
+class HrirSet
+{
+public:
+    static constexpr int numAzimuths = 24;
+    static constexpr float azimuthStepDegrees = 360.0f / (float) numAzimuths;
+
+    /** Delay common to every impulse: the nearest ear's fractional-delay sinc
+        is centred this many samples in, so its leading half fits. It is part
+        of the spatializer's latency.
+    */
+    static constexpr int bulkDelaySamples = 8;
+
+    explicit HrirSet (double sampleRate);
+
+    int getImpulseLength() const noexcept        { return impulseLength; }
+    double getSampleRate() const noexcept        { return sampleRate; }
+
+    /** Returns the grid index closest to the given azimuth. */
+    static int getNearestIndex (float azimuthDegrees) noexcept;
+
+    static float getAzimuthDegrees (int index) noexcept
+    {
+        return (float) index * azimuthStepDegrees;
+    }
+
+    /** Returns a stereo (left ear, right ear) impulse response for a grid position. */
+    juce::AudioBuffer<float> createImpulseResponse (int index) const;
+
+private:
+    void renderEar (float* dest, float azimuthRadians, float earRadians) const;
+
+    double sampleRate;
+    int impulseLength;
+    juce::AudioBuffer<float> impulses;  // two channels per azimuth
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HrirSet)
+};
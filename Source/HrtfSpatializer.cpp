@@ -0,0 +1,3 @@
+#include "HrtfSpatializer.h"
+
+// Empty implementation file - all functionality is in the header (template-based)
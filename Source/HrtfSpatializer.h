@@ -0,0 +1,155 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include "HrirSet.h"
+
+//==============================================================================
+/**
+    Places the left and right carriers at virtual positions around the
+    listener by convolving each of them with a stereo HRIR.
+
+    All instances share one convolution message queue, so loading new
+    positions never spawns a background thread per instance. With a latency
+    of zero the convolvers run a non-uniform partitioning with a zero-latency
+    head block; any other value uses uniform partitions of that size. The
+    reported latency adds the impulses' bulk delay to the convolvers' own.
+*/
+class HrtfSpatializer
+{
+public:
+    explicit HrtfSpatializer (int latencyInSamples = 0)
+    {
+        setLatency (latencyInSamples);
+    }
+
+    /** Rebuilds the convolvers; call before prepare(), never from the audio thread. */
+    void setLatency (int latencyInSamples)
+    {
+        requestedLatency = juce::jmax (0, latencyInSamples);
+
+        for (auto& convolution : convolutions)
+        {
+            if (requestedLatency == 0)
+                convolution = std::make_unique<juce::dsp::Convolution> (
+                    juce::dsp::Convolution::NonUniform { zeroLatencyHeadSize }, *messageQueue);
+            else
+                convolution = std::make_unique<juce::dsp::Convolution> (
+                    juce::dsp::Convolution::Latency { requestedLatency }, *messageQueue);
+        }
+
+        leftIndex = rightIndex = -1;
+    }
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        if (hrirSet == nullptr || hrirSet->getSampleRate() != spec.sampleRate)
+            hrirSet = std::make_unique<HrirSet> (spec.sampleRate);
+
+        // Loading before prepare makes the convolvers pick the IRs up synchronously
+        leftIndex = rightIndex = -1;
+        setPositions (leftAzimuth, rightAzimuth);
+
+        const juce::dsp::ProcessSpec stereoSpec { spec.sampleRate, spec.maximumBlockSize, 2 };
+
+        for (auto& convolution : convolutions)
+            convolution->prepare (stereoSpec);
+
+        for (auto& scratch : carrierScratch)
+            scratch.setSize (2, (int) spec.maximumBlockSize);
+    }
+
+    void reset()
+    {
+        for (auto& convolution : convolutions)
+            convolution->reset();
+    }
+
+    /** Moves the carriers; only reloads an HRIR when its grid position changes. */
+    void setPositions (float leftAzimuthDegrees, float rightAzimuthDegrees)
+    {
+        leftAzimuth = leftAzimuthDegrees;
+        rightAzimuth = rightAzimuthDegrees;
+
+        if (hrirSet == nullptr)
+            return;
+
+        loadPosition (0, HrirSet::getNearestIndex (leftAzimuth), leftIndex);
+        loadPosition (1, HrirSet::getNearestIndex (rightAzimuth), rightIndex);
+    }
+
+    /** The convolvers' latency plus the impulses' bulk delay. */
+    int getLatencySamples() const noexcept
+    {
+        return getConvolutionLatency() + HrirSet::bulkDelaySamples;
+    }
+
+    /** How long the output keeps sounding after the input falls silent. */
+    int getTailSamples() const noexcept
+    {
+        // The impulse length already covers the bulk delay
+        return getConvolutionLatency() + (hrirSet != nullptr ? hrirSet->getImpulseLength() : 0);
+    }
+
+    /** Expects the left carrier in channel 0 and the right carrier in channel 1. */
+    template <typename ProcessContext>
+    void process (const ProcessContext& context)
+    {
+        auto&& outputBlock = context.getOutputBlock();
+
+        if (outputBlock.getNumChannels() != 2)
+            return;
+
+        const auto numSamples = outputBlock.getNumSamples();
+        jassert (numSamples <= (size_t) carrierScratch[0].getNumSamples());
+
+        for (size_t carrier = 0; carrier < 2; ++carrier)
+        {
+            auto block = juce::dsp::AudioBlock<float> (carrierScratch[carrier]).getSubBlock (0, numSamples);
+            const auto* source = outputBlock.getChannelPointer (carrier);
+
+            juce::FloatVectorOperations::copy (block.getChannelPointer (0), source, (int) numSamples);
+            juce::FloatVectorOperations::copy (block.getChannelPointer (1), source, (int) numSamples);
+
+            juce::dsp::ProcessContextReplacing<float> carrierContext (block);
+            convolutions[carrier]->process (carrierContext);
+        }
+
+        for (size_t ear = 0; ear < 2; ++ear)
+            juce::FloatVectorOperations::add (outputBlock.getChannelPointer (ear),
+                                              carrierScratch[0].getReadPointer ((int) ear),
+                                              carrierScratch[1].getReadPointer ((int) ear),
+                                              (int) numSamples);
+    }
+
+private:
+    int getConvolutionLatency() const noexcept
+    {
+        return convolutions[0] != nullptr ? convolutions[0]->getLatency() : 0;
+    }
+
+    void loadPosition (size_t carrier, int index, int& currentIndex)
+    {
+        if (index == currentIndex)
+            return;
+
+        currentIndex = index;
+        convolutions[carrier]->loadImpulseResponse (hrirSet->createImpulseResponse (index),
+                                                    hrirSet->getSampleRate(),
+                                                    juce::dsp::Convolution::Stereo::yes,
+                                                    juce::dsp::Convolution::Trim::no,
+                                                    juce::dsp::Convolution::Normalise::no);
+    }
+
+    static constexpr int zeroLatencyHeadSize = 64;
+
+    juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue> messageQueue;
+    std::array<std::unique_ptr<juce::dsp::Convolution>, 2> convolutions;
+    std::array<juce::AudioBuffer<float>, 2> carrierScratch;
+    std::unique_ptr<HrirSet> hrirSet;
+
+    int requestedLatency = 0;
+    float leftAzimuth = 90.0f;
+    float rightAzimuth = -90.0f;
+    int leftIndex = -1;
+    int rightIndex = -1;
+};
@@ -0,0 +1,210 @@
+#include "LookAheadLimiter.h"
+
+//==============================================================================
+void LookAheadLimiter::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    window = lookAhead + 1;
+    maxBlockSize = (int) spec.maximumBlockSize;
+    releaseCoefficient = std::exp (-1.0f / (releaseSeconds * (float) spec.sampleRate));
+
+    delayLine.setSize ((int) spec.numChannels, juce::jmax (1, lookAhead));
+
+    const auto workSize = (size_t) (window - 1 + maxBlockSize);
+    required.resize (workSize);
+    spanMin[0].resize (workSize);
+    spanMin[1].resize (workSize);
+    peaks.resize ((size_t) maxBlockSize);
+    gains.resize ((size_t) maxBlockSize);
+    boxHistory.resize ((size_t) window);
+
+    reset();
+}
+
+void LookAheadLimiter::reset()
+{
+    delayLine.clear();
+    delayPosition = 0;
+
+    std::fill (required.begin(), required.end(), 1.0f);
+    std::fill (boxHistory.begin(), boxHistory.end(), 1.0f);
+    boxPosition = 0;
+    boxSum = (double) window;
+    envelope = 1.0f;
+}
+
+//==============================================================================
+void LookAheadLimiter::writeState (juce::OutputStream& stream) const
+{
+    auto writeFloats = [&stream] (const float* data, int count)
+    {
+        stream.writeInt (count);
+
+        for (int i = 0; i < count; ++i)
+            stream.writeFloat (data[i]);
+    };
+
+    stream.writeInt (delayLine.getNumChannels());
+
+    for (int channel = 0; channel < delayLine.getNumChannels(); ++channel)
+        writeFloats (delayLine.getReadPointer (channel), delayLine.getNumSamples());
+
+    writeFloats (required.data(), (int) required.size());
+    writeFloats (boxHistory.data(), (int) boxHistory.size());
+
+    stream.writeInt (delayPosition);
+    stream.writeInt (boxPosition);
+    stream.writeDouble (boxSum);
+    stream.writeFloat (envelope);
+}
+
+bool LookAheadLimiter::readState (juce::InputStream& stream)
+{
+    auto readFloats = [&stream] (float* data, int count)
+    {
+        if (stream.readInt() != count)
+            return false;
+
+        for (int i = 0; i < count; ++i)
+            data[i] = stream.readFloat();
+
+        return true;
+    };
+
+    if (stream.readInt() != delayLine.getNumChannels())
+        return false;
+
+    for (int channel = 0; channel < delayLine.getNumChannels(); ++channel)
+        if (! readFloats (delayLine.getWritePointer (channel), delayLine.getNumSamples()))
+            return false;
+
+    if (! readFloats (required.data(), (int) required.size())
+        || ! readFloats (boxHistory.data(), (int) boxHistory.size()))
+        return false;
+
+    delayPosition = stream.readInt();
+    boxPosition = stream.readInt();
+    boxSum = stream.readDouble();
+    envelope = stream.readFloat();
+
+    return juce::isPositiveAndBelow (delayPosition, juce::jmax (1, delayLine.getNumSamples()))
+        && juce::isPositiveAndBelow (boxPosition, juce::jmax (1, (int) boxHistory.size()));
+}
+
+//==============================================================================
+void LookAheadLimiter::process (float* const* channels, int numChannels, int numSamples) noexcept
+{
+    jassert (numChannels <= delayLine.getNumChannels());
+
+    float* chunk[16];
+    numChannels = juce::jmin (numChannels, (int) std::size (chunk));
+
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            chunk[channel] = channels[channel] + start;
+
+        processChunk (chunk, numChannels, juce::jmin (maxBlockSize, numSamples - start));
+    }
+}
+
+void LookAheadLimiter::processChunk (float* const* channels, int numChannels, int numSamples) noexcept
+{
+    // Linked peak detector: |x| of every channel, folded with a vector max
+    juce::FloatVectorOperations::abs (peaks.data(), channels[0], numSamples);
+
+    for (int channel = 1; channel < numChannels; ++channel)
+    {
+        juce::FloatVectorOperations::abs (gains.data(), channels[channel], numSamples);
+        juce::FloatVectorOperations::max (peaks.data(), peaks.data(), gains.data(), numSamples);
+    }
+
+    auto* incoming = required.data() + window - 1;
+
+    for (int i = 0; i < numSamples; ++i)
+        incoming[i] = juce::jmin (1.0f, ceiling / juce::jmax (peaks[(size_t) i], 1.0e-9f));
+
+    computeGains (numSamples);
+
+    if (! enabled)
+        juce::FloatVectorOperations::fill (gains.data(), 1.0f, numSamples);
+
+    applyDelayAndGain (channels, numChannels, numSamples);
+
+    if (enabled)
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::clip (channels[channel], channels[channel], -ceiling, ceiling, numSamples);
+}
+
+void LookAheadLimiter::computeGains (int numSamples) noexcept
+{
+    const auto total = window - 1 + numSamples;
+
+    // Minima over doubling spans: each pass is one vector min of the last
+    // pass against itself shifted by the span, with no dependency between
+    // samples, so it runs at full SIMD width (the van Herk prefix/suffix
+    // scans are one serial chain per segment)
+    const float* minima = required.data();
+    int span = 1;
+
+    for (size_t next = 0; span * 2 <= window; next ^= 1)
+    {
+        auto* dest = spanMin[next].data();
+        juce::FloatVectorOperations::min (dest, minima, minima + span, total - 2 * span + 1);
+        minima = dest;
+        span *= 2;
+    }
+
+    // A window is two overlapping spans; the peaks are no longer needed
+    auto* windowMinima = peaks.data();
+    juce::FloatVectorOperations::min (windowMinima, minima, minima + window - span, numSamples);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto windowMin = windowMinima[i];
+
+        boxSum += (double) windowMin - (double) boxHistory[(size_t) boxPosition];
+        boxHistory[(size_t) boxPosition] = windowMin;
+
+        if (++boxPosition == window)
+            boxPosition = 0;
+
+        const auto smoothed = juce::jmin (1.0f, (float) (boxSum / window));
+
+        envelope = smoothed < envelope ? smoothed
+                                       : smoothed + (envelope - smoothed) * releaseCoefficient;
+        gains[(size_t) i] = envelope;
+    }
+
+    // Keep the newest window - 1 values as history for the next block
+    std::memmove (required.data(), required.data() + numSamples, (size_t) (window - 1) * sizeof (float));
+}
+
+void LookAheadLimiter::applyDelayAndGain (float* const* channels, int numChannels, int numSamples) noexcept
+{
+    if (lookAhead == 0)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::multiply (channels[channel], gains.data(), numSamples);
+
+        return;
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* data = channels[channel];
+        auto* delayed = delayLine.getWritePointer (channel);
+        auto position = delayPosition;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto input = data[i];
+            data[i] = delayed[position] * gains[(size_t) i];
+            delayed[position] = input;
+
+            if (++position == lookAhead)
+                position = 0;
+        }
+    }
+
+    delayPosition = (delayPosition + numSamples) % lookAhead;
+}
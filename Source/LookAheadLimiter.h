@@ -0,0 +1,78 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+//==============================================================================
+/**
+    Look-ahead brickwall limiter for the master bus.
+
+    The signal is delayed by the look-ahead while the gain needed to keep each
+    sample under the ceiling is computed ahead of it. A sliding-window minimum
+    of that gain (built by doubling spans, log2 (window) vector min passes)
+    followed by a box average of the same length gives a
+    smooth gain curve that is always at or below what every delayed sample
+    needs, so nothing passes the ceiling. Recovery is an exponential release.
+
+    All channels share one gain so the stereo image does not shift.
+*/
+class LookAheadLimiter
+{
+public:
+    LookAheadLimiter() = default;
+
+    /** Look-ahead in samples, which is also the latency. Takes effect on prepare(). */
+    void setLookAhead (int numSamples)      { lookAhead = juce::jmax (0, numSamples); }
+    int getLatencySamples() const noexcept  { return lookAhead; }
+
+    void setCeiling (float amplitude) noexcept  { ceiling = juce::jlimit (1.0e-4f, 1.0f, amplitude); }
+
+    /** Takes effect on prepare(). */
+    void setReleaseTime (float seconds)         { releaseSeconds = juce::jmax (0.001f, seconds); }
+
+    /** When disabled the signal is only delayed, so the latency never changes. */
+    void setEnabled (bool shouldBeEnabled) noexcept  { enabled = shouldBeEnabled; }
+
+    void prepare (const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    /** Limits the channels in place. */
+    void process (float* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Saves or restores the running state (delay line, gain history and
+        envelope) so a render can continue exactly where it stopped. Reading
+        fails if the limiter was prepared differently.
+    */
+    void writeState (juce::OutputStream& stream) const;
+    bool readState (juce::InputStream& stream);
+
+private:
+    void processChunk (float* const* channels, int numChannels, int numSamples) noexcept;
+    void computeGains (int numSamples) noexcept;
+    void applyDelayAndGain (float* const* channels, int numChannels, int numSamples) noexcept;
+
+    int lookAhead = 64;
+    int window = 65;
+    float ceiling = 1.0f;
+    float releaseSeconds = 0.1f;
+    float releaseCoefficient = 0.0f;
+    bool enabled = true;
+    int maxBlockSize = 0;
+
+    // Delayed audio, circular
+    juce::AudioBuffer<float> delayLine;
+    int delayPosition = 0;
+
+    // Required gains with window - 1 samples of history in front, and the
+    // two buffers the span minima alternate between
+    std::vector<float> required;
+    std::array<std::vector<float>, 2> spanMin;
+    std::vector<float> peaks, gains;
+
+    // Box average of the windowed minimum, circular
+    std::vector<float> boxHistory;
+    int boxPosition = 0;
+    double boxSum = 0.0;
+    float envelope = 1.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LookAheadLimiter)
+};
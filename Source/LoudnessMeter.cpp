@@ -0,0 +1,203 @@
+#include "LoudnessMeter.h"
+
+namespace
+{
+    constexpr double absoluteGate = -70.0;
+    constexpr double relativeGate = -10.0;
+}
+
+//==============================================================================
+void LoudnessMeter::prepare (double sampleRate, int numChannels)
+{
+    using juce::MathConstants;
+
+    // K-weighting for an arbitrary rate, from the analogue prototypes behind
+    // the 48 kHz coefficients in BS.1770 (as derived for libebur128)
+    ChannelFilter filter;
+
+    {
+        const auto f0 = 1681.974450955533;
+        const auto gainDb = 3.999843853973347;
+        const auto q = 0.7071752369554196;
+
+        const auto k = std::tan (MathConstants<double>::pi * f0 / sampleRate);
+        const auto vh = std::pow (10.0, gainDb / 20.0);
+        const auto vb = std::pow (vh, 0.4996667741545416);
+        const auto a0 = 1.0 + k / q + k * k;
+
+        filter.shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        filter.shelf.b1 = 2.0 * (k * k - vh) / a0;
+        filter.shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        filter.shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        filter.shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        const auto f0 = 38.13547087602444;
+        const auto q = 0.5003270373238773;
+
+        const auto k = std::tan (MathConstants<double>::pi * f0 / sampleRate);
+        const auto a0 = 1.0 + k / q + k * k;
+
+        filter.highPass.b0 = 1.0;
+        filter.highPass.b1 = -2.0;
+        filter.highPass.b2 = 1.0;
+        filter.highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        filter.highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    filters.assign ((size_t) numChannels, filter);
+    stepLength = juce::jmax (1, juce::roundToInt (sampleRate * 0.1));
+    reset();
+}
+
+void LoudnessMeter::reset()
+{
+    for (auto& filter : filters)
+        filter.shelf.z1 = filter.shelf.z2 = filter.highPass.z1 = filter.highPass.z2 = 0.0;
+
+    stepPosition = 0;
+    stepEnergy = 0.0;
+    recentSteps = {};
+    numSteps = 0;
+    blockEnergies.clear();
+}
+
+//==============================================================================
+void LoudnessMeter::writeState (juce::OutputStream& stream) const
+{
+    stream.writeInt ((int) filters.size());
+
+    for (const auto& filter : filters)
+        for (auto* biquad : { &filter.shelf, &filter.highPass })
+        {
+            stream.writeDouble (biquad->z1);
+            stream.writeDouble (biquad->z2);
+        }
+
+    stream.writeInt (stepPosition);
+    stream.writeDouble (stepEnergy);
+
+    for (auto step : recentSteps)
+        stream.writeDouble (step);
+
+    stream.writeInt (numSteps);
+    stream.writeInt ((int) blockEnergies.size());
+
+    for (auto energy : blockEnergies)
+        stream.writeDouble (energy);
+}
+
+bool LoudnessMeter::readState (juce::InputStream& stream)
+{
+    if (stream.readInt() != (int) filters.size())
+        return false;
+
+    for (auto& filter : filters)
+        for (auto* biquad : { &filter.shelf, &filter.highPass })
+        {
+            biquad->z1 = stream.readDouble();
+            biquad->z2 = stream.readDouble();
+        }
+
+    stepPosition = stream.readInt();
+    stepEnergy = stream.readDouble();
+
+    for (auto& step : recentSteps)
+        step = stream.readDouble();
+
+    numSteps = stream.readInt();
+    const auto numBlocks = stream.readInt();
+
+    if (! juce::isPositiveAndBelow (stepPosition, stepLength) || numBlocks < 0
+        || stream.getNumBytesRemaining() < (juce::int64) numBlocks * (juce::int64) sizeof (double))
+        return false;
+
+    blockEnergies.resize ((size_t) numBlocks);
+
+    for (auto& energy : blockEnergies)
+        energy = stream.readDouble();
+
+    return true;
+}
+
+//==============================================================================
+void LoudnessMeter::process (const float* const* channels, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin (numChannels, (int) filters.size());
+
+    for (int start = 0; start < numSamples;)
+    {
+        const auto count = juce::jmin (numSamples - start, stepLength - stepPosition);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto& filter = filters[(size_t) channel];
+            const auto* data = channels[channel] + start;
+            auto sum = 0.0;
+
+            for (int i = 0; i < count; ++i)
+            {
+                const auto weighted = filter.highPass.processSample (filter.shelf.processSample (data[i]));
+                sum += weighted * weighted;
+            }
+
+            stepEnergy += sum;
+        }
+
+        start += count;
+        stepPosition += count;
+
+        if (stepPosition < stepLength)
+            break;
+
+        // A 100 ms step is complete; every fourth step closes a 400 ms block
+        recentSteps[(size_t) (numSteps % 4)] = stepEnergy / stepLength;
+        ++numSteps;
+        stepEnergy = 0.0;
+        stepPosition = 0;
+
+        if (numSteps >= 4)
+            blockEnergies.push_back (0.25 * (recentSteps[0] + recentSteps[1] + recentSteps[2] + recentSteps[3]));
+    }
+}
+
+double LoudnessMeter::energyToLoudness (double meanSquare) noexcept
+{
+    return meanSquare > 0.0 ? -0.691 + 10.0 * std::log10 (meanSquare)
+                            : -std::numeric_limits<double>::infinity();
+}
+
+double LoudnessMeter::getMomentaryLoudness() const
+{
+    return blockEnergies.empty() ? -std::numeric_limits<double>::infinity()
+                                 : energyToLoudness (blockEnergies.back());
+}
+
+double LoudnessMeter::getIntegratedLoudness() const
+{
+    auto gatedMean = [this] (double threshold)
+    {
+        auto sum = 0.0;
+        int count = 0;
+
+        for (auto energy : blockEnergies)
+        {
+            if (energyToLoudness (energy) > threshold)
+            {
+                sum += energy;
+                ++count;
+            }
+        }
+
+        return count > 0 ? sum / count : 0.0;
+    };
+
+    const auto absoluteMean = gatedMean (absoluteGate);
+
+    if (absoluteMean <= 0.0)
+        return -std::numeric_limits<double>::infinity();
+
+    const auto threshold = juce::jmax (absoluteGate, energyToLoudness (absoluteMean) + relativeGate);
+    return energyToLoudness (gatedMean (threshold));
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    ITU-R BS.1770-4 loudness meter.
+
+    Each channel goes through the K-weighting pre-filter and RLB high-pass,
+    the weighted mean squares are collected in 100 ms steps, and 400 ms
+    gating blocks (75 % overlap) are formed from them. Integrated loudness
+    applies the -70 LUFS absolute gate and the -10 LU relative gate.
+
+    All channels are weighted 1.0, which is correct for the mono and stereo
+    renders this is used on. The block history grows with the programme
+    length (ten values per second), so this belongs in offline renders, not
+    on the audio thread.
+*/
+class LoudnessMeter
+{
+public:
+    LoudnessMeter() = default;
+
+    void prepare (double sampleRate, int numChannels);
+    void reset();
+
+    void process (const float* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Gated integrated loudness in LUFS, or -infinity before the first block. */
+    double getIntegratedLoudness() const;
+
+    /** Loudness of the most recent 400 ms block in LUFS. */
+    double getMomentaryLoudness() const;
+
+    /** Saves or restores the filter state and block history, for renders
+        that stop and continue later. Reading fails on a channel mismatch.
+    */
+    void writeState (juce::OutputStream& stream) const;
+    bool readState (juce::InputStream& stream);
+
+    static double energyToLoudness (double meanSquare) noexcept;
+
+private:
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+        double z1 = 0.0, z2 = 0.0;
+
+        double processSample (double x) noexcept
+        {
+            const auto y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    struct ChannelFilter
+    {
+        Biquad shelf, highPass;
+    };
+
+    std::vector<ChannelFilter> filters;
+    int stepLength = 4800;
+    int stepPosition = 0;
+    double stepEnergy = 0.0;
+
+    std::array<double, 4> recentSteps {};
+    int numSteps = 0;
+    std::vector<double> blockEnergies;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessMeter)
+};
@@ -0,0 +1,126 @@
+#include "MidiCarrierControl.h"
+
+//==============================================================================
+MidiCarrierControl::MidiCarrierControl()
+{
+    bendRatios.fill (1.0f);
+}
+
+void MidiCarrierControl::setMode (Mode newMode, BinauralGenerator& generator)
+{
+    if (newMode == mode)
+        return;
+
+    mode = newMode;
+    reset (generator);
+    generator.setPolyphonic (mode != Mode::Mono);
+}
+
+void MidiCarrierControl::reset (BinauralGenerator& generator)
+{
+    numHeldNotes = 0;
+    bendRatios.fill (1.0f);
+    generator.allNotesOff();
+
+    for (int channel = 0; channel < (int) bendRatios.size(); ++channel)
+        generator.setChannelPitchBend (channel, 1.0f);
+}
+
+float MidiCarrierControl::getHeldNoteFrequency() const noexcept
+{
+    return numHeldNotes > 0 ? getNoteFrequency (heldNotes[(size_t) numHeldNotes - 1]) : 0.0f;
+}
+
+int MidiCarrierControl::getVoiceChannel (const juce::MidiMessage& message) const noexcept
+{
+    // Only MPE keeps channels apart; otherwise every note shares one bend
+    return mode == Mode::Mpe ? juce::jlimit (0, 15, message.getChannel() - 1) : 0;
+}
+
+float MidiCarrierControl::getNoteFrequency (HeldNote held) const noexcept
+{
+    return (float) juce::MidiMessage::getMidiNoteInHertz (held.note) * bendRatios[(size_t) held.channel];
+}
+
+//==============================================================================
+void MidiCarrierControl::handleMessage (const juce::MidiMessage& message, BinauralGenerator& generator,
+                                        float parameterBaseFrequency)
+{
+    const HeldNote held { getVoiceChannel (message), message.getNoteNumber() };
+
+    if (message.isNoteOn())
+    {
+        if (mode == Mode::Mono)
+            startMonoNote (held, generator);
+        else
+            generator.noteOn (held.channel, held.note,
+                              (float) juce::MidiMessage::getMidiNoteInHertz (held.note),
+                              message.getFloatVelocity());
+    }
+    else if (message.isNoteOff())
+    {
+        if (mode == Mode::Mono)
+            stopMonoNote (held, generator, parameterBaseFrequency);
+        else
+            generator.noteOff (held.channel, held.note);
+    }
+    else if (message.isPitchWheel())
+    {
+        const auto range = mode == Mode::Mpe ? 48.0f : 2.0f;
+        const auto semitones = range * (float) (message.getPitchWheelValue() - 8192) / 8192.0f;
+        const auto ratio = std::exp2 (semitones / 12.0f);
+
+        bendRatios[(size_t) held.channel] = ratio;
+
+        if (mode == Mode::Mono)
+        {
+            if (hasHeldNote())
+                generator.setBaseFrequency (getHeldNoteFrequency(), true);
+        }
+        else
+        {
+            generator.setChannelPitchBend (held.channel, ratio);
+        }
+    }
+    else if (message.isAllNotesOff() || message.isAllSoundOff())
+    {
+        numHeldNotes = 0;
+        generator.allNotesOff();
+
+        if (mode == Mode::Mono)
+            generator.setBaseFrequency (parameterBaseFrequency, true);
+    }
+}
+
+void MidiCarrierControl::startMonoNote (HeldNote held, BinauralGenerator& generator)
+{
+    // Full stack: forget the oldest note
+    if (numHeldNotes == (int) heldNotes.size())
+    {
+        std::move (heldNotes.begin() + 1, heldNotes.end(), heldNotes.begin());
+        --numHeldNotes;
+    }
+
+    heldNotes[(size_t) numHeldNotes++] = held;
+    generator.setBaseFrequency (getNoteFrequency (held), true);
+}
+
+void MidiCarrierControl::stopMonoNote (HeldNote held, BinauralGenerator& generator, float parameterBaseFrequency)
+{
+    const auto end = heldNotes.begin() + numHeldNotes;
+    const auto found = std::find_if (heldNotes.begin(), end, [held] (const HeldNote& h)
+                                     { return h.note == held.note && h.channel == held.channel; });
+
+    if (found == end)
+        return;
+
+    const auto wasSounding = found == end - 1;
+    std::move (found + 1, end, found);
+    --numHeldNotes;
+
+    if (! wasSounding)
+        return;
+
+    // Fall back to the previous held note, or to the parameter once all are up
+    generator.setBaseFrequency (hasHeldNote() ? getHeldNoteFrequency() : parameterBaseFrequency, true);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "BinauralGenerator.h"
+
+//==============================================================================
+/**
+    Plays the carriers from MIDI notes and pitch bend.
+
+    Mono: the last held note sets the base frequency (last-note priority),
+    pitch bend covers +/-2 semitones, and releasing every note returns to the
+    Base Frequency parameter.
+    Poly: each note plays its own binaural voice from the generator's pool;
+    pitch bend applies to all voices.
+    MPE: as Poly, but pitch bend is per MIDI channel with a +/-48 semitone range.
+
+    Controllers are left to the caller, which owns the parameter mapping.
+    Everything here runs on the audio thread and never allocates.
+*/
+class MidiCarrierControl
+{
+public:
+    enum class Mode
+    {
+        Mono,
+        Poly,
+        Mpe
+    };
+
+    MidiCarrierControl();
+
+    /** Switching mode releases every note. */
+    void setMode (Mode newMode, BinauralGenerator& generator);
+    Mode getMode() const noexcept  { return mode; }
+
+    void reset (BinauralGenerator& generator);
+
+    /** Applies a note, pitch-bend or all-notes-off message to the generator. */
+    void handleMessage (const juce::MidiMessage& message, BinauralGenerator& generator,
+                        float parameterBaseFrequency);
+
+    /** Mono mode only: the base frequency the held note asks for. */
+    bool hasHeldNote() const noexcept  { return numHeldNotes > 0; }
+    float getHeldNoteFrequency() const noexcept;
+
+private:
+    struct HeldNote
+    {
+        int channel = 0;
+        int note = 0;
+    };
+
+    int getVoiceChannel (const juce::MidiMessage& message) const noexcept;
+    float getNoteFrequency (HeldNote held) const noexcept;
+
+    void startMonoNote (HeldNote held, BinauralGenerator& generator);
+    void stopMonoNote (HeldNote held, BinauralGenerator& generator, float parameterBaseFrequency);
+
+    Mode mode = Mode::Mono;
+
+    std::array<HeldNote, 16> heldNotes;
+    int numHeldNotes = 0;
+    std::array<float, 16> bendRatios;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiCarrierControl)
+};
@@ -0,0 +1,22 @@
+#include "ModulationEngine.h"
+
+juce::String ModulationEngine::toString (const Patch& patch)
+{
+    static const char* const shapeNames[] = { "off", "sine", "triangle", "randomWalk", "rampUp", "rampDown" };
+    static const char* const targetNames[] = { "baseFrequency", "binauralOffset", "leftVolume", "rightVolume",
+                                               "masterVolume", "backgroundVolume" };
+
+    juce::StringArray lines;
+
+    for (size_t i = 0; i < patch.size(); ++i)
+    {
+        const auto& route = patch[i];
+
+        if (route.isActive())
+            lines.add (juce::String ((int) i) + ":" + shapeNames[(int) route.shape] + ">" + targetNames[(int) route.target]
+                       + " rate=" + juce::String (route.rateHz, 6) + " depth=" + juce::String (route.depth, 6)
+                       + (route.audioRate ? " audio" : " control"));
+    }
+
+    return lines.isEmpty() ? juce::String ("none") : lines.joinIntoString (";");
+}
@@ -0,0 +1,424 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+//==============================================================================
+/**
+    Built-in modulation for the generator: LFOs, random walks and ramps that
+    move the carrier frequencies and gains over time without host automation.
+
+    A Patch holds up to maxRoutes routes. Each route runs its own modulator
+    and adds depth * output (-1..1, or 0..1 for the ramps) to one target:
+    hertz for the frequency targets, decibels for the volume targets. Volume
+    routes only ever attenuate: their gain is clamped at unity, so a large
+    depth cannot push a target above its set level.
+
+    Routes evaluate either at audio rate, one modulator value per sample, or
+    at control rate: the modulator is only evaluated every controlInterval
+    samples and the values in between are interpolated. The control points
+    sit at fixed timeline positions, so the result does not depend on the
+    block size, and a control-rate route costs a fill loop per block plus one
+    modulator value (and, for volumes, one exp) every controlInterval
+    samples. Modulator values are produced a block at a time into arrays.
+
+    process() writes the sum of the routes for each target into a buffer;
+    BinauralGenerator feeds them to the oscillators and gain stages.
+*/
+class ModulationEngine
+{
+public:
+    enum class Shape
+    {
+        off,
+        sine,
+        triangle,
+        randomWalk,     // Straight moves between random points, rateHz of them a second
+        rampUp,         // 0 to 1 over 1 / rateHz seconds from when the route starts, then holds
+        rampDown        // 1 to 0 over 1 / rateHz seconds from when the route starts, then holds
+    };
+
+    enum class Target
+    {
+        baseFrequency,      // Both carriers, in Binaural mode
+        binauralOffset,     // Right carrier, in Binaural mode
+        leftVolume,
+        rightVolume,
+        masterVolume,
+        backgroundVolume
+    };
+
+    static constexpr int numTargets = 6;
+    static constexpr int maxRoutes = 8;
+    static constexpr int controlInterval = 32;
+
+    struct Route
+    {
+        Shape shape = Shape::off;
+        Target target = Target::binauralOffset;
+        float rateHz = 0.1f;
+
+        // Hz for the frequency targets, dB for the volumes (never above 0 dB)
+        float depth = 0.0f;
+
+        bool audioRate = false;
+
+        bool isActive() const noexcept  { return shape != Shape::off && depth != 0.0f; }
+
+        bool operator== (const Route& other) const noexcept
+        {
+            return shape == other.shape && target == other.target && rateHz == other.rateHz
+                && depth == other.depth && audioRate == other.audioRate;
+        }
+
+        bool operator!= (const Route& other) const noexcept  { return ! operator== (other); }
+    };
+
+    using Patch = std::array<Route, maxRoutes>;
+
+    static bool isActive (const Patch& patch) noexcept
+    {
+        return std::any_of (patch.begin(), patch.end(), [] (const Route& route) { return route.isActive(); });
+    }
+
+    static bool isFrequencyTarget (Target target) noexcept
+    {
+        return target == Target::baseFrequency || target == Target::binauralOffset;
+    }
+
+    /** One line per active route, for render specs and logs. */
+    static juce::String toString (const Patch& patch);
+
+    //==============================================================================
+    void prepare (double newSampleRate, int maximumBlockSize)
+    {
+        sampleRate = newSampleRate;
+        targetBuffers.setSize (numTargets, maximumBlockSize);
+        values.resize ((size_t) maximumBlockSize);
+        points.resize ((size_t) (maximumBlockSize / controlInterval + 3));
+        reset();
+    }
+
+    /** Back to the start of the timeline; random walks start their course again. */
+    void reset() noexcept
+    {
+        position = 0;
+
+        for (size_t i = 0; i < routes.size(); ++i)
+            restartRoute (i);
+    }
+
+    /** Continues from another timeline position. LFOs and ramps take the
+        value they have there; random walks carry on from where they are.
+        Consecutive blocks may call this every time at no cost.
+    */
+    void syncToPosition (juce::int64 samplePosition) noexcept
+    {
+        if (samplePosition == position)
+            return;
+
+        position = juce::jmax ((juce::int64) 0, samplePosition);
+
+        for (auto& state : routes)
+        {
+            state.modulator.jumpTo (position, state.route.rateHz);
+            state.primed = false;
+        }
+    }
+
+    /** Moves on numSamples without rendering them, e.g. while the generator idles. */
+    void advance (int numSamples) noexcept
+    {
+        syncToPosition (position + numSamples);
+    }
+
+    /** Audio-thread safe. A route with another shape, target or evaluation
+        restarts; rate and depth changes carry on smoothly.
+    */
+    void setPatch (const Patch& patch) noexcept
+    {
+        for (size_t i = 0; i < routes.size(); ++i)
+        {
+            auto& state = routes[i];
+            const auto restart = patch[i].shape != state.route.shape || patch[i].target != state.route.target
+                                 || patch[i].audioRate != state.route.audioRate;
+
+            state.route = patch[i];
+
+            if (restart)
+                restartRoute (i);
+        }
+    }
+
+    /** Renders the next numSamples of every route. Returns false, touching
+        nothing, when no route is active.
+    */
+    bool process (int numSamples) noexcept
+    {
+        jassert (numSamples <= targetBuffers.getNumSamples());
+        targetActive.fill (false);
+
+        if (numSamples <= 0)
+            return false;
+
+        for (auto& state : routes)
+        {
+            if (! state.route.isActive())
+                continue;
+
+            const auto target = (size_t) state.route.target;
+            auto* dest = targetBuffers.getWritePointer ((int) target);
+            const auto isFrequency = isFrequencyTarget (state.route.target);
+
+            // Frequency routes add hertz, volume routes multiply gains
+            if (! targetActive[target])
+            {
+                juce::FloatVectorOperations::fill (dest, isFrequency ? 0.0f : 1.0f, numSamples);
+                targetActive[target] = true;
+            }
+
+            renderRoute (state, values.data(), numSamples);
+
+            if (isFrequency)
+                juce::FloatVectorOperations::add (dest, values.data(), numSamples);
+            else
+                juce::FloatVectorOperations::multiply (dest, values.data(), numSamples);
+        }
+
+        position += numSamples;
+        return std::find (targetActive.begin(), targetActive.end(), true) != targetActive.end();
+    }
+
+    /** The last block's modulation of a target: a frequency offset in hertz
+        or a gain factor per sample. nullptr when no route drives it.
+    */
+    const float* getModulation (Target target) const noexcept
+    {
+        return targetActive[(size_t) target] ? targetBuffers.getReadPointer ((int) target) : nullptr;
+    }
+
+private:
+    //==============================================================================
+    class Modulator
+    {
+    public:
+        void start (Shape newShape, juce::uint32 seed, double newSampleRate, juce::int64 samplePosition, float rateHz) noexcept
+        {
+            shape = newShape;
+            sampleRate = newSampleRate;
+            random.setSeed ((juce::int64) seed);
+            walkFrom = 0.0f;
+            walkTo = nextWalkPoint (0.0f);
+            walkProgress = 0.0;
+            startPosition = samplePosition;
+            jumpTo (samplePosition, rateHz);
+        }
+
+        /** LFO phase of a modulator that has run at rateHz since sample 0,
+            and ramp progress since the position the modulator was started at,
+            so a ramp switched on mid-session runs its full course.
+        */
+        void jumpTo (juce::int64 samplePosition, float rateHz) noexcept
+        {
+            const auto cyclesPerSample = (double) rateHz / sampleRate;
+            const auto cycles = cyclesPerSample * (double) samplePosition;
+            phase = cycles - std::floor (cycles);
+            rampProgress = cyclesPerSample * (double) (samplePosition - startPosition);
+        }
+
+        /** Values at numPoints positions stride samples apart, the first at
+            the current position; leaves the modulator just past the last.
+        */
+        void render (float* dest, int numPoints, int stride, float rateHz) noexcept
+        {
+            const auto step = (double) rateHz / sampleRate * (double) stride;
+
+            switch (shape)
+            {
+                case Shape::sine:
+                    for (int i = 0; i < numPoints; ++i)
+                    {
+                        // The approximation covers [-pi, pi]: sin (2 pi p) = -sin (2 pi p - pi)
+                        const auto x = (float) (juce::MathConstants<double>::twoPi * phase) - juce::MathConstants<float>::pi;
+                        dest[i] = -juce::dsp::FastMathApproximations::sin (x);
+                        advancePhase (step);
+                    }
+                    break;
+
+                case Shape::triangle:
+                    for (int i = 0; i < numPoints; ++i)
+                    {
+                        // Starts at 0 rising, like the sine
+                        auto p = phase + 0.75;
+                        p -= std::floor (p);
+                        dest[i] = (float) (4.0 * std::abs (p - 0.5) - 1.0);
+                        advancePhase (step);
+                    }
+                    break;
+
+                case Shape::randomWalk:
+                    for (int i = 0; i < numPoints; ++i)
+                    {
+                        dest[i] = walkFrom + (walkTo - walkFrom) * (float) walkProgress;
+                        walkProgress += step;
+
+                        while (walkProgress >= 1.0)
+                        {
+                            walkProgress -= 1.0;
+                            walkFrom = walkTo;
+                            walkTo = nextWalkPoint (walkFrom);
+                        }
+                    }
+                    break;
+
+                case Shape::rampUp:
+                case Shape::rampDown:
+                    for (int i = 0; i < numPoints; ++i)
+                    {
+                        const auto value = (float) juce::jlimit (0.0, 1.0, rampProgress);
+                        dest[i] = shape == Shape::rampUp ? value : 1.0f - value;
+                        rampProgress += step;
+                    }
+                    break;
+
+                case Shape::off:
+                default:
+                    juce::FloatVectorOperations::clear (dest, numPoints);
+                    break;
+            }
+        }
+
+    private:
+        void advancePhase (double step) noexcept
+        {
+            phase += step;
+            phase -= std::floor (phase);
+        }
+
+        // Each point is a random step of up to 1 from the last, kept in [-1, 1]
+        float nextWalkPoint (float from) noexcept
+        {
+            return juce::jlimit (-1.0f, 1.0f, from + random.nextFloat() * 2.0f - 1.0f);
+        }
+
+        Shape shape = Shape::off;
+        double sampleRate = 44100.0;
+        double phase = 0.0;
+        double rampProgress = 0.0;
+        juce::int64 startPosition = 0;
+
+        juce::Random random;
+        float walkFrom = 0.0f, walkTo = 0.0f;
+        double walkProgress = 0.0;
+    };
+
+    struct RouteState
+    {
+        Route route;
+        Modulator modulator;
+
+        // Control rate: the newest control point evaluated and the one before
+        bool primed = false;
+        juce::int64 lastPoint = 0;
+        float lastValue = 0.0f, previousValue = 0.0f;
+    };
+
+    //==============================================================================
+    void restartRoute (size_t index) noexcept
+    {
+        auto& state = routes[index];
+
+        // Seeded by slot, so a render is the same every time
+        state.modulator.start (state.route.shape, (juce::uint32) index + 1, sampleRate, position, state.route.rateHz);
+        state.primed = false;
+    }
+
+    /** Modulator values to hertz, or to gain factors for the volumes. */
+    static void applyDepth (const Route& route, float* data, int numValues) noexcept
+    {
+        if (isFrequencyTarget (route.target))
+        {
+            juce::FloatVectorOperations::multiply (data, route.depth, numValues);
+            return;
+        }
+
+        // 10^(dB / 20) as one exp, at most unity gain
+        const auto nepersPerUnit = route.depth * std::log (10.0f) / 20.0f;
+
+        for (int i = 0; i < numValues; ++i)
+            data[i] = std::exp (juce::jmin (0.0f, data[i] * nepersPerUnit));
+    }
+
+    void renderRoute (RouteState& state, float* dest, int numSamples) noexcept
+    {
+        const auto& route = state.route;
+
+        if (route.audioRate)
+        {
+            state.modulator.render (dest, numSamples, 1, route.rateHz);
+            applyDepth (route, dest, numSamples);
+            return;
+        }
+
+        // Control points at multiples of controlInterval on the timeline;
+        // every sample interpolates between the two around it
+        constexpr auto interval = (juce::int64) controlInterval;
+        const auto firstPoint = position / interval * interval;
+        const auto lastNeeded = (position + numSamples - 1) / interval * interval + interval;
+
+        if (! state.primed)
+        {
+            state.modulator.jumpTo (firstPoint, route.rateHz);
+            state.modulator.render (&state.lastValue, 1, controlInterval, route.rateHz);
+            applyDepth (route, &state.lastValue, 1);
+            state.previousValue = state.lastValue;
+            state.lastPoint = firstPoint;
+            state.primed = true;
+        }
+
+        // A block starts at or just before the newest point of the last one
+        jassert (firstPoint == state.lastPoint || firstPoint == state.lastPoint - interval);
+
+        int numPoints = 0;
+
+        if (firstPoint < state.lastPoint)
+            points[(size_t) numPoints++] = state.previousValue;
+
+        points[(size_t) numPoints++] = state.lastValue;
+
+        const auto numNew = (int) ((lastNeeded - state.lastPoint) / interval);
+        state.modulator.render (points.data() + numPoints, numNew, controlInterval, route.rateHz);
+        applyDepth (route, points.data() + numPoints, numNew);
+        numPoints += numNew;
+
+        state.previousValue = points[(size_t) numPoints - 2];
+        state.lastValue = points[(size_t) numPoints - 1];
+        state.lastPoint = lastNeeded;
+
+        // Straight segments between the points
+        auto offset = (int) (position - firstPoint);
+        size_t point = 0;
+
+        for (int i = 0; i < numSamples; ++point)
+        {
+            const auto segmentLength = juce::jmin (controlInterval - offset, numSamples - i);
+            const auto slope = (points[point + 1] - points[point]) / (float) controlInterval;
+            const auto start = points[point] + slope * (float) offset;
+
+            for (int j = 0; j < segmentLength; ++j)
+                dest[i + j] = start + slope * (float) j;
+
+            i += segmentLength;
+            offset = 0;
+        }
+    }
+
+    //==============================================================================
+    std::array<RouteState, maxRoutes> routes;
+    std::array<bool, numTargets> targetActive {};
+
+    juce::AudioBuffer<float> targetBuffers;
+    std::vector<float> values, points;
+
+    double sampleRate = 44100.0;
+    juce::int64 position = 0;
+};
@@ -0,0 +1,231 @@
+#include "OfflineRenderer.h"
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer (juce::AudioFormatManager& formats)
+    : formatManager (formats)
+{
+}
+
+bool OfflineRenderer::prepare (const Settings& newSettings, double sampleRate, int maximumBlockSize)
+{
+    settings = newSettings;
+    blockSize = maximumBlockSize;
+    currentSampleRate = sampleRate;
+
+    const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, 2 };
+
+    generator.setLimiterLookAhead (settings.limiterLookAhead);
+    generator.prepare (spec);
+
+    generator.setMode (BinauralGenerator::Mode::Binaural);
+    generator.setBaseFrequency (settings.baseFrequency);
+    generator.setBinauralOffset (settings.binauralOffset);
+    generator.setLeftVolume (BinauralGenerator::volumeToGain (settings.leftVolumeDb));
+    generator.setRightVolume (BinauralGenerator::volumeToGain (settings.rightVolumeDb));
+    generator.setMasterVolume (BinauralGenerator::volumeToGain (settings.masterVolumeDb, settings.masterTrimDb));
+    generator.setLimiterEnabled (settings.limiter);
+    generator.setLimiterCeiling (juce::Decibels::decibelsToGain (settings.limiterCeilingDb));
+    generator.setModulation (settings.modulation);
+
+    // Settings apply from the first sample, not through the parameter ramps
+    generator.reset();
+
+    // Bed layer gets its own stream; the render waits on it instead of dropping out
+    generator.setBackgroundLayer (nullptr);
+    background.unload();
+
+    if (settings.backgroundFile != juce::File())
+    {
+        if (! background.load (settings.backgroundFile, formatManager))
+            return false;
+
+        background.prepare (sampleRate, blockSize);
+        generator.setBackgroundLayer (&background);
+        generator.setBackgroundVolume (BinauralGenerator::volumeToGain (settings.backgroundVolumeDb));
+        generator.setOfflineRendering (true);
+    }
+
+    // The convolvers load their IRs synchronously in prepare
+    if (settings.spatializer)
+    {
+        spatializer.setLatency (settings.spatializerLatency);
+        spatializer.setPositions (settings.leftAzimuth, settings.rightAzimuth);
+        spatializer.prepare (spec);
+    }
+
+    discardBuffer.setSize (2, blockSize);
+    samplesToDiscard = generator.getLatencySamples()
+                     + (settings.spatializer ? spatializer.getLatencySamples() : 0);
+
+    loopLength = 0;
+    loopCrossfade = 0;
+    loopPosition = 0;
+    position = 0;
+    return true;
+}
+
+void OfflineRenderer::seek (juce::int64 newPosition)
+{
+    jassert (loopLength == 0);
+
+    generator.reset();
+    generator.syncToPosition (newPosition);
+    background.seek (newPosition);
+
+    if (settings.spatializer)
+        spatializer.reset();
+
+    // The latency is dropped again, which also brings the carriers and bed to newPosition's output
+    samplesToDiscard = generator.getLatencySamples()
+                     + (settings.spatializer ? spatializer.getLatencySamples() : 0);
+    position = newPosition;
+}
+
+bool OfflineRenderer::updateSettings (const Settings& newSettings)
+{
+    const auto rebuild = newSettings.backgroundFile != settings.backgroundFile
+                      || newSettings.spatializer != settings.spatializer
+                      || newSettings.spatializerLatency != settings.spatializerLatency
+                      || newSettings.limiterLookAhead != settings.limiterLookAhead
+                      || (newSettings.spatializer && (newSettings.leftAzimuth != settings.leftAzimuth
+                                                      || newSettings.rightAzimuth != settings.rightAzimuth));
+
+    if (rebuild)
+    {
+        const auto currentPosition = position;
+
+        if (! prepare (newSettings, currentSampleRate, blockSize))
+            return false;
+
+        seek (currentPosition);
+        return true;
+    }
+
+    settings = newSettings;
+
+    generator.setBaseFrequency (settings.baseFrequency);
+    generator.setBinauralOffset (settings.binauralOffset);
+    generator.setLeftVolume (BinauralGenerator::volumeToGain (settings.leftVolumeDb));
+    generator.setRightVolume (BinauralGenerator::volumeToGain (settings.rightVolumeDb));
+    generator.setMasterVolume (BinauralGenerator::volumeToGain (settings.masterVolumeDb, settings.masterTrimDb));
+    generator.setLimiterEnabled (settings.limiter);
+    generator.setLimiterCeiling (juce::Decibels::decibelsToGain (settings.limiterCeilingDb));
+    generator.setBackgroundVolume (BinauralGenerator::volumeToGain (settings.backgroundVolumeDb));
+    generator.setModulation (settings.modulation);
+    return true;
+}
+
+void OfflineRenderer::discardLatency()
+{
+    // Drop the limiter and spatializer latency so the output starts on the first sample
+    while (samplesToDiscard > 0)
+    {
+        const auto numToDiscard = juce::jmin (blockSize, samplesToDiscard);
+        renderBlock (discardBuffer, numToDiscard);
+        samplesToDiscard -= numToDiscard;
+    }
+}
+
+void OfflineRenderer::render (juce::AudioBuffer<float>& buffer, int numSamples)
+{
+    jassert (numSamples <= blockSize && buffer.getNumChannels() >= 2);
+
+    discardLatency();
+    renderBlock (buffer, numSamples);
+    position += numSamples;
+
+    if (loopCrossfade == 0)
+        return;
+
+    // Fade the loop's tail into the lead-in kept by startLoop()
+    const auto fadeStart = loopLength - loopCrossfade;
+
+    for (int i = juce::jmax (0, fadeStart - loopPosition); i < numSamples; ++i)
+    {
+        const auto fadeIndex = loopPosition + i - fadeStart;
+
+        if (fadeIndex >= loopCrossfade)
+            break;
+
+        // 0 -> 1 across the fade, reaching the lead-in's last sample at the loop end
+        // Linear: the repeating carriers are identical on both sides and stay level
+        const auto fadeIn = (float) (fadeIndex + 1) / (float) loopCrossfade;
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto* samples = buffer.getWritePointer (channel);
+            samples[i] += (loopLead.getSample (channel, fadeIndex) - samples[i]) * fadeIn;
+        }
+    }
+
+    loopPosition += numSamples;
+}
+
+SeamlessLoop::Plan OfflineRenderer::planLoop (const Settings& settings, double sampleRate, double targetSeconds)
+{
+    const auto needsCrossfade = settings.backgroundFile != juce::File() || ModulationEngine::isActive (settings.modulation);
+
+    return SeamlessLoop::plan (settings.baseFrequency, settings.baseFrequency + settings.binauralOffset,
+                               sampleRate, targetSeconds, needsCrossfade);
+}
+
+void OfflineRenderer::startLoop (const SeamlessLoop::Plan& plan)
+{
+    discardLatency();
+
+    loopLength = plan.lengthSamples;
+    loopCrossfade = plan.crossfadeSamples;
+    loopPosition = 0;
+
+    // One second lets the limiter release and the convolver tails settle
+    const auto settleSamples = juce::jmax (loopCrossfade,
+                                           juce::roundToInt (currentSampleRate));
+    loopLead.setSize (2, loopCrossfade);
+
+    for (int position = 0; position < settleSamples; position += blockSize)
+    {
+        const auto numToRender = juce::jmin (blockSize, settleSamples - position);
+        renderBlock (discardBuffer, numToRender);
+
+        // Keep the last loopCrossfade samples as the audio leading into the loop start
+        const auto leadStart = settleSamples - loopCrossfade;
+        const auto first = juce::jmax (position, leadStart);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = first; i < position + numToRender; ++i)
+                loopLead.setSample (channel, i - leadStart, discardBuffer.getSample (channel, i - position));
+    }
+}
+
+void OfflineRenderer::renderBlock (juce::AudioBuffer<float>& buffer, int numSamples)
+{
+    auto block = juce::dsp::AudioBlock<float> (buffer).getSubsetChannelBlock (0, 2)
+                                                     .getSubBlock (0, (size_t) numSamples);
+    juce::dsp::ProcessContextReplacing<float> context (block);
+    generator.process (context);
+
+    if (settings.spatializer)
+        spatializer.process (context);
+}
+
+//==============================================================================
+bool OfflineRenderer::canSaveState() const noexcept
+{
+    return settings.backgroundFile == juce::File() && ! settings.spatializer && loopLength == 0
+        && ! ModulationEngine::isActive (settings.modulation);
+}
+
+void OfflineRenderer::writeState (juce::OutputStream& stream) const
+{
+    jassert (canSaveState());
+    generator.writeState (stream);
+}
+
+bool OfflineRenderer::readState (juce::InputStream& stream)
+{
+    if (! canSaveState() || ! generator.readState (stream))
+        return false;
+
+    samplesToDiscard = 0;
+    return true;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "BinauralGenerator.h"
+#include "HrtfSpatializer.h"
+#include "SeamlessLoop.h"
+
+//==============================================================================
+/**
+    Stereo render chain used by exports: generator, streamed bed and the
+    optional spatializer, configured from a snapshot of the parameters.
+
+    The output is latency-compensated: the limiter look-ahead and spatializer
+    delay are rendered and dropped before the first sample handed out, so a
+    file written from render() starts exactly on the programme.
+*/
+class OfflineRenderer
+{
+public:
+    struct Settings
+    {
+        float baseFrequency = 440.0f;
+        float binauralOffset = 10.0f;
+        float leftVolumeDb = -6.0f;
+        float rightVolumeDb = -6.0f;
+        float masterVolumeDb = 0.0f;
+
+        // Extra gain on top of the master volume, e.g. for loudness targets
+        float masterTrimDb = 0.0f;
+
+        bool limiter = true;
+        float limiterCeilingDb = -1.0f;
+        int limiterLookAhead = 64;
+
+        bool spatializer = false;
+        float leftAzimuth = 90.0f;
+        float rightAzimuth = -90.0f;
+        int spatializerLatency = 0;
+
+        juce::File backgroundFile;
+        float backgroundVolumeDb = -12.0f;
+
+        ModulationEngine::Patch modulation {};
+    };
+
+    explicit OfflineRenderer (juce::AudioFormatManager& formats);
+
+    /** Returns false if the background file cannot be opened. */
+    bool prepare (const Settings& newSettings, double sampleRate, int maximumBlockSize);
+
+    /** Writes the next numSamples (at most the block size) into the first two
+        channels of buffer.
+    */
+    void render (juce::AudioBuffer<float>& buffer, int numSamples);
+
+    /** Output samples rendered since prepare(), or since the last seek(). */
+    juce::int64 getPosition() const noexcept  { return position; }
+
+    /** Continues the render from another output position, as if that many
+        samples had been rendered: the carriers take their phase there and the
+        bed its place in the file. The limiter and convolvers start from rest,
+        and the carrier phases match an uninterrupted render to within
+        rounding. Not for loops.
+    */
+    void seek (juce::int64 newPosition);
+
+    /** Changes the settings between render() calls. Frequencies and gains
+        glide as they do in live playback; a different bed, spatializer,
+        azimuth or limiter look-ahead rebuilds the chain at the current
+        position. Returns false if the new bed cannot be opened.
+    */
+    bool updateSettings (const Settings& newSettings);
+
+    /** Shapes the next plan.lengthSamples of output into a loop. Call after
+        prepare() (with the plan's carrier frequencies in the settings) and
+        before the first render().
+
+        The chain first runs for a while so the limiter and convolvers reach
+        the periodic state the carriers put them in; a crossfading plan also
+        keeps the audio just before the loop start and fades the loop's end
+        into it, so the last sample leads back into the first.
+    */
+    void startLoop (const SeamlessLoop::Plan& plan);
+
+    /** The loop plan for these settings. A bed or active modulation does not
+        repeat with the carriers, so those loops always crossfade.
+    */
+    static SeamlessLoop::Plan planLoop (const Settings& settings, double sampleRate, double targetSeconds);
+
+    /** True when writeState()/readState() capture everything: the bed
+        stream, the convolvers, loop crossfades and modulation keep state
+        they cannot save.
+    */
+    bool canSaveState() const noexcept;
+
+    /** Saves or restores the chain between render() calls so an export can
+        continue where it stopped. Restore right after prepare() with the
+        same settings; the latency has already been dropped at that point.
+    */
+    void writeState (juce::OutputStream& stream) const;
+    bool readState (juce::InputStream& stream);
+
+private:
+    void discardLatency();
+    void renderBlock (juce::AudioBuffer<float>& buffer, int numSamples);
+
+    juce::AudioFormatManager& formatManager;
+    Settings settings;
+
+    BinauralGenerator generator;
+    BackgroundLayer background;
+    HrtfSpatializer spatializer;
+
+    juce::AudioBuffer<float> discardBuffer;
+    double currentSampleRate = 44100.0;
+    int blockSize = 512;
+    int samplesToDiscard = 0;
+    juce::int64 position = 0;
+
+    juce::AudioBuffer<float> loopLead;
+    int loopLength = 0;
+    int loopCrossfade = 0;
+    int loopPosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderer)
+};
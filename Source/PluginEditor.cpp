@@ -1,18 +1,20 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "Presets.h"
 #include <functional>
 
 //==============================================================================
 BinauralAudioProcessorEditor::BinauralAudioProcessorEditor (BinauralAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p),
+      spectrumAnalyzer (p.getAnalyzerFeed(), [&p] { return p.getSampleRate(); }),
+      exportPreview ([this] { return audioProcessor.getExportPreviewPlan (exportSampleRate, durationSlider.getValue() * 60.0,
+                                                                          loopToggle.getToggleState()); })
 {
     // Set editor size - calculated to fit all elements comfortably
     // Larger if standalone (for export controls)
     #if JucePlugin_Build_Standalone
-    setSize (650, 1000);
+    setSize (650, 1955);
     #else
-    setSize (550, 600);
+    setSize (550, 1339);
     #endif
 
     // Setup sliders and labels
@@ -22,8 +24,27 @@ BinauralAudioProcessorEditor::BinauralAudioProcessorEditor (BinauralAudioProcess
     setupSlider (rightVolumeSlider, rightVolumeLabel, "Right Volume (dB)");
     setupSlider (masterVolumeSlider, masterVolumeLabel, "Master Volume (dB)");
     setupToggle (modeToggle, modeLabel, "Mode");
+    addAndMakeVisible (midiModeComboBox);
+    midiModeComboBox.addItemList ({ "Mono (last note sets Base Frequency)", "Poly (one binaural pair per note)", "MPE (per-channel pitch bend)" }, 1);
+    addAndMakeVisible (midiModeLabel);
+    midiModeLabel.setText ("MIDI Mode", juce::dontSendNotification);
+    midiModeLabel.attachToComponent (&midiModeComboBox, false);
+    midiModeLabel.setColour (juce::Label::textColourId, juce::Colours::white);
+    setupToggle (limiterToggle, limiterLabel, "Safety Limiter");
+    limiterToggle.setButtonText ("On / Off");
+    setupSlider (limiterCeilingSlider, limiterCeilingLabel, "Limiter Ceiling (dB)");
+    setupToggle (phaseLockToggle, phaseLockLabel, "Transport Phase Lock (deterministic bounces)");
+    phaseLockToggle.setButtonText ("On / Off");
+    setupToggle (spatializerToggle, spatializerLabel, "Spatializer (HRTF, headphones)");
+    spatializerToggle.setButtonText ("On / Off");
+    setupSlider (leftAzimuthSlider, leftAzimuthLabel, "Left Carrier Azimuth (deg)");
+    setupSlider (rightAzimuthSlider, rightAzimuthLabel, "Right Carrier Azimuth (deg)");
+    setupSlider (backgroundVolumeSlider, backgroundVolumeLabel, "Background Volume (dB)");
+    setupBackgroundControls();
+    setupModulationControls();
     setupMuteButton (muteButton);
     setupComboBox (presetComboBox, presetLabel, "Preset");
+    addAndMakeVisible (spectrumAnalyzer);
     
     // Setup export controls (only in standalone)
     #if JucePlugin_Build_Standalone
@@ -46,11 +67,35 @@ BinauralAudioProcessorEditor::BinauralAudioProcessorEditor (BinauralAudioProcess
     masterVolumeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.getValueTreeState(), BinauralAudioProcessor::MASTER_VOLUME_ID, masterVolumeSlider);
     
+    limiterAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getValueTreeState(), BinauralAudioProcessor::LIMITER_ID, limiterToggle);
+    
+    limiterCeilingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getValueTreeState(), BinauralAudioProcessor::LIMITER_CEILING_ID, limiterCeilingSlider);
+    
+    phaseLockAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getValueTreeState(), BinauralAudioProcessor::PHASE_LOCK_ID, phaseLockToggle);
+    
     modeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
         audioProcessor.getValueTreeState(), BinauralAudioProcessor::MODE_ID, modeToggle);
     
+    midiModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.getValueTreeState(), BinauralAudioProcessor::MIDI_MODE_ID, midiModeComboBox);
+    
     muteAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
         audioProcessor.getValueTreeState(), BinauralAudioProcessor::MUTE_ID, muteButton);
+    
+    spatializerAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        audioProcessor.getValueTreeState(), BinauralAudioProcessor::SPATIALIZER_ID, spatializerToggle);
+    
+    leftAzimuthAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getValueTreeState(), BinauralAudioProcessor::LEFT_AZIMUTH_ID, leftAzimuthSlider);
+    
+    rightAzimuthAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getValueTreeState(), BinauralAudioProcessor::RIGHT_AZIMUTH_ID, rightAzimuthSlider);
+    
+    backgroundVolumeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getValueTreeState(), BinauralAudioProcessor::BACKGROUND_VOLUME_ID, backgroundVolumeSlider);
 }
 
 BinauralAudioProcessorEditor::~BinauralAudioProcessorEditor()
@@ -108,6 +153,11 @@ void BinauralAudioProcessorEditor::resized()
     
     int y = area.getY() + margin;
 
+    // Analyzer
+    const int analyzerHeight = 150;
+    spectrumAnalyzer.setBounds (margin, y, getWidth() - 2 * margin, analyzerHeight);
+    y += analyzerHeight + spacing;
+
     // Preset ComboBox
     presetLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
     presetComboBox.setBounds (margin, y + labelHeight + 2, getWidth() - 2 * margin, comboHeight);
@@ -132,6 +182,11 @@ void BinauralAudioProcessorEditor::resized()
     modeToggle.setBounds (margin, y + labelHeight + 2, 180, buttonHeight);
     y += labelHeight + buttonHeight + spacing + 2;
 
+    // MIDI Mode
+    midiModeLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
+    midiModeComboBox.setBounds (margin, y + labelHeight + 2, getWidth() - 2 * margin, comboHeight);
+    y += labelHeight + comboHeight + spacing + 2;
+
     // Left Volume
     leftVolumeLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
     leftVolumeSlider.setBounds (margin, y + labelHeight + 2, getWidth() - 2 * margin, sliderHeight);
@@ -146,6 +201,66 @@ void BinauralAudioProcessorEditor::resized()
     masterVolumeLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
     masterVolumeSlider.setBounds (margin, y + labelHeight + 2, getWidth() - 2 * margin, sliderHeight);
     y += labelHeight + sliderHeight + spacing + 2;
+
+    // Master limiter
+    limiterLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
+    limiterToggle.setBounds (margin, y + labelHeight + 2, 180, buttonHeight);
+    y += labelHeight + buttonHeight + spacing + 2;
+
+    limiterCeilingLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
+    limiterCeilingSlider.setBounds (margin, y + labelHeight + 2, getWidth() - 2 * margin, sliderHeight);
+    y += labelHeight + sliderHeight + spacing + 2;
+
+    // Transport phase lock
+    phaseLockLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
+    phaseLockToggle.setBounds (margin, y + labelHeight + 2, 180, buttonHeight);
+    y += labelHeight + buttonHeight + spacing + 2;
+
+    // Spatializer
+    spatializerLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
+    spatializerToggle.setBounds (margin, y + labelHeight + 2, 180, buttonHeight);
+    y += labelHeight + buttonHeight + spacing + 2;
+
+    leftAzimuthLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
+    leftAzimuthSlider.setBounds (margin, y + labelHeight + 2, getWidth() - 2 * margin, sliderHeight);
+    y += labelHeight + sliderHeight + spacing + 2;
+
+    rightAzimuthLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
+    rightAzimuthSlider.setBounds (margin, y + labelHeight + 2, getWidth() - 2 * margin, sliderHeight);
+    y += labelHeight + sliderHeight + spacing + 2;
+
+    // Background layer
+    backgroundVolumeLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
+    backgroundVolumeSlider.setBounds (margin, y + labelHeight + 2, getWidth() - 2 * margin, sliderHeight);
+    y += labelHeight + sliderHeight + spacing + 2;
+
+    loadBackgroundButton.setBounds (margin, y, 130, comboHeight);
+    clearBackgroundButton.setBounds (margin + 140, y, 80, comboHeight);
+    backgroundFileLabel.setBounds (margin + 230, y, getWidth() - 2 * margin - 230, comboHeight);
+    y += comboHeight + spacing;
+
+    // Modulation: shape, target and evaluation on one row, rate and depth below
+    y += spacing * 2;
+    modulationSectionLabel.setBounds (margin, y, getWidth() - 2 * margin, 20);
+    y += 25;
+
+    for (auto& slot : modulationSlots)
+    {
+        const auto rowWidth = getWidth() - 2 * margin;
+        const auto halfWidth = (rowWidth - spacing) / 2;
+
+        slot.label.setBounds (margin, y, rowWidth, labelHeight);
+        y += labelHeight + 2;
+
+        slot.shapeComboBox.setBounds (margin, y, 140, comboHeight);
+        slot.targetComboBox.setBounds (margin + 150, y, rowWidth - 150 - 110, comboHeight);
+        slot.audioRateToggle.setBounds (getWidth() - margin - 100, y, 100, comboHeight);
+        y += comboHeight + 4;
+
+        slot.rateSlider.setBounds (margin, y, halfWidth, sliderHeight);
+        slot.depthSlider.setBounds (margin + halfWidth + spacing, y, halfWidth, sliderHeight);
+        y += sliderHeight + spacing;
+    }
     
     // Export section (only in standalone)
     #if JucePlugin_Build_Standalone
@@ -174,6 +289,20 @@ void BinauralAudioProcessorEditor::resized()
         y += labelHeight + comboHeight + spacing + 2;
     }
     
+    // Loudness target
+    loudnessLabel.setBounds (margin, y, getWidth() - 2 * margin, labelHeight);
+    loudnessComboBox.setBounds (margin, y + labelHeight + 2, getWidth() - 2 * margin, comboHeight);
+    y += labelHeight + comboHeight + spacing + 2;
+
+    // Seamless loop
+    loopToggle.setBounds (margin, y, getWidth() - 2 * margin, comboHeight);
+    y += comboHeight + spacing;
+
+    // Preview of the planned export
+    const int previewHeight = 120;
+    exportPreview.setBounds (margin, y, getWidth() - 2 * margin, previewHeight);
+    y += previewHeight + spacing;
+    
     // Export button
     exportButton.setBounds (margin, y, getWidth() - 2 * margin, 38);
     y += 38 + spacing;
@@ -234,14 +363,9 @@ void BinauralAudioProcessorEditor::setupComboBox (juce::ComboBox& comboBox, juce
 {
     addAndMakeVisible (comboBox);
     
-    // Add presets to combo box
-    comboBox.addItem ("Custom", 1);
-    for (int i = 0; i < BinauralPresets::NUM_PRESETS; ++i)
-    {
-        const auto& preset = BinauralPresets::ALL_PRESETS[i];
-        comboBox.addItem (preset.name + " - " + preset.description, i + 2);
-    }
-    comboBox.setSelectedId (1); // Default to Custom
+    // Typing a name jumps to the first preset that starts with it
+    comboBox.setEditableText (true);
+    populatePresetPage (0); // Custom selected
     comboBox.onChange = [this] { presetComboBoxChanged(); };
 
     addAndMakeVisible (label);
@@ -253,13 +377,228 @@ void BinauralAudioProcessorEditor::setupComboBox (juce::ComboBox& comboBox, juce
 void BinauralAudioProcessorEditor::presetComboBoxChanged()
 {
     int selectedId = presetComboBox.getSelectedId();
-    
+
+    if (selectedId == previousPageId || selectedId == nextPageId)
+    {
+        populatePresetPage (presetPage + (selectedId == nextPageId ? 1 : -1));
+
+        // Keep browsing: reopen the list on the new page
+        juce::Component::SafePointer<juce::ComboBox> comboBox (&presetComboBox);
+        juce::MessageManager::callAsync ([comboBox]
+        {
+            if (comboBox != nullptr)
+                comboBox->showPopup();
+        });
+        return;
+    }
+
+    if (selectedId == 0) // Typed text
+    {
+        auto& database = audioProcessor.getPresetDatabase();
+        const auto text = presetComboBox.getText().trim();
+        auto presetIndex = database.findByName (text);
+
+        // A typed frequency ("432", "432 Hz") picks the preset with the nearest base frequency
+        if (presetIndex < 0 && text.isNotEmpty() && text.containsOnly ("0123456789.,Hhz "))
+            presetIndex = database.findNearestFrequency (text.replaceCharacter (',', '.').getFloatValue());
+
+        if (presetIndex < 0)
+        {
+            showSelectedPreset();
+            return;
+        }
+
+        selectedPresetIndex = presetIndex;
+        audioProcessor.applyPreset (presetIndex);
+        populatePresetPage (juce::jmax (0, database.getBandOrderPosition (presetIndex)) / presetsPerPage);
+        return;
+    }
+
     if (selectedId == 1) // Custom
+    {
+        selectedPresetIndex = -1;
         return;
+    }
     
     // Apply preset (selectedId - 2 because Custom is 1, first preset is 2)
-    int presetIndex = selectedId - 2;
-    audioProcessor.applyPreset (presetIndex);
+    selectedPresetIndex = selectedId - 2;
+    audioProcessor.applyPreset (selectedPresetIndex);
+}
+
+void BinauralAudioProcessorEditor::populatePresetPage (int page)
+{
+    auto& database = audioProcessor.getPresetDatabase();
+    const auto numPresets = database.getNumPresets();
+    const auto numPages = juce::jmax (1, (numPresets + presetsPerPage - 1) / presetsPerPage);
+
+    presetPage = juce::jlimit (0, numPages - 1, page);
+    presetComboBox.clear (juce::dontSendNotification);
+    presetComboBox.addItem ("Custom", 1);
+
+    if (presetPage > 0)
+        presetComboBox.addItem ("< Previous " + juce::String (presetsPerPage), previousPageId);
+
+    // Band order, with a heading where each band starts
+    const auto first = presetPage * presetsPerPage;
+    const auto last = juce::jmin (numPresets, first + presetsPerPage);
+    int currentBand = -1;
+
+    for (int position = first; position < last; ++position)
+    {
+        const auto presetIndex = database.getIndexInBandOrder (position);
+        PresetDatabase::Preset preset;
+
+        if (! database.getPreset (presetIndex, preset))
+            continue;
+
+        if ((int) preset.band != currentBand)
+        {
+            currentBand = (int) preset.band;
+            presetComboBox.addSectionHeading (PresetDatabase::getBandName (preset.band));
+        }
+
+        presetComboBox.addItem (preset.name + " - " + preset.description, presetIndex + 2);
+    }
+
+    if (last < numPresets)
+        presetComboBox.addItem ("Next " + juce::String (juce::jmin (presetsPerPage, numPresets - last)) + " >", nextPageId);
+
+    showSelectedPreset();
+}
+
+void BinauralAudioProcessorEditor::showSelectedPreset()
+{
+    if (selectedPresetIndex < 0)
+    {
+        presetComboBox.setSelectedId (1, juce::dontSendNotification);
+        return;
+    }
+
+    // The selection may be on another page: show its name instead
+    if (presetComboBox.indexOfItemId (selectedPresetIndex + 2) >= 0)
+    {
+        presetComboBox.setSelectedId (selectedPresetIndex + 2, juce::dontSendNotification);
+        return;
+    }
+
+    PresetDatabase::Preset preset;
+
+    if (audioProcessor.getPresetDatabase().getPreset (selectedPresetIndex, preset))
+        presetComboBox.setText (preset.name + " - " + preset.description, juce::dontSendNotification);
+}
+
+//==============================================================================
+void BinauralAudioProcessorEditor::setupBackgroundControls()
+{
+    addAndMakeVisible (loadBackgroundButton);
+    loadBackgroundButton.setButtonText ("Background...");
+    loadBackgroundButton.onClick = [this] { loadBackgroundClicked(); };
+
+    addAndMakeVisible (clearBackgroundButton);
+    clearBackgroundButton.setButtonText ("Clear");
+    clearBackgroundButton.onClick = [this]
+    {
+        audioProcessor.clearBackgroundFile();
+        updateBackgroundFileLabel();
+    };
+
+    addAndMakeVisible (backgroundFileLabel);
+    backgroundFileLabel.setColour (juce::Label::textColourId, juce::Colours::lightblue);
+    backgroundFileLabel.setJustificationType (juce::Justification::centredLeft);
+    updateBackgroundFileLabel();
+}
+
+void BinauralAudioProcessorEditor::setupModulationControls()
+{
+    addAndMakeVisible (modulationSectionLabel);
+    modulationSectionLabel.setText ("Modulation", juce::dontSendNotification);
+    modulationSectionLabel.setFont (juce::FontOptions (18.0f));
+    modulationSectionLabel.setFont (modulationSectionLabel.getFont().boldened());
+    modulationSectionLabel.setColour (juce::Label::textColourId, juce::Colours::lightblue);
+    modulationSectionLabel.setJustificationType (juce::Justification::centredLeft);
+
+    auto& state = audioProcessor.getValueTreeState();
+
+    for (int i = 0; i < BinauralAudioProcessor::numModulationSlots; ++i)
+    {
+        auto& slot = modulationSlots[(size_t) i];
+        auto parameterID = [i] (const char* prefix) { return BinauralAudioProcessor::getModulationParameterID (prefix, i); };
+
+        addAndMakeVisible (slot.label);
+        slot.label.setText ("Modulation " + juce::String (i + 1), juce::dontSendNotification);
+        slot.label.setColour (juce::Label::textColourId, juce::Colours::white);
+
+        addAndMakeVisible (slot.shapeComboBox);
+        slot.shapeComboBox.addItemList ({ "Off", "Sine", "Triangle", "Random Walk", "Ramp Up", "Ramp Down" }, 1);
+
+        addAndMakeVisible (slot.targetComboBox);
+        slot.targetComboBox.addItemList ({ "Base Frequency", "Binaural Offset", "Left Volume",
+                                           "Right Volume", "Master Volume", "Background Volume" }, 1);
+        slot.targetComboBox.onChange = [this, &slot] { updateModulationDepthSuffix (slot); };
+
+        addAndMakeVisible (slot.audioRateToggle);
+        slot.audioRateToggle.setButtonText ("Audio Rate");
+
+        for (auto* slider : { &slot.rateSlider, &slot.depthSlider })
+        {
+            addAndMakeVisible (*slider);
+            slider->setSliderStyle (juce::Slider::LinearHorizontal);
+            slider->setTextBoxStyle (juce::Slider::TextBoxRight, false, 80, 20);
+        }
+
+        slot.rateSlider.setTextValueSuffix (" Hz");
+
+        slot.shapeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+            state, parameterID (BinauralAudioProcessor::MOD_SHAPE_ID), slot.shapeComboBox);
+        slot.targetAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+            state, parameterID (BinauralAudioProcessor::MOD_TARGET_ID), slot.targetComboBox);
+        slot.audioRateAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+            state, parameterID (BinauralAudioProcessor::MOD_AUDIO_RATE_ID), slot.audioRateToggle);
+        slot.rateAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+            state, parameterID (BinauralAudioProcessor::MOD_RATE_ID), slot.rateSlider);
+        slot.depthAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+            state, parameterID (BinauralAudioProcessor::MOD_DEPTH_ID), slot.depthSlider);
+
+        updateModulationDepthSuffix (slot);
+    }
+}
+
+void BinauralAudioProcessorEditor::updateModulationDepthSuffix (ModulationSlot& slot)
+{
+    // Depth is in hertz on the frequency targets and in decibels on the volumes
+    const auto target = (ModulationEngine::Target) juce::jmax (0, slot.targetComboBox.getSelectedItemIndex());
+    slot.depthSlider.setTextValueSuffix (ModulationEngine::isFrequencyTarget (target) ? " Hz" : " dB");
+}
+
+void BinauralAudioProcessorEditor::loadBackgroundClicked()
+{
+    backgroundChooser = std::make_unique<juce::FileChooser> ("Select Background Audio...",
+                                                             juce::File::getSpecialLocation (juce::File::userDocumentsDirectory),
+                                                             audioProcessor.getFormatManager().getWildcardForAllFormats());
+
+    auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+
+    backgroundChooser->launchAsync (flags, [this] (const juce::FileChooser& chooser)
+    {
+        auto file = chooser.getResult();
+
+        if (file == juce::File())
+            return; // User cancelled
+
+        if (! audioProcessor.loadBackgroundFile (file))
+            juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon,
+                                                    "Background Audio",
+                                                    "Could not open:\n" + file.getFullPathName());
+
+        updateBackgroundFileLabel();
+    });
+}
+
+void BinauralAudioProcessorEditor::updateBackgroundFileLabel()
+{
+    auto file = audioProcessor.getBackgroundFile();
+    backgroundFileLabel.setText (file == juce::File() ? juce::String ("No background") : file.getFileName(),
+                                 juce::dontSendNotification);
 }
 
 //==============================================================================
@@ -322,6 +661,28 @@ void BinauralAudioProcessorEditor::setupExportControls()
     mp3BitrateLabel.setColour (juce::Label::textColourId, juce::Colours::white);
     mp3BitrateLabel.setVisible (false);
     
+    // Loudness target (single-pass normalisation)
+    addAndMakeVisible (loudnessComboBox);
+    loudnessComboBox.addItem ("Off (use Master Volume)", 1);
+    loudnessComboBox.addItem ("-14 LUFS", 2);
+    loudnessComboBox.addItem ("-16 LUFS", 3);
+    loudnessComboBox.addItem ("-18 LUFS", 4);
+    loudnessComboBox.addItem ("-23 LUFS (EBU R128)", 5);
+    loudnessComboBox.setSelectedId (1);
+    
+    addAndMakeVisible (loudnessLabel);
+    loudnessLabel.setText ("Loudness Target", juce::dontSendNotification);
+    loudnessLabel.attachToComponent (&loudnessComboBox, false);
+    loudnessLabel.setColour (juce::Label::textColourId, juce::Colours::white);
+    
+    // Seamless loop: the duration becomes the loop length
+    addAndMakeVisible (loopToggle);
+    loopToggle.setButtonText ("Seamless Loop (duration = loop length)");
+    loopToggle.setColour (juce::ToggleButton::textColourId, juce::Colours::white);
+    
+    // Overview of what the export will contain, without rendering it
+    addAndMakeVisible (exportPreview);
+    
     // Export button
     addAndMakeVisible (exportButton);
     updateExportButtonText();
@@ -372,22 +733,12 @@ void BinauralAudioProcessorEditor::exportButtonClicked()
 
 void BinauralAudioProcessorEditor::startExport()
 {
-    // Get preset from main preset selector
-    int selectedPresetId = presetComboBox.getSelectedId();
-    
-    // If Custom is selected, we'll export with current parameters
-    // Otherwise, use the selected preset
-    int presetIndex = -1; // -1 means use current parameters (Custom)
+    // Preset from the main preset selector, which may be on another page by now.
+    // -1 means use current parameters (Custom)
+    int presetIndex = selectedPresetIndex;
     
-    if (selectedPresetId > 1) // Not Custom (Custom is ID 1)
-    {
-        // Convert ComboBox ID to preset index (ID 2 = preset 0, ID 3 = preset 1, etc.)
-        presetIndex = selectedPresetId - 2;
-        
-        // Validate preset index
-        if (presetIndex < 0 || presetIndex >= BinauralPresets::NUM_PRESETS)
-            return;
-    }
+    if (presetIndex >= audioProcessor.getPresetDatabase().getNumPresets())
+        return;
     
     double durationMinutes = durationSlider.getValue();
     double durationSeconds = durationMinutes * 60.0;
@@ -408,6 +759,15 @@ void BinauralAudioProcessorEditor::startExport()
             else if (bitrateId == 4) mp3Bitrate = 320;
         }
         
+        // Loudness target, if any
+        std::optional<double> targetLoudness;
+        const double loudnessTargets[] = { -14.0, -16.0, -18.0, -23.0 };
+        
+        if (loudnessComboBox.getSelectedId() > 1)
+            targetLoudness = loudnessTargets[loudnessComboBox.getSelectedId() - 2];
+        
+        const bool seamlessLoop = loopToggle.getToggleState();
+        
         // Create file chooser with appropriate extension
         juce::String extension = formatIsMP3 ? "*.mp3" : "*.wav";
         fileChooser = std::make_unique<juce::FileChooser> ("Save Binaural Audio As...",
@@ -416,7 +776,7 @@ void BinauralAudioProcessorEditor::startExport()
         
         auto flags = juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles;
         
-        fileChooser->launchAsync (flags, [this, presetIndex, durationSeconds, format, mp3Bitrate] (const juce::FileChooser& chooser)
+        fileChooser->launchAsync (flags, [this, presetIndex, durationSeconds, format, mp3Bitrate, targetLoudness, seamlessLoop] (const juce::FileChooser& chooser)
         {
             auto file = chooser.getResult();
             
@@ -454,6 +814,9 @@ void BinauralAudioProcessorEditor::startExport()
             durationSeconds,
             format,
             mp3Bitrate,
+            audioProcessor.getBackgroundFile(),
+            targetLoudness,
+            seamlessLoop,
             [this] (double progress)
             {
                 // Update progress on message thread
@@ -482,7 +845,10 @@ void BinauralAudioProcessorEditor::startExport()
                     {
                         juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::InfoIcon,
                                                                 "Export Complete",
-                                                                "Audio exported successfully to:\n" + file.getFullPathName());
+                                                                "Audio exported successfully to:\n" + file.getFullPathName()
+                                                                    + "\n\nIntegrated loudness: "
+                                                                    + juce::String (audioProcessor.getLastExportLoudness(), 1)
+                                                                    + " LUFS");
                     }
                     else
                     {
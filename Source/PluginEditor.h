@@ -3,6 +3,8 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "PluginProcessor.h"
+#include "SpectrumAnalyzer.h"
+#include "ExportPreviewView.h"
 
 //==============================================================================
 /**
@@ -22,6 +24,9 @@ private:
     // Reference to processor
     BinauralAudioProcessor& audioProcessor;
 
+    // Spectrum and beat-envelope display
+    SpectrumAnalyzer spectrumAnalyzer;
+
     // UI Components
     juce::Slider baseFrequencySlider;
     juce::Label baseFrequencyLabel;
@@ -33,11 +38,50 @@ private:
     juce::Label rightVolumeLabel;
     juce::Slider masterVolumeSlider;
     juce::Label masterVolumeLabel;
+    juce::ToggleButton limiterToggle;
+    juce::Label limiterLabel;
+    juce::Slider limiterCeilingSlider;
+    juce::Label limiterCeilingLabel;
+    juce::ToggleButton phaseLockToggle;
+    juce::Label phaseLockLabel;
     juce::ToggleButton modeToggle;
     juce::Label modeLabel;
     juce::ToggleButton muteButton;
+    juce::ComboBox midiModeComboBox;
+    juce::Label midiModeLabel;
     juce::ComboBox presetComboBox;
     juce::Label presetLabel;
+    juce::ToggleButton spatializerToggle;
+    juce::Label spatializerLabel;
+    juce::Slider leftAzimuthSlider;
+    juce::Label leftAzimuthLabel;
+    juce::Slider rightAzimuthSlider;
+    juce::Label rightAzimuthLabel;
+    juce::Slider backgroundVolumeSlider;
+    juce::Label backgroundVolumeLabel;
+    juce::TextButton loadBackgroundButton;
+    juce::TextButton clearBackgroundButton;
+    juce::Label backgroundFileLabel;
+
+    // One row of built-in modulation per slot
+    struct ModulationSlot
+    {
+        juce::Label label;
+        juce::ComboBox shapeComboBox;
+        juce::ComboBox targetComboBox;
+        juce::ToggleButton audioRateToggle;
+        juce::Slider rateSlider;
+        juce::Slider depthSlider;
+
+        std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> shapeAttachment;
+        std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> targetAttachment;
+        std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> audioRateAttachment;
+        std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> rateAttachment;
+        std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> depthAttachment;
+    };
+
+    juce::Label modulationSectionLabel;
+    std::array<ModulationSlot, BinauralAudioProcessor::numModulationSlots> modulationSlots;
     
     // Export controls (only visible in standalone)
     juce::TextButton exportButton;
@@ -48,16 +92,33 @@ private:
     juce::Label formatLabel;
     juce::ComboBox mp3BitrateComboBox;
     juce::Label mp3BitrateLabel;
+    juce::ComboBox loudnessComboBox;
+    juce::Label loudnessLabel;
+    juce::ToggleButton loopToggle;
     juce::Label exportSectionLabel;
 
+    // Overview of the planned export, refined as it is zoomed
+    ExportPreviewView exportPreview;
+
+    // Sample rate of exports from the editor
+    static constexpr double exportSampleRate = 44100.0;
+
     // Parameter attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> baseFrequencyAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> binauralOffsetAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> leftVolumeAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> rightVolumeAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> masterVolumeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> limiterAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> limiterCeilingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> phaseLockAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> modeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> midiModeAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> muteAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> spatializerAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> leftAzimuthAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> rightAzimuthAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> backgroundVolumeAttachment;
 
     // Helper methods
     void setupSlider (juce::Slider& slider, juce::Label& label, const juce::String& labelText);
@@ -67,6 +128,27 @@ private:
     
     // Callback for preset selection
     void presetComboBoxChanged();
+
+    // The preset list holds one page of the database at a time, so it costs
+    // the same however many presets there are
+    void populatePresetPage (int page);
+    void showSelectedPreset();
+
+    static constexpr int presetsPerPage = 100;
+    static constexpr int previousPageId = std::numeric_limits<int>::max() - 1;
+    static constexpr int nextPageId = std::numeric_limits<int>::max();
+
+    int presetPage = 0;
+    int selectedPresetIndex = -1; // -1 = Custom
+    
+    // Background layer
+    void setupBackgroundControls();
+    void loadBackgroundClicked();
+    void updateBackgroundFileLabel();
+
+    // Built-in modulation
+    void setupModulationControls();
+    void updateModulationDepthSuffix (ModulationSlot& slot);
     
     // Export functionality
     void setupExportControls();
@@ -79,6 +161,7 @@ private:
     
     // File chooser (needs to persist)
     std::unique_ptr<juce::FileChooser> fileChooser;
+    std::unique_ptr<juce::FileChooser> backgroundChooser;
     
     // Export progress dialog
     std::unique_ptr<juce::AlertWindow> progressWindow;
@@ -91,6 +174,9 @@ private:
     public:
         ExportThread (BinauralAudioProcessor& proc, const juce::File& f, int presetIdx,
                      double duration, BinauralAudioProcessor::ExportFormat fmt, int bitrate,
+                     const juce::File& background,
+                     std::optional<double> loudnessTarget,
+                     bool loop,
                      std::function<void(double)> progressCallback,
                      std::function<void(bool)> completionCallback)
             : Thread ("ExportThread"),
@@ -100,6 +186,9 @@ private:
               durationSeconds (duration),
               format (fmt),
               mp3Bitrate (bitrate),
+              backgroundFile (background),
+              targetLoudness (loudnessTarget),
+              seamlessLoop (loop),
               onProgress (progressCallback),
               onComplete (completionCallback)
         {
@@ -117,7 +206,9 @@ private:
                 if (i == 0)
                 {
                     // Start export
-                    success = processor.exportAudio (file, presetIndex, durationSeconds, format, mp3Bitrate);
+                    success = processor.exportAudio (file, presetIndex, durationSeconds, format, mp3Bitrate,
+                                                     exportSampleRate, nullptr, backgroundFile, targetLoudness,
+                                                     seamlessLoop);
                 }
                 
                 // Update progress (estimate based on time)
@@ -140,6 +231,9 @@ private:
         double durationSeconds;
         BinauralAudioProcessor::ExportFormat format;
         int mp3Bitrate;
+        juce::File backgroundFile;
+        std::optional<double> targetLoudness;
+        bool seamlessLoop;
         std::function<void(double)> onProgress;
         std::function<void(bool)> onComplete;
     };
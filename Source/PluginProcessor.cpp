@@ -1,7 +1,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include <functional>
-#include "Presets.h"
 #include <juce_audio_formats/juce_audio_formats.h>
 
 //==============================================================================
@@ -18,10 +17,34 @@ BinauralAudioProcessor::BinauralAudioProcessor()
      parameters (*this, nullptr, juce::Identifier ("BinauralGenerator"), createParameterLayout())
 #endif
 {
+    formatManager.registerBasicFormats();
+
+    for (int slot = 0; slot < numModulationSlots; ++slot)
+    {
+        auto& values = modulationValues[(size_t) slot];
+        values.shape = parameters.getRawParameterValue (getModulationParameterID (MOD_SHAPE_ID, slot));
+        values.target = parameters.getRawParameterValue (getModulationParameterID (MOD_TARGET_ID, slot));
+        values.rate = parameters.getRawParameterValue (getModulationParameterID (MOD_RATE_ID, slot));
+        values.depth = parameters.getRawParameterValue (getModulationParameterID (MOD_DEPTH_ID, slot));
+        values.audioRate = parameters.getRawParameterValue (getModulationParameterID (MOD_AUDIO_RATE_ID, slot));
+    }
+
+    for (auto* id : { SPATIALIZER_ID, LEFT_AZIMUTH_ID, RIGHT_AZIMUTH_ID })
+        parameters.addParameterListener (id, this);
+
+    for (auto& value : pendingControllerValues)
+        value = std::numeric_limits<float>::quiet_NaN();
+
+    startTimerHz (30);
 }
 
 BinauralAudioProcessor::~BinauralAudioProcessor()
 {
+    for (auto* id : { SPATIALIZER_ID, LEFT_AZIMUTH_ID, RIGHT_AZIMUTH_ID })
+        parameters.removeParameterListener (id, this);
+
+    stopTimer();
+    cancelPendingUpdate();
 }
 
 //==============================================================================
@@ -92,11 +115,67 @@ void BinauralAudioProcessor::changeProgramName (int index, const juce::String& n
 void BinauralAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     currentSampleRate = sampleRate;
-    binauralGenerator.prepare ({ sampleRate, (juce::uint32) samplesPerBlock, 2 });
+    nextPlayPosition = -1;
+
+    const auto outputLayout = getChannelLayoutOfBus (false, 0);
+    binauralGenerator.setChannelLayout (outputLayout);
+    binauralGenerator.setLimiterLookAhead (limiterLookAhead);
+    binauralGenerator.prepare ({ sampleRate, (juce::uint32) samplesPerBlock,
+                                 (juce::uint32) outputLayout.size() });
+
+    backgroundLayer.prepare (sampleRate, samplesPerBlock);
+    binauralGenerator.setBackgroundLayer (&backgroundLayer);
+
+    spatializer.setLatency (spatializerLatency);
+    spatializer.prepare ({ sampleRate, (juce::uint32) samplesPerBlock, 2 });
+    updateSpatializer();
+}
+
+bool BinauralAudioProcessor::loadBackgroundFile (const juce::File& file)
+{
+    return backgroundLayer.load (file, formatManager);
+}
+
+void BinauralAudioProcessor::clearBackgroundFile()
+{
+    backgroundLayer.unload();
+}
+
+void BinauralAudioProcessor::setSpatializerLatency (int latencyInSamples)
+{
+    spatializerLatency = juce::jmax (0, latencyInSamples);
+}
+
+void BinauralAudioProcessor::setLimiterLookAhead (int lookAheadInSamples)
+{
+    limiterLookAhead = juce::jmax (0, lookAheadInSamples);
+}
+
+void BinauralAudioProcessor::parameterChanged (const juce::String&, float)
+{
+    // May arrive on the audio thread; IR loading happens on the message thread
+    triggerAsyncUpdate();
+}
+
+void BinauralAudioProcessor::handleAsyncUpdate()
+{
+    updateSpatializer();
+}
+
+void BinauralAudioProcessor::updateSpatializer()
+{
+    spatializer.setPositions (parameters.getRawParameterValue (LEFT_AZIMUTH_ID)->load(),
+                              parameters.getRawParameterValue (RIGHT_AZIMUTH_ID)->load());
+
+    const auto spatializerOn = parameters.getRawParameterValue (SPATIALIZER_ID)->load() > 0.5f
+                            && getTotalNumOutputChannels() == 2;
+    setLatencySamples (binauralGenerator.getLatencySamples()
+                        + (spatializerOn ? spatializer.getLatencySamples() : 0));
 }
 
 void BinauralAudioProcessor::releaseResources()
 {
+    midiControl.reset (binauralGenerator);
     binauralGenerator.reset();
 }
 
@@ -106,20 +185,22 @@ bool BinauralAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // Support stereo output
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
+    // Mono (monaural mix), stereo, quad, 5.1, 7.1 and first-order ambisonics
+    const auto& output = layouts.getMainOutputChannelSet();
 
-    return true;
+    return output == juce::AudioChannelSet::mono()
+        || output == juce::AudioChannelSet::stereo()
+        || output == juce::AudioChannelSet::quadraphonic()
+        || output == juce::AudioChannelSet::create5point1()
+        || output == juce::AudioChannelSet::create7point1()
+        || output == juce::AudioChannelSet::ambisonic (1);
   #endif
 }
 
 void BinauralAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                               juce::MidiBuffer& midiMessages)
 {
-    juce::ignoreUnused (midiMessages);
-
+    BINAURAL_REALTIME_SCOPE;
     juce::ScopedNoDenormals noDenormals;
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -127,39 +208,176 @@ void BinauralAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     for (auto i = getTotalNumInputChannels(); i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    // Check if muted
-    auto isMuted = parameters.getRawParameterValue (MUTE_ID)->load() > 0.5f;
-    
-    if (isMuted)
-    {
-        // Clear buffer if muted
-        buffer.clear();
-        return;
-    }
+    // MIDI mode; a change releases every note
+    const auto midiMode = (MidiCarrierControl::Mode) juce::roundToInt (
+        parameters.getRawParameterValue (MIDI_MODE_ID)->load());
+    midiControl.setMode (midiMode, binauralGenerator);
+
+    // Read before the parameters and presetPublished after them, like a
+    // sequence lock: a preset published meanwhile is taken whole below
+    const auto settledPreset = presetSettled.load();
 
-    // Update parameters
     auto baseFreq = parameters.getRawParameterValue (BASE_FREQUENCY_ID)->load();
-    auto offset = parameters.getRawParameterValue (BINAURAL_OFFSET_ID)->load();
-    auto leftVol = parameters.getRawParameterValue (LEFT_VOLUME_ID)->load();
-    auto rightVol = parameters.getRawParameterValue (RIGHT_VOLUME_ID)->load();
-    auto masterVol = parameters.getRawParameterValue (MASTER_VOLUME_ID)->load();
+
+    // Muting fades out and then idles the generator, which keeps the carrier
+    // phases moving so unmuting fades back in without a click
+    binauralGenerator.setMuted (parameters.getRawParameterValue (MUTE_ID)->load() > 0.5f);
+
+    // Update parameters
+    auto offset = getControlledValue (0, BINAURAL_OFFSET_ID);
+    auto leftVol = getControlledValue (2, LEFT_VOLUME_ID);
+    auto rightVol = getControlledValue (3, RIGHT_VOLUME_ID);
+    auto masterVol = getControlledValue (1, MASTER_VOLUME_ID);
     auto mode = parameters.getRawParameterValue (MODE_ID)->load() > 0.5f;
+    auto backgroundVol = parameters.getRawParameterValue (BACKGROUND_VOLUME_ID)->load();
+    auto limiterOn = parameters.getRawParameterValue (LIMITER_ID)->load() > 0.5f;
+    auto limiterCeiling = parameters.getRawParameterValue (LIMITER_CEILING_ID)->load();
+
+    // A preset still being applied: all of it in this block, so base and
+    // offset start gliding on the same sample
+    if (presetPublished.load() != settledPreset)
+    {
+        const auto preset = presetTarget.load();
+        baseFreq = preset.baseFrequency;
+        offset = preset.offset;
+        mode = true;
+    }
 
-    // Update generator
-    binauralGenerator.setBaseFrequency (baseFreq);
+    // Update generator; a held mono note overrides the base frequency
+    binauralGenerator.setBaseFrequency (midiControl.hasHeldNote() ? midiControl.getHeldNoteFrequency() : baseFreq);
     binauralGenerator.setBinauralOffset (offset);
-    binauralGenerator.setLeftVolume (juce::Decibels::decibelsToGain (leftVol));
-    binauralGenerator.setRightVolume (juce::Decibels::decibelsToGain (rightVol));
-    binauralGenerator.setMasterVolume (juce::Decibels::decibelsToGain (masterVol));
+    binauralGenerator.setLeftVolume (BinauralGenerator::volumeToGain (leftVol));
+    binauralGenerator.setRightVolume (BinauralGenerator::volumeToGain (rightVol));
+    binauralGenerator.setMasterVolume (BinauralGenerator::volumeToGain (masterVol));
+    binauralGenerator.setBackgroundVolume (BinauralGenerator::volumeToGain (backgroundVol));
+    binauralGenerator.setLimiterEnabled (limiterOn);
+    binauralGenerator.setLimiterCeiling (juce::Decibels::decibelsToGain (limiterCeiling));
     binauralGenerator.setMode (mode ? BinauralGenerator::Mode::Binaural 
                                      : BinauralGenerator::Mode::Manual);
+    binauralGenerator.setModulation (getModulationPatch());
 
-    // Process audio
+    // Phase lock: when the host starts, seeks or loops, the carrier phase is
+    // set from the timeline so bounces and seeks always produce the same
+    // waveform. Consecutive blocks carry on from there, so glides, MIDI and
+    // modulation stay continuous
+    std::optional<juce::int64> lockedPosition;
+
+    if (parameters.getRawParameterValue (PHASE_LOCK_ID)->load() > 0.5f)
+        if (auto* playHead = getPlayHead())
+            if (const auto playPosition = playHead->getPosition())
+                if (const auto timeInSamples = playPosition->getTimeInSamples(); timeInSamples && playPosition->getIsPlaying())
+                    lockedPosition = *timeInSamples;
+
+    if (lockedPosition.has_value() && *lockedPosition != nextPlayPosition)
+        binauralGenerator.syncToPosition (*lockedPosition);
+
+    nextPlayPosition = lockedPosition.has_value() ? *lockedPosition + buffer.getNumSamples() : -1;
+
+    // Process audio, split at each MIDI event so it lands on its exact sample
     juce::dsp::AudioBlock<float> block (buffer);
     juce::dsp::ProcessContextReplacing<float> context (block);
+
+    const auto numSamples = buffer.getNumSamples();
+    int position = 0;
+
+    for (const auto metadata : midiMessages)
+    {
+        const auto eventPosition = juce::jlimit (position, numSamples, metadata.samplePosition);
+        renderCarriers (block, position, eventPosition - position);
+        position = eventPosition;
+
+        handleMidiMessage (metadata.getMessage(), baseFreq);
+    }
+
+    renderCarriers (block, position, numSamples - position);
+
+    // An idle generator wrote silence; the spatializer only runs until it
+    // has played out its tail
+    idleSamples = binauralGenerator.isIdle() ? juce::jmin (idleSamples + numSamples, std::numeric_limits<int>::max() / 2) : 0;
+    const auto spatializerSilent = idleSamples > 0 && idleSamples - numSamples >= spatializer.getTailSamples();
+
+    // HRTF placement of the carriers (headphone outputs only)
+    if (parameters.getRawParameterValue (SPATIALIZER_ID)->load() > 0.5f && buffer.getNumChannels() == 2
+        && ! spatializerSilent)
+        spatializer.process (context);
+
+    // Visual feedback; a single flag check when no editor is open
+    if (analyzerFeed.isActive())
+        analyzerFeed.push (buffer.getReadPointer (0),
+                           buffer.getReadPointer (juce::jmin (1, buffer.getNumChannels() - 1)),
+                           buffer.getNumSamples());
+}
+
+void BinauralAudioProcessor::renderCarriers (juce::dsp::AudioBlock<float>& block, int startSample, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    auto subBlock = block.getSubBlock ((size_t) startSample, (size_t) numSamples);
+    juce::dsp::ProcessContextReplacing<float> context (subBlock);
     binauralGenerator.process (context);
 }
 
+void BinauralAudioProcessor::handleMidiMessage (const juce::MidiMessage& message, float parameterBaseFrequency)
+{
+    if (! message.isController() || message.isAllNotesOff() || message.isAllSoundOff())
+    {
+        midiControl.handleMessage (message, binauralGenerator, parameterBaseFrequency);
+        return;
+    }
+
+    // Controllers drive the generator directly, so the change lands on this
+    // sample, and their parameter from the message thread (so hosts and the
+    // editor follow)
+    int controller;
+
+    switch (message.getControllerNumber())
+    {
+        case 1:   controller = 0; break;
+        case 7:   controller = 1; break;
+        case 12:  controller = 2; break;
+        case 13:  controller = 3; break;
+        default:  return;
+    }
+
+    const auto* parameterID = controllerParameterIDs[controller];
+    const auto normalised = (float) message.getControllerValue() / 127.0f;
+    const auto value = parameters.getParameterRange (parameterID).convertFrom0to1 (normalised);
+    pendingControllerValues[(size_t) controller] = value;
+
+    switch (controller)
+    {
+        case 0:   binauralGenerator.setBinauralOffset (value); break;
+        case 1:   binauralGenerator.setMasterVolume (BinauralGenerator::volumeToGain (value)); break;
+        case 2:   binauralGenerator.setLeftVolume (BinauralGenerator::volumeToGain (value)); break;
+        default:  binauralGenerator.setRightVolume (BinauralGenerator::volumeToGain (value)); break;
+    }
+}
+
+float BinauralAudioProcessor::getControlledValue (int controller, const char* parameterID) const noexcept
+{
+    const auto pending = pendingControllerValues[(size_t) controller].load();
+    return std::isnan (pending) ? parameters.getRawParameterValue (parameterID)->load() : pending;
+}
+
+void BinauralAudioProcessor::timerCallback()
+{
+    for (int controller = 0; controller < numControllers; ++controller)
+    {
+        auto& slot = pendingControllerValues[(size_t) controller];
+        auto pending = slot.load();
+
+        if (std::isnan (pending))
+            continue;
+
+        auto* parameter = parameters.getParameter (controllerParameterIDs[controller]);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (pending));
+
+        // The parameter holds it now; unless a newer value arrived meanwhile
+        slot.compare_exchange_strong (pending, std::numeric_limits<float>::quiet_NaN());
+    }
+}
+
 //==============================================================================
 bool BinauralAudioProcessor::hasEditor() const
 {
@@ -174,18 +392,40 @@ juce::AudioProcessorEditor* BinauralAudioProcessor::createEditor()
 //==============================================================================
 void BinauralAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    SessionState::Contents contents;
+    contents.backgroundFile = getBackgroundFile().getFullPathName();
+    SessionState::write (*this, contents, destData);
 }
 
 void BinauralAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    if (SessionState::isBinaryState (data, sizeInBytes))
+    {
+        SessionState::Contents contents;
+
+        if (SessionState::read (data, sizeInBytes, *this, contents))
+            restoreBackgroundFile (contents.backgroundFile);
+
+        return;
+    }
+
+    // Sessions saved before the binary format stored the parameter tree as XML
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
 
     if (xmlState.get() != nullptr)
         if (xmlState->hasTagName (parameters.state.getType()))
+        {
             parameters.replaceState (juce::ValueTree::fromXml (*xmlState));
+            restoreBackgroundFile (parameters.state.getProperty ("backgroundFile").toString());
+        }
+}
+
+void BinauralAudioProcessor::restoreBackgroundFile (const juce::String& backgroundPath)
+{
+    if (backgroundPath.isEmpty())
+        clearBackgroundFile();
+    else if (juce::File (backgroundPath) != getBackgroundFile())
+        loadBackgroundFile (juce::File (backgroundPath));
 }
 
 //==============================================================================
@@ -253,39 +493,173 @@ juce::AudioProcessorValueTreeState::ParameterLayout BinauralAudioProcessor::crea
         "Mute",
         false));
 
+    params.push_back (std::make_unique<juce::AudioParameterBool>(
+        SPATIALIZER_ID,
+        "Spatializer",
+        false));
+
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        LEFT_AZIMUTH_ID,
+        "Left Azimuth",
+        juce::NormalisableRange<float> (-180.0f, 180.0f, 1.0f),
+        90.0f,
+        "deg",
+        juce::AudioProcessorParameter::genericParameter,
+        [] (float value, int) { return juce::String (value, 0) + " deg"; },
+        [] (const juce::String& text) { return text.getFloatValue(); }));
+
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        RIGHT_AZIMUTH_ID,
+        "Right Azimuth",
+        juce::NormalisableRange<float> (-180.0f, 180.0f, 1.0f),
+        -90.0f,
+        "deg",
+        juce::AudioProcessorParameter::genericParameter,
+        [] (float value, int) { return juce::String (value, 0) + " deg"; },
+        [] (const juce::String& text) { return text.getFloatValue(); }));
+
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        BACKGROUND_VOLUME_ID,
+        "Background Volume",
+        juce::NormalisableRange<float> (-60.0f, 0.0f, 0.1f),
+        -12.0f,
+        "dB",
+        juce::AudioProcessorParameter::genericParameter,
+        [] (float value, int) { return juce::String (value, 1) + " dB"; },
+        [] (const juce::String& text) { return text.getFloatValue(); }));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        MIDI_MODE_ID,
+        "MIDI Mode",
+        juce::StringArray { "Mono", "Poly", "MPE" },
+        0));
+
+    params.push_back (std::make_unique<juce::AudioParameterBool>(
+        LIMITER_ID,
+        "Limiter",
+        true));
+
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        LIMITER_CEILING_ID,
+        "Limiter Ceiling",
+        juce::NormalisableRange<float> (-12.0f, 0.0f, 0.1f),
+        -1.0f,
+        "dB",
+        juce::AudioProcessorParameter::genericParameter,
+        [] (float value, int) { return juce::String (value, 1) + " dB"; },
+        [] (const juce::String& text) { return text.getFloatValue(); }));
+
+    params.push_back (std::make_unique<juce::AudioParameterBool>(
+        PHASE_LOCK_ID,
+        "Transport Phase Lock",
+        false));
+
+    for (int slot = 0; slot < numModulationSlots; ++slot)
+    {
+        const auto name = "Mod " + juce::String (slot + 1) + " ";
+
+        params.push_back (std::make_unique<juce::AudioParameterChoice>(
+            getModulationParameterID (MOD_SHAPE_ID, slot),
+            name + "Shape",
+            juce::StringArray { "Off", "Sine", "Triangle", "Random Walk", "Ramp Up", "Ramp Down" },
+            0));
+
+        params.push_back (std::make_unique<juce::AudioParameterChoice>(
+            getModulationParameterID (MOD_TARGET_ID, slot),
+            name + "Target",
+            juce::StringArray { "Base Frequency", "Binaural Offset", "Left Volume",
+                                "Right Volume", "Master Volume", "Background Volume" },
+            1));
+
+        params.push_back (std::make_unique<juce::AudioParameterFloat>(
+            getModulationParameterID (MOD_RATE_ID, slot),
+            name + "Rate",
+            juce::NormalisableRange<float> (0.001f, 20.0f, 0.0f, 0.25f),
+            0.1f,
+            "Hz",
+            juce::AudioProcessorParameter::genericParameter,
+            [] (float value, int) { return juce::String (value, 3) + " Hz"; },
+            [] (const juce::String& text) { return text.getFloatValue(); }));
+
+        // Hertz on the frequency targets, decibels on the volumes (which only attenuate)
+        params.push_back (std::make_unique<juce::AudioParameterFloat>(
+            getModulationParameterID (MOD_DEPTH_ID, slot),
+            name + "Depth",
+            juce::NormalisableRange<float> (-100.0f, 100.0f, 0.01f),
+            0.0f,
+            juce::String(),
+            juce::AudioProcessorParameter::genericParameter,
+            [] (float value, int) { return juce::String (value, 2); },
+            [] (const juce::String& text) { return text.getFloatValue(); }));
+
+        params.push_back (std::make_unique<juce::AudioParameterBool>(
+            getModulationParameterID (MOD_AUDIO_RATE_ID, slot),
+            name + "Audio Rate",
+            false));
+    }
+
     return { params.begin(), params.end() };
 }
 
 //==============================================================================
 void BinauralAudioProcessor::applyPreset (int presetIndex)
 {
-    if (presetIndex < 0 || presetIndex >= BinauralPresets::NUM_PRESETS)
-        return;
+    PresetDatabase::Preset preset;
 
-    const auto& preset = BinauralPresets::ALL_PRESETS[presetIndex];
-    
-    // Update parameters
-    parameters.getParameter (BASE_FREQUENCY_ID)->setValueNotifyingHost (
-        parameters.getParameterRange (BASE_FREQUENCY_ID).convertTo0to1 (preset.baseFrequency));
-    
-    parameters.getParameter (BINAURAL_OFFSET_ID)->setValueNotifyingHost (
-        parameters.getParameterRange (BINAURAL_OFFSET_ID).convertTo0to1 (preset.offset));
+    if (! presetDatabase.getPreset (presetIndex, preset))
+        return;
     
-    // Ensure mode is set to Binaural for presets
-    parameters.getParameter (MODE_ID)->setValueNotifyingHost (1.0f);
+    // Called from the editor and from exports; the audio thread never waits here
+    const juce::ScopedLock sl (presetApplyLock);
+
+    // The audio thread takes the whole preset from here until the
+    // parameters below have caught up
+    presetTarget.store ({ preset.baseFrequency, preset.offset });
+    const auto sequence = presetPublished.load() + 1;
+    presetPublished.store (sequence);
+
+    // Presets are always in Binaural mode
+    const std::pair<const char*, float> values[] =
+    {
+        { BASE_FREQUENCY_ID,  parameters.getParameterRange (BASE_FREQUENCY_ID).convertTo0to1 (preset.baseFrequency) },
+        { BINAURAL_OFFSET_ID, parameters.getParameterRange (BINAURAL_OFFSET_ID).convertTo0to1 (preset.offset) },
+        { MODE_ID,            1.0f }
+    };
+
+    // One gesture around all of them, and only the parameters that change,
+    // so auditioning presets leaves one host edit per preset
+    juce::Array<std::pair<juce::RangedAudioParameter*, float>> changes;
+
+    for (const auto& [parameterID, value] : values)
+        if (auto* parameter = parameters.getParameter (parameterID); parameter->getValue() != value)
+            changes.add ({ parameter, value });
+
+    for (const auto& change : changes)
+        change.first->beginChangeGesture();
+
+    for (const auto& change : changes)
+        change.first->setValueNotifyingHost (change.second);
+
+    for (const auto& change : changes)
+        change.first->endChangeGesture();
+
+    presetSettled.store (sequence);
 }
 
 //==============================================================================
 bool BinauralAudioProcessor::exportAudio (const juce::File& file, int presetIndex, 
                                            double durationSeconds, ExportFormat format,
                                            int mp3Bitrate, double sampleRate,
-                                           std::function<void(double)> progressCallback)
+                                           std::function<void(double)> progressCallback,
+                                           const juce::File& backgroundFile,
+                                           std::optional<double> targetLoudness,
+                                           bool seamlessLoop)
 {
     // If presetIndex is -1, use current parameters (Custom mode)
     // Otherwise, validate and apply the preset
     if (presetIndex >= 0)
     {
-        if (presetIndex >= BinauralPresets::NUM_PRESETS)
+        if (presetIndex >= presetDatabase.getNumPresets())
             return false;
         
         // Apply preset
@@ -293,32 +667,167 @@ bool BinauralAudioProcessor::exportAudio (const juce::File& file, int presetInde
     }
     // If presetIndex is -1, skip preset application and use current parameters
     
-    // Prepare processor for offline rendering
-    const int blockSize = 512;
-    prepareToPlay (sampleRate, blockSize);
-    
-    // Create temporary processor copy for rendering
-    BinauralGenerator tempGenerator;
-    tempGenerator.prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
-    
-    // Get current parameter values
-    auto baseFreq = parameters.getRawParameterValue (BASE_FREQUENCY_ID)->load();
-    auto offset = parameters.getRawParameterValue (BINAURAL_OFFSET_ID)->load();
-    auto leftVol = parameters.getRawParameterValue (LEFT_VOLUME_ID)->load();
-    auto rightVol = parameters.getRawParameterValue (RIGHT_VOLUME_ID)->load();
-    auto masterVol = parameters.getRawParameterValue (MASTER_VOLUME_ID)->load();
-    
-    tempGenerator.setBaseFrequency (baseFreq);
-    tempGenerator.setBinauralOffset (offset);
-    tempGenerator.setLeftVolume (juce::Decibels::decibelsToGain (leftVol));
-    tempGenerator.setRightVolume (juce::Decibels::decibelsToGain (rightVol));
-    tempGenerator.setMasterVolume (juce::Decibels::decibelsToGain (masterVol));
-    tempGenerator.setMode (BinauralGenerator::Mode::Binaural);
-    
-    // Create audio format writer based on selected format
-    std::unique_ptr<juce::OutputStream> fileStream (file.createOutputStream());
-    if (fileStream == nullptr)
+    // Trace of this export's stages when a trace file is set; written however it ends.
+    // The profiler belongs to this call and is attached to this thread only
+    // (and to the bed reader the renderer starts from it), so concurrent
+    // exports and playback stay out of it
+    const auto traceFile = exportTraceFile;
+    std::unique_ptr<TraceProfiler> exportTrace;
+
+    if (traceFile != juce::File())
+    {
+        exportTrace = std::make_unique<TraceProfiler>();
+        exportTrace->start();
+    }
+
+    const TraceProfiler::ScopedAttach traceAttach (exportTrace.get());
+    juce::ErasedScopeGuard traceGuard;
+
+    if (exportTrace != nullptr)
+    {
+        traceGuard = juce::ErasedScopeGuard ([trace = exportTrace.get(), traceFile]
+        {
+            trace->stop();
+            trace->writeChromeTrace (traceFile);
+            traceFile.withFileExtension ("summary.json").replaceWithText (juce::JSON::toString (trace->getSummary()));
+        });
+    }
+
+    BINAURAL_TRACE_SCOPE ("export");
+
+    auto settings = getOfflineSettings();
+    settings.backgroundFile = backgroundFile;
+
+    // Same spec as an earlier export: reuse that file instead of rendering
+    const auto cacheKey = RenderCache::makeKey (getRenderSpec (settings, sampleRate, durationSeconds, format,
+                                                               mp3Bitrate, targetLoudness, seamlessLoop));
+    juce::var cachedRender;
+    bool cached;
+
+    {
+        BINAURAL_TRACE_SCOPE ("cache lookup");
+        cached = renderCache.fetch (cacheKey, file, cachedRender);
+    }
+
+    if (cached)
+    {
+        lastExportLoudness = (double) cachedRender.getProperty ("loudness", lastExportLoudness.load());
+
+        if (seamlessLoop && format != ExportFormat::WAV)
+            writeLoopMetadata (file.withFileExtension ("loop.json"),
+                               OfflineRenderer::planLoop (settings, sampleRate, durationSeconds),
+                               sampleRate);
+
+        if (progressCallback)
+            progressCallback (1.0);
+
+        return true;
+    }
+
+    // Long WAV exports leave checkpoints next to the file and continue from
+    // one when the same export is run again
+    const auto checkpointing = format == ExportFormat::WAV && exportCheckpointSeconds > 0.0 && ! seamlessLoop
+                               && settings.backgroundFile == juce::File() && ! settings.spatializer
+                               && ! ModulationEngine::isActive (settings.modulation);
+    const auto checkpointFile = ExportCheckpoint::getFileFor (file);
+    ExportCheckpoint checkpoint;
+
+    const auto resuming = checkpointing && checkpoint.load (checkpointFile)
+                          && checkpoint.renderKey == cacheKey && file.getSize() >= checkpoint.byteOffset;
+
+    // Block size for this machine and chain; a resumed export keeps the one it started with
+    int blockSize;
+
+    {
+        BINAURAL_TRACE_SCOPE ("block size");
+        blockSize = resuming ? checkpoint.blockSize : blockSizeTuner.getBlockSize (formatManager, settings, sampleRate);
+    }
+
+    if (resuming)
+    {
+        settings.masterTrimDb = checkpoint.masterTrimDb;
+    }
+    // Loudness target: measure a short pre-render, then trim the master to match
+    else if (targetLoudness.has_value())
+    {
+        BINAURAL_TRACE_SCOPE ("loudness probe");
+        const auto probeSamples = (int) (sampleRate * juce::jmin (durationSeconds, loudnessProbeSeconds));
+
+        // A second probe corrects for what the limiter took off the first trim
+        for (int attempt = 0; attempt < 2; ++attempt)
+        {
+            const auto measured = measureLoudness (settings, sampleRate, blockSize, probeSamples);
+
+            if (! std::isfinite (measured))
+                break;
+
+            const auto error = (float) (*targetLoudness - measured);
+            settings.masterTrimDb = juce::jlimit (-60.0f, 40.0f, settings.masterTrimDb + error);
+
+            if (std::abs (error) < 0.1f)
+                break;
+        }
+    }
+
+    auto totalSamples = static_cast<juce::int64> (sampleRate * durationSeconds);
+
+    // Loop export: the duration becomes the target loop length, and the
+    // carriers may move by a few hundredths of a hertz to repeat exactly
+    SeamlessLoop::Plan loopPlan;
+
+    if (seamlessLoop)
+    {
+        loopPlan = OfflineRenderer::planLoop (settings, sampleRate, durationSeconds);
+        settings.baseFrequency = loopPlan.leftFrequency;
+        settings.binauralOffset = loopPlan.rightFrequency - loopPlan.leftFrequency;
+        totalSamples = loopPlan.lengthSamples;
+    }
+
+    OfflineRenderer renderer (formatManager);
+
+    {
+        BINAURAL_TRACE_SCOPE ("prepare");
+
+        if (! renderer.prepare (settings, sampleRate, blockSize))
+            return false;
+    }
+
+    if (seamlessLoop)
+        renderer.startLoop (loopPlan);
+
+    jassert (! checkpointing || renderer.canSaveState());
+
+    // Create audio format writer based on selected format. A fresh export
+    // removes the old file first: streams append, and it may be a hard link
+    // into the cache. A resumed one cuts the file back to the checkpoint.
+    if (! resuming)
+    {
+        file.deleteFile();
+        checkpointFile.deleteFile();
+    }
+
+    auto targetStream = std::make_unique<juce::FileOutputStream> (file);
+
+    if (targetStream->failedToOpen())
+        return false;
+
+    if (resuming && (! targetStream->setPosition (checkpoint.byteOffset) || targetStream->truncate().failed()))
         return false;
+
+    std::unique_ptr<juce::OutputStream> fileStream = std::move (targetStream);
+    ResumingOutputStream* checkpointStream = nullptr;
+
+    if (TraceProfiler::getCurrent() != nullptr)
+        fileStream = std::make_unique<TracingOutputStream> (std::move (fileStream));
+
+    if (checkpointing)
+    {
+        auto stream = std::make_unique<ResumingOutputStream> (std::move (fileStream),
+                                                              resuming ? checkpoint.dataStart : 0,
+                                                              resuming ? checkpoint.byteOffset : 0);
+        checkpointStream = stream.get();
+        fileStream = std::move (stream);
+    }
     
     std::unique_ptr<juce::AudioFormatWriter> writer;
     using Opts = juce::AudioFormatWriterOptions;
@@ -326,10 +835,23 @@ bool BinauralAudioProcessor::exportAudio (const juce::File& file, int presetInde
     if (format == ExportFormat::WAV)
     {
         juce::WavAudioFormat wavFormat;
-        writer.reset (wavFormat.createWriterFor (
-            fileStream, Opts{}.withSampleRate (sampleRate)
-                              .withNumChannels (2)
-                              .withBitsPerSample (24)).release());
+        auto options = Opts{}.withSampleRate (sampleRate)
+                             .withNumChannels (2)
+                             .withBitsPerSample (24);
+
+        // Forward loop over the whole file in the smpl chunk; the end sample is inclusive
+        if (seamlessLoop)
+            options = options.withMetadataValues ({ { "MidiUnityNote", "60" },
+                                                    { "SamplePeriod", juce::String (juce::roundToInt (1.0e9 / sampleRate)) },
+                                                    { "NumSampleLoops", "1" },
+                                                    { "Loop0Identifier", "0" },
+                                                    { "Loop0Type", "0" },
+                                                    { "Loop0Start", "0" },
+                                                    { "Loop0End", juce::String (totalSamples - 1) },
+                                                    { "Loop0Fraction", "0" },
+                                                    { "Loop0PlayCount", "0" } });
+
+        writer.reset (wavFormat.createWriterFor (fileStream, options).release());
     }
     #if JUCE_USE_LAME_AUDIO_FORMAT
     else if (format == ExportFormat::MP3)
@@ -386,32 +908,98 @@ bool BinauralAudioProcessor::exportAudio (const juce::File& file, int presetInde
     if (writer == nullptr)
         return false;
     
-    // Render audio
+    // Render audio, metering what is written
     juce::AudioBuffer<float> buffer (2, blockSize);
-    juce::MidiBuffer midiBuffer;
+    LoudnessMeter meter;
+    meter.prepare (sampleRate, 2);
     
-    const int totalSamples = static_cast<int> (sampleRate * durationSeconds);
-    int samplesRendered = 0;
+    juce::int64 samplesRendered = 0;
+
+    // The header is written by now, so this is where the audio data starts
+    const auto dataStart = checkpointStream != nullptr ? checkpointStream->getPosition() : 0;
+
+    if (resuming)
+    {
+        juce::MemoryInputStream rendererState (checkpoint.rendererState, false);
+        juce::MemoryInputStream meterState (checkpoint.meterState, false);
+
+        if (dataStart != checkpoint.dataStart || ! renderer.readState (rendererState) || ! meter.readState (meterState))
+        {
+            writer.reset();
+            checkpointFile.deleteFile();
+            return false;
+        }
+
+        // Silence for the audio already on disk: the stream drops it, but the
+        // writer counts it, so the header it finishes with covers the whole file
+        BINAURAL_TRACE_SCOPE ("resume");
+        buffer.clear();
+
+        while (samplesRendered < checkpoint.samplesWritten)
+        {
+            const int samplesToSkip = (int) juce::jmin ((juce::int64) blockSize, checkpoint.samplesWritten - samplesRendered);
+
+            if (! writer->writeFromAudioSampleBuffer (buffer, 0, samplesToSkip))
+                return false;
+
+            samplesRendered += samplesToSkip;
+        }
+    }
+
+    const auto checkpointInterval = (juce::int64) (exportCheckpointSeconds * sampleRate);
+    auto nextCheckpoint = samplesRendered + checkpointInterval;
     
     while (samplesRendered < totalSamples)
     {
-        const int samplesToRender = juce::jmin (blockSize, totalSamples - samplesRendered);
-        buffer.setSize (2, samplesToRender, false, false, true);
-        buffer.clear();
-        
-        // Generate audio
-        juce::dsp::AudioBlock<float> block (buffer);
-        juce::dsp::ProcessContextReplacing<float> context (block);
-        tempGenerator.process (context);
+        const auto samplesToRender = (int) juce::jmin ((juce::int64) blockSize, totalSamples - samplesRendered);
+
+        {
+            BINAURAL_TRACE_SCOPE ("render");
+            renderer.render (buffer, samplesToRender);
+        }
+
+        {
+            BINAURAL_TRACE_SCOPE ("meter");
+            meter.process (buffer.getArrayOfReadPointers(), 2, samplesToRender);
+        }
         
-        // Write to file
-        if (! writer->writeFromAudioSampleBuffer (buffer, 0, samplesToRender))
+        // Write to file: sample conversion, with the disk write nested inside
         {
-            writer.reset();
-            return false;
+            BINAURAL_TRACE_SCOPE ("convert");
+
+            if (! writer->writeFromAudioSampleBuffer (buffer, 0, samplesToRender))
+            {
+                writer.reset();
+                return false;
+            }
         }
         
         samplesRendered += samplesToRender;
+
+        if (auto* profiler = TraceProfiler::getCurrent())
+            profiler->addSamples (samplesToRender);
+
+        // Checkpoints fall on block boundaries, so a resumed run sees the same blocks
+        if (checkpointing && samplesRendered >= nextCheckpoint && samplesRendered < totalSamples)
+        {
+            BINAURAL_TRACE_SCOPE ("checkpoint");
+            nextCheckpoint = samplesRendered + checkpointInterval;
+            writer->flush();
+
+            juce::MemoryOutputStream rendererState, meterState;
+            renderer.writeState (rendererState);
+            meter.writeState (meterState);
+
+            checkpoint.renderKey = cacheKey;
+            checkpoint.samplesWritten = samplesRendered;
+            checkpoint.dataStart = dataStart;
+            checkpoint.byteOffset = checkpointStream->getPosition();
+            checkpoint.masterTrimDb = settings.masterTrimDb;
+            checkpoint.blockSize = blockSize;
+            checkpoint.rendererState = rendererState.getMemoryBlock();
+            checkpoint.meterState = meterState.getMemoryBlock();
+            checkpoint.save (checkpointFile);
+        }
         
         // Update progress
         if (progressCallback && totalSamples > 0)
@@ -421,10 +1009,159 @@ bool BinauralAudioProcessor::exportAudio (const juce::File& file, int presetInde
         }
     }
     
-    writer.reset();
+    {
+        // Finishes the header; MP3 is encoded here
+        BINAURAL_TRACE_SCOPE ("finalize");
+        writer.reset();
+    }
+
+    checkpointFile.deleteFile();
+    lastExportLoudness = meter.getIntegratedLoudness();
+
+    // Only WAV carries loop points, so other formats get them alongside the file
+    if (seamlessLoop && format != ExportFormat::WAV)
+        writeLoopMetadata (file.withFileExtension ("loop.json"), loopPlan, sampleRate);
+
+    auto* renderInfo = new juce::DynamicObject();
+    renderInfo->setProperty ("loudness", lastExportLoudness.load());
+
+    {
+        BINAURAL_TRACE_SCOPE ("cache store");
+        renderCache.store (cacheKey, file, juce::var (renderInfo));
+    }
+
     return true;
 }
 
+bool BinauralAudioProcessor::writeLoopMetadata (const juce::File& file, const SeamlessLoop::Plan& plan,
+                                                double sampleRate)
+{
+    auto* loop = new juce::DynamicObject();
+    loop->setProperty ("sampleRate", sampleRate);
+    loop->setProperty ("loopStart", 0);
+    loop->setProperty ("loopEnd", plan.lengthSamples);
+    loop->setProperty ("crossfadeSamples", plan.crossfadeSamples);
+    loop->setProperty ("seamless", plan.isSeamless());
+    loop->setProperty ("leftFrequency", plan.leftFrequency);
+    loop->setProperty ("rightFrequency", plan.rightFrequency);
+    loop->setProperty ("phaseErrorCycles", plan.phaseError);
+
+    return file.replaceWithText (juce::JSON::toString (juce::var (loop)));
+}
+
+double BinauralAudioProcessor::measureLoudness (const OfflineRenderer::Settings& settings, double sampleRate,
+                                                int blockSize, int numSamples)
+{
+    OfflineRenderer renderer (formatManager);
+
+    if (! renderer.prepare (settings, sampleRate, blockSize))
+        return -std::numeric_limits<double>::infinity();
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    LoudnessMeter meter;
+    meter.prepare (sampleRate, 2);
+
+    for (int position = 0; position < numSamples; position += blockSize)
+    {
+        const auto numToRender = juce::jmin (blockSize, numSamples - position);
+        renderer.render (buffer, numToRender);
+        meter.process (buffer.getArrayOfReadPointers(), 2, numToRender);
+    }
+
+    return meter.getIntegratedLoudness();
+}
+
+juce::String BinauralAudioProcessor::getRenderSpec (const OfflineRenderer::Settings& settings, double sampleRate,
+                                                   double durationSeconds, ExportFormat format, int mp3Bitrate,
+                                                   std::optional<double> targetLoudness, bool seamlessLoop) const
+{
+    // Everything that changes the exported bytes, one "name=value" per line
+    juce::StringArray spec;
+    spec.add ("cache=" + juce::String (RenderCache::formatVersion));
+    spec.add ("version=" + juce::String (JucePlugin_VersionString));
+    spec.add ("baseFrequency=" + juce::String (settings.baseFrequency, 6));
+    spec.add ("binauralOffset=" + juce::String (settings.binauralOffset, 6));
+    spec.add ("leftVolume=" + juce::String (settings.leftVolumeDb, 6));
+    spec.add ("rightVolume=" + juce::String (settings.rightVolumeDb, 6));
+    spec.add ("masterVolume=" + juce::String (settings.masterVolumeDb, 6));
+    spec.add ("limiter=" + juce::String ((int) settings.limiter));
+    spec.add ("limiterCeiling=" + juce::String (settings.limiterCeilingDb, 6));
+    spec.add ("limiterLookAhead=" + juce::String (settings.limiterLookAhead));
+    spec.add ("spatializer=" + juce::String ((int) settings.spatializer));
+    spec.add ("leftAzimuth=" + juce::String (settings.leftAzimuth, 6));
+    spec.add ("rightAzimuth=" + juce::String (settings.rightAzimuth, 6));
+    spec.add ("spatializerLatency=" + juce::String (settings.spatializerLatency));
+    spec.add ("backgroundVolume=" + juce::String (settings.backgroundVolumeDb, 6));
+    spec.add ("modulation=" + ModulationEngine::toString (settings.modulation));
+
+    // The bed is identified by path, size and modification time rather than hashed
+    if (settings.backgroundFile != juce::File())
+        spec.add ("background=" + settings.backgroundFile.getFullPathName()
+                  + "|" + juce::String (settings.backgroundFile.getSize())
+                  + "|" + juce::String (settings.backgroundFile.getLastModificationTime().toMilliseconds()));
+
+    spec.add ("sampleRate=" + juce::String (sampleRate, 3));
+    spec.add ("duration=" + juce::String (durationSeconds, 6));
+    spec.add ("format=" + juce::String (format == ExportFormat::MP3 ? "mp3" : "wav"));
+    spec.add ("mp3Bitrate=" + juce::String (format == ExportFormat::MP3 ? mp3Bitrate : 0));
+    spec.add ("loudnessTarget=" + (targetLoudness.has_value() ? juce::String (*targetLoudness, 3) : juce::String ("off")));
+    spec.add ("seamlessLoop=" + juce::String ((int) seamlessLoop));
+
+    return spec.joinIntoString ("\n");
+}
+
+OfflineRenderer::Settings BinauralAudioProcessor::getOfflineSettings() const
+{
+    auto value = [this] (const char* id) { return parameters.getRawParameterValue (id)->load(); };
+
+    OfflineRenderer::Settings settings;
+    settings.baseFrequency = value (BASE_FREQUENCY_ID);
+    settings.binauralOffset = value (BINAURAL_OFFSET_ID);
+    settings.leftVolumeDb = value (LEFT_VOLUME_ID);
+    settings.rightVolumeDb = value (RIGHT_VOLUME_ID);
+    settings.masterVolumeDb = value (MASTER_VOLUME_ID);
+    settings.limiter = value (LIMITER_ID) > 0.5f;
+    settings.limiterCeilingDb = value (LIMITER_CEILING_ID);
+    settings.limiterLookAhead = limiterLookAhead;
+    settings.spatializer = value (SPATIALIZER_ID) > 0.5f;
+    settings.leftAzimuth = value (LEFT_AZIMUTH_ID);
+    settings.rightAzimuth = value (RIGHT_AZIMUTH_ID);
+    settings.spatializerLatency = spatializerLatency;
+    settings.backgroundVolumeDb = value (BACKGROUND_VOLUME_ID);
+    settings.modulation = getModulationPatch();
+    return settings;
+}
+
+ModulationEngine::Patch BinauralAudioProcessor::getModulationPatch() const
+{
+    ModulationEngine::Patch patch {};
+
+    for (int slot = 0; slot < numModulationSlots; ++slot)
+    {
+        const auto& values = modulationValues[(size_t) slot];
+        auto& route = patch[(size_t) slot];
+        route.shape = (ModulationEngine::Shape) juce::roundToInt (values.shape->load());
+        route.target = (ModulationEngine::Target) juce::roundToInt (values.target->load());
+        route.rateHz = values.rate->load();
+        route.depth = values.depth->load();
+        route.audioRate = values.audioRate->load() > 0.5f;
+    }
+
+    return patch;
+}
+
+ExportPreview::Plan BinauralAudioProcessor::getExportPreviewPlan (double sampleRate, double durationSeconds,
+                                                                bool seamlessLoop) const
+{
+    ExportPreview::Plan plan;
+    plan.settings = getOfflineSettings();
+    plan.settings.backgroundFile = getBackgroundFile();
+    plan.sampleRate = sampleRate;
+    plan.durationSeconds = durationSeconds;
+    plan.seamlessLoop = seamlessLoop;
+    return plan;
+}
+
 //==============================================================================
 int BinauralAudioProcessor::getMP3QualityIndex (int bitrate) const
 {
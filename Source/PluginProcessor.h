@@ -2,13 +2,31 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <optional>
 #include "BinauralGenerator.h"
+#include "HrtfSpatializer.h"
+#include "AnalyzerFeed.h"
+#include "OfflineRenderer.h"
+#include "LoudnessMeter.h"
+#include "MidiCarrierControl.h"
+#include "SessionState.h"
+#include "RenderCache.h"
+#include "ExportCheckpoint.h"
+#include "RealtimeAudit.h"
+#include "TraceProfiler.h"
+#include "BlockSizeTuner.h"
+#include "ExportPreview.h"
+#include "PresetDatabase.h"
 
 //==============================================================================
 /**
     Plugin processor for Binaural Generator
 */
-class BinauralAudioProcessor final : public juce::AudioProcessor
+class BinauralAudioProcessor final : public juce::AudioProcessor,
+                                     private juce::AudioProcessorValueTreeState::Listener,
+                                     private juce::AsyncUpdater,
+                                     private juce::Timer
 {
 public:
     //==============================================================================
@@ -59,27 +77,199 @@ public:
     static constexpr const char* MASTER_VOLUME_ID = "masterVolume";
     static constexpr const char* MODE_ID = "mode";
     static constexpr const char* MUTE_ID = "mute";
+    static constexpr const char* SPATIALIZER_ID = "spatializer";
+    static constexpr const char* LEFT_AZIMUTH_ID = "leftAzimuth";
+    static constexpr const char* RIGHT_AZIMUTH_ID = "rightAzimuth";
+    static constexpr const char* BACKGROUND_VOLUME_ID = "backgroundVolume";
+    static constexpr const char* MIDI_MODE_ID = "midiMode";
+    static constexpr const char* LIMITER_ID = "limiter";
+    static constexpr const char* LIMITER_CEILING_ID = "limiterCeiling";
+    static constexpr const char* PHASE_LOCK_ID = "phaseLock";
 
-    // Preset management
+    // Built-in modulation: numModulationSlots routes, each with these
+    // parameters; the IDs are the prefix plus the slot number ("modShape1")
+    static constexpr int numModulationSlots = 3;
+    static constexpr const char* MOD_SHAPE_ID = "modShape";
+    static constexpr const char* MOD_TARGET_ID = "modTarget";
+    static constexpr const char* MOD_RATE_ID = "modRate";
+    static constexpr const char* MOD_DEPTH_ID = "modDepth";
+    static constexpr const char* MOD_AUDIO_RATE_ID = "modAudioRate";
+    static juce::String getModulationParameterID (const char* prefix, int slot) { return prefix + juce::String (slot + 1); }
+
+    // HRTF spatializer latency in samples (0 = zero-latency head block).
+    // Takes effect on the next prepareToPlay.
+    void setSpatializerLatency (int latencyInSamples);
+    int getSpatializerLatency() const { return spatializerLatency; }
+
+    // Master limiter look-ahead in samples, reported as latency.
+    // Takes effect on the next prepareToPlay.
+    void setLimiterLookAhead (int lookAheadInSamples);
+    int getLimiterLookAhead() const { return limiterLookAhead; }
+
+    // Background (bed) layer streamed from disk under the carriers
+    bool loadBackgroundFile (const juce::File& file);
+    void clearBackgroundFile();
+    juce::File getBackgroundFile() const { return backgroundLayer.getFile(); }
+    juce::AudioFormatManager& getFormatManager() { return formatManager; }
+
+    // Audio-to-GUI analyzer feed (only fed while an editor is open)
+    AnalyzerFeed& getAnalyzerFeed() { return analyzerFeed; }
+
+    // Preset management; indices are PresetDatabase indices
     void applyPreset (int presetIndex);
+    PresetDatabase& getPresetDatabase() { return presetDatabase; }
     
     // Export functionality (for standalone)
     enum class ExportFormat { WAV, MP3 };
+
+    // With seamlessLoop the duration is the target loop length; the file is
+    // trimmed to a length that repeats cleanly (see SeamlessLoop)
     bool exportAudio (const juce::File& file, int presetIndex, double durationSeconds, 
                       ExportFormat format = ExportFormat::WAV, int mp3Bitrate = 192, 
                       double sampleRate = 44100.0,
-                      std::function<void(double)> progressCallback = nullptr);
+                      std::function<void(double)> progressCallback = nullptr,
+                      const juce::File& backgroundFile = juce::File(),
+                      std::optional<double> targetLoudness = std::nullopt,
+                      bool seamlessLoop = false);
+
+    // Integrated loudness (LUFS) of the last successful export
+    double getLastExportLoudness() const { return lastExportLoudness.load(); }
+
+    // Finished exports, reused when the same render is asked for again
+    RenderCache& getRenderCache() { return renderCache; }
+
+    // WAV exports save a checkpoint every this many seconds of audio (0 turns
+    // it off) and continue from it when the same export is run again
+    void setExportCheckpointInterval (double seconds) { exportCheckpointSeconds = juce::jmax (0.0, seconds); }
+    double getExportCheckpointInterval() const { return exportCheckpointSeconds; }
+
+    // Exports write a Chrome/Perfetto trace of their stages to this file, plus
+    // a per-stage summary next to it (.summary.json); an empty file turns it off
+    void setExportTraceFile (const juce::File& traceFile) { exportTraceFile = traceFile; }
+
+    // Render block size of exports: calibrated per machine, or fixed with setOverride()
+    BlockSizeTuner& getBlockSizeTuner() { return blockSizeTuner; }
+
+    // The export exportAudio would make from the current parameters and bed, for previews
+    ExportPreview::Plan getExportPreviewPlan (double sampleRate, double durationSeconds, bool seamlessLoop) const;
     
 private:
     // Helper for MP3 quality index
     int getMP3QualityIndex (int bitrate) const;
 
+    // Sample-accurate MIDI: render up to each event, then apply it
+    void renderCarriers (juce::dsp::AudioBlock<float>& block, int startSample, int numSamples);
+    void handleMidiMessage (const juce::MidiMessage& message, float parameterBaseFrequency);
+
+    // Loads, keeps or clears the background layer to match a restored session
+    void restoreBackgroundFile (const juce::String& backgroundPath);
+
+    // Routes of the modulation slots, from the current parameters
+    ModulationEngine::Patch getModulationPatch() const;
+
+    // Export helpers
+    OfflineRenderer::Settings getOfflineSettings() const;
+    double measureLoudness (const OfflineRenderer::Settings& settings, double sampleRate,
+                            int blockSize, int numSamples);
+    bool writeLoopMetadata (const juce::File& file, const SeamlessLoop::Plan& plan, double sampleRate);
+    juce::String getRenderSpec (const OfflineRenderer::Settings& settings, double sampleRate,
+                                double durationSeconds, ExportFormat format, int mp3Bitrate,
+                                std::optional<double> targetLoudness, bool seamlessLoop) const;
+
+    // Spatializer position and plugin latency updates (message thread)
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+    void updateSpatializer();
+
+    // Passes MIDI controller values on to their parameters and the host (message thread)
+    void timerCallback() override;
+    float getControlledValue (int controller, const char* parameterID) const noexcept;
+
 private:
     //==============================================================================
     juce::AudioProcessorValueTreeState parameters;
     
+    // Modulation parameter values, looked up once so the audio thread reads
+    // them without building IDs
+    struct ModulationSlotValues
+    {
+        std::atomic<float>* shape = nullptr;
+        std::atomic<float>* target = nullptr;
+        std::atomic<float>* rate = nullptr;
+        std::atomic<float>* depth = nullptr;
+        std::atomic<float>* audioRate = nullptr;
+    };
+
+    std::array<ModulationSlotValues, numModulationSlots> modulationValues;
+    
     // Binaural generator
     BinauralGenerator binauralGenerator;
+
+    // MIDI notes and pitch bend to carriers
+    MidiCarrierControl midiControl;
+
+    // Analyzer feed for the editor
+    AnalyzerFeed analyzerFeed;
+
+    // Streamed bed layer
+    juce::AudioFormatManager formatManager;
+    BackgroundLayer backgroundLayer;
+
+    // Optional HRTF stage applied to the carriers on stereo outputs
+    HrtfSpatializer spatializer;
+    int spatializerLatency = 0;
+
+    // Parameters MIDI controllers drive (CC1, 7, 12, 13). The audio thread
+    // leaves each new value in its slot, NaN when there is none, and uses it
+    // until the message thread has set the parameter: setValueNotifyingHost
+    // locks and calls listeners, so it cannot run in processBlock
+    static constexpr const char* controllerParameterIDs[] = { BINAURAL_OFFSET_ID, MASTER_VOLUME_ID,
+                                                              LEFT_VOLUME_ID, RIGHT_VOLUME_ID };
+    static constexpr int numControllers = 4;
+    std::array<std::atomic<float>, numControllers> pendingControllerValues;
+
+    // Samples the generator has been idle for, audio thread only
+    int idleSamples = 0;
+
+    // Transport position where the last phase-locked block ended; -1 when
+    // not locked. Audio thread only
+    juce::int64 nextPlayPosition = -1;
+
+    int limiterLookAhead = 64;
+
+    // Length of the pre-render used to hit a loudness target
+    static constexpr double loudnessProbeSeconds = 10.0;
+    std::atomic<double> lastExportLoudness { -std::numeric_limits<double>::infinity() };
+
+    double exportCheckpointSeconds = 300.0;
+
+    juce::File exportTraceFile;
+
+    BlockSizeTuner blockSizeTuner { juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                                        .getChildFile ("BinauralGenerator")
+                                        .getChildFile ("BlockSizeProfile.json") };
+
+    RenderCache renderCache { juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                                  .getChildFile ("BinauralGenerator")
+                                  .getChildFile ("RenderCache") };
+
+    // Opened on first use; the factory presets when the file is missing
+    PresetDatabase presetDatabase { juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                                        .getChildFile ("BinauralGenerator")
+                                        .getChildFile ("Presets.bpdb") };
+
+    // Preset being applied. Its parameters are set one at a time, so the
+    // audio thread follows this snapshot until they all are: presetPublished
+    // counts presets published, presetSettled the last one fully applied
+    struct PresetTarget
+    {
+        float baseFrequency = 0.0f;
+        float offset = 0.0f;
+    };
+
+    std::atomic<PresetTarget> presetTarget { PresetTarget() };
+    std::atomic<juce::uint32> presetPublished { 0 }, presetSettled { 0 };
+    juce::CriticalSection presetApplyLock;
     
     // Sample rate
     double currentSampleRate = 44100.0;
@@ -0,0 +1,430 @@
+#include "PresetDatabase.h"
+
+#include <numeric>
+
+namespace
+{
+    constexpr char magic[4] = { 'B', 'P', 'D', 'B' };
+
+    // Magic, version, number of presets, five section offsets
+    constexpr juce::uint32 headerSize = 4 + 7 * 4;
+
+    // Base frequency, offset, name and description offsets
+    constexpr juce::uint32 recordSize = 4 * 4;
+
+    struct FactoryPreset
+    {
+        const char* name;
+        float baseFrequency;
+        float offset;
+        const char* description;
+    };
+
+    // One copy in this translation unit; only turned into a database when no file is found
+    constexpr FactoryPreset factoryPresets[] =
+    {
+        { "Delta", 200.0f, 2.0f, "Deep Sleep (0.5-4 Hz)" },
+        { "Theta", 200.0f, 6.0f, "Deep Meditation (4-8 Hz)" },
+        { "Alpha", 200.0f, 10.0f, "Relaxation (8-13 Hz)" },
+        { "Beta", 200.0f, 20.0f, "Concentration (13-30 Hz)" },
+        { "Gamma", 200.0f, 40.0f, "Hyperactivity (30-100 Hz)" },
+
+        // Solfeggio frequencies
+        { "174 Hz", 174.0f, 1.5f, "Alivio del dolor, conexión a tierra, seguridad" },
+        { "285 Hz", 285.0f, 1.5f, "Curación celular, regeneración de tejidos, vitalidad" },
+        { "396 Hz", 396.0f, 1.5f, "Liberación de miedo y culpa, pensamientos negativos" },
+        { "417 Hz", 417.0f, 1.5f, "Facilitar cambios, deshacer situaciones, nuevos comienzos" },
+        { "528 Hz", 528.0f, 1.5f, "Reparación del ADN, armonía, frecuencia del amor" },
+        { "639 Hz", 639.0f, 1.5f, "Conectar relaciones, armonía interpersonal, comunidad" },
+        { "741 Hz", 741.0f, 1.5f, "Despertar creatividad, autoexpresión, limpieza celular" },
+        { "852 Hz", 852.0f, 1.5f, "Despertar intuición (tercer ojo), sabiduría, pensamientos positivos" },
+        { "963 Hz", 963.0f, 1.5f, "Conexión superior, unidad, despertar a un estado perfecto" },
+
+        // Schumann resonance
+        { "Schumann Resonance", 7.83f, 0.5f,
+          "Resonancia Schumann: Fundamental 7.83 Hz. Armónicos: 14.07, 20.25, 26.41, 32.45 Hz" }
+    };
+}
+
+//==============================================================================
+PresetDatabase::Band PresetDatabase::getBand (float offsetHz) noexcept
+{
+    const auto beat = std::abs (offsetHz);
+
+    if (beat < 4.0f)   return Band::delta;
+    if (beat < 8.0f)   return Band::theta;
+    if (beat < 13.0f)  return Band::alpha;
+    if (beat < 30.0f)  return Band::beta;
+    return Band::gamma;
+}
+
+juce::String PresetDatabase::getBandName (Band band)
+{
+    switch (band)
+    {
+        case Band::delta:  return "Delta";
+        case Band::theta:  return "Theta";
+        case Band::alpha:  return "Alpha";
+        case Band::beta:   return "Beta";
+        case Band::gamma:  return "Gamma";
+    }
+
+    return {};
+}
+
+//==============================================================================
+void PresetDatabase::Builder::add (const juce::String& name, float baseFrequency, float offset,
+                                   const juce::String& description)
+{
+    entries.push_back ({ name, description, baseFrequency, offset, getBand (offset) });
+}
+
+bool PresetDatabase::Builder::writeTo (juce::OutputStream& stream) const
+{
+    const auto count = (juce::uint32) entries.size();
+
+    std::vector<juce::uint32> byName (count), byBand (count), byFrequency (count);
+    std::iota (byName.begin(), byName.end(), 0u);
+    std::iota (byBand.begin(), byBand.end(), 0u);
+    std::iota (byFrequency.begin(), byFrequency.end(), 0u);
+
+    // Stable sorts: equal keys keep the order they were added in
+    std::stable_sort (byName.begin(), byName.end(), [this] (auto a, auto b)
+    {
+        return entries[a].name.compareIgnoreCase (entries[b].name) < 0;
+    });
+
+    std::stable_sort (byBand.begin(), byBand.end(), [this] (auto a, auto b)
+    {
+        if (entries[a].band != entries[b].band)
+            return entries[a].band < entries[b].band;
+
+        return entries[a].baseFrequency < entries[b].baseFrequency;
+    });
+
+    std::stable_sort (byFrequency.begin(), byFrequency.end(), [this] (auto a, auto b)
+    {
+        return entries[a].baseFrequency < entries[b].baseFrequency;
+    });
+
+    // numBands + 1 starts, the last one being the end of the band index
+    std::vector<juce::uint32> bandStarts ((size_t) numBands + 1, count);
+
+    for (int position = (int) count; --position >= 0;)
+        bandStarts[(size_t) entries[byBand[(size_t) position]].band] = (juce::uint32) position;
+
+    for (int band = numBands; --band >= 0;)
+        bandStarts[(size_t) band] = juce::jmin (bandStarts[(size_t) band], bandStarts[(size_t) band + 1]);
+
+    const auto recordsOffset = headerSize;
+    const auto nameIndexOffset = recordsOffset + count * recordSize;
+    const auto bandIndexOffset = nameIndexOffset + count * 4;
+    const auto frequencyIndexOffset = bandIndexOffset + count * 4;
+    const auto bandStartsOffset = frequencyIndexOffset + count * 4;
+    const auto stringsOffset = bandStartsOffset + (juce::uint32) bandStarts.size() * 4;
+
+    bool ok = stream.write (magic, sizeof (magic));
+
+    for (auto word : { formatVersion, count, recordsOffset, nameIndexOffset, bandIndexOffset,
+                       frequencyIndexOffset, bandStartsOffset })
+        ok = ok && stream.writeInt ((int) word);
+
+    auto stringOffset = stringsOffset;
+
+    for (const auto& entry : entries)
+    {
+        ok = ok && stream.writeFloat (entry.baseFrequency) && stream.writeFloat (entry.offset);
+
+        for (const auto* text : { &entry.name, &entry.description })
+        {
+            ok = ok && stream.writeInt ((int) stringOffset);
+            stringOffset += (juce::uint32) text->getNumBytesAsUTF8() + 1;
+        }
+    }
+
+    for (const auto* index : { &byName, &byBand, &byFrequency, &bandStarts })
+        for (auto value : *index)
+            ok = ok && stream.writeInt ((int) value);
+
+    for (const auto& entry : entries)
+        for (const auto* text : { &entry.name, &entry.description })
+            ok = ok && stream.write (text->toRawUTF8(), text->getNumBytesAsUTF8() + 1);
+
+    return ok;
+}
+
+bool PresetDatabase::Builder::writeTo (const juce::File& file) const
+{
+    juce::TemporaryFile temp (file);
+
+    {
+        juce::FileOutputStream stream (temp.getFile());
+
+        if (! stream.openedOk() || ! writeTo (stream))
+            return false;
+
+        stream.flush();
+
+        if (stream.getStatus().failed())
+            return false;
+    }
+
+    // Readers that mapped the old file keep their mapping
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+//==============================================================================
+PresetDatabase::PresetDatabase (const juce::File& databaseFile)
+    : file (databaseFile)
+{
+}
+
+PresetDatabase::~PresetDatabase() = default;
+
+juce::MemoryBlock PresetDatabase::createFactoryDatabase()
+{
+    Builder builder;
+
+    for (const auto& preset : factoryPresets)
+        builder.add (juce::String::fromUTF8 (preset.name), preset.baseFrequency, preset.offset,
+                     juce::String::fromUTF8 (preset.description));
+
+    juce::MemoryOutputStream stream;
+    builder.writeTo (stream);
+    return stream.getMemoryBlock();
+}
+
+void PresetDatabase::ensureOpen()
+{
+    if (opened.load (std::memory_order_acquire))
+        return;
+
+    const juce::ScopedLock sl (openLock);
+
+    if (opened.load (std::memory_order_relaxed))
+        return;
+
+    if (file.existsAsFile())
+    {
+        mappedFile = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readOnly);
+
+        if (mappedFile->getData() == nullptr || ! attach (mappedFile->getData(), mappedFile->getSize()))
+            mappedFile.reset();
+    }
+
+    if (mappedFile == nullptr)
+    {
+        factoryData = createFactoryDatabase();
+        attach (factoryData.getData(), factoryData.getSize());
+    }
+
+    opened.store (true, std::memory_order_release);
+}
+
+bool PresetDatabase::attach (const void* newData, size_t newSize)
+{
+    data = static_cast<const char*> (newData);
+    dataSize = newSize;
+
+    if (dataSize < headerSize || std::memcmp (data, magic, sizeof (magic)) != 0 || readWord (4) != formatVersion)
+        return false;
+
+    const auto count = (juce::uint64) readWord (8);
+    recordsOffset = readWord (12);
+    nameIndexOffset = readWord (16);
+    bandIndexOffset = readWord (20);
+    frequencyIndexOffset = readWord (24);
+    bandStartsOffset = readWord (28);
+
+    // Every section inside the data; records are checked again as they are read
+    auto fits = [this] (juce::uint64 offset, juce::uint64 length) { return offset + length <= (juce::uint64) dataSize; };
+
+    if (! fits (recordsOffset, count * recordSize) || ! fits (nameIndexOffset, count * 4)
+        || ! fits (bandIndexOffset, count * 4) || ! fits (frequencyIndexOffset, count * 4)
+        || ! fits (bandStartsOffset, (numBands + 1) * 4) || count > (juce::uint64) std::numeric_limits<int>::max())
+        return false;
+
+    numPresets = (int) count;
+    return true;
+}
+
+//==============================================================================
+juce::uint32 PresetDatabase::readWord (size_t byteOffset) const noexcept
+{
+    juce::uint32 value;
+    std::memcpy (&value, data + byteOffset, sizeof (value));
+    return juce::ByteOrder::swapIfBigEndian (value);
+}
+
+float PresetDatabase::readFloat (size_t byteOffset) const noexcept
+{
+    const auto word = readWord (byteOffset);
+    float value;
+    std::memcpy (&value, &word, sizeof (value));
+    return value;
+}
+
+juce::uint32 PresetDatabase::readIndex (juce::uint32 sectionOffset, int position) const noexcept
+{
+    return readWord ((size_t) sectionOffset + (size_t) position * 4);
+}
+
+juce::String PresetDatabase::readString (juce::uint32 byteOffset) const
+{
+    if (byteOffset >= dataSize)
+        return {};
+
+    const auto* start = data + byteOffset;
+    const auto* end = static_cast<const char*> (std::memchr (start, 0, dataSize - byteOffset));
+
+    return end != nullptr ? juce::String::fromUTF8 (start, (int) (end - start)) : juce::String();
+}
+
+//==============================================================================
+int PresetDatabase::getNumPresets()
+{
+    ensureOpen();
+    return numPresets;
+}
+
+bool PresetDatabase::isUsingFile()
+{
+    ensureOpen();
+    return mappedFile != nullptr;
+}
+
+bool PresetDatabase::getPreset (int index, Preset& preset)
+{
+    ensureOpen();
+
+    if (! juce::isPositiveAndBelow (index, numPresets))
+        return false;
+
+    const auto record = (size_t) recordsOffset + (size_t) index * recordSize;
+
+    preset.baseFrequency = readFloat (record);
+    preset.offset = readFloat (record + 4);
+    preset.name = readString (readWord (record + 8));
+    preset.description = readString (readWord (record + 12));
+    preset.band = getBand (preset.offset);
+
+    return preset.name.isNotEmpty() && std::isfinite (preset.baseFrequency) && std::isfinite (preset.offset);
+}
+
+int PresetDatabase::getIndexInBandOrder (int position)
+{
+    ensureOpen();
+
+    if (! juce::isPositiveAndBelow (position, numPresets))
+        return -1;
+
+    const auto index = (int) readIndex (bandIndexOffset, position);
+    return index < numPresets ? index : -1;
+}
+
+juce::Range<int> PresetDatabase::getBandPositions (Band band)
+{
+    ensureOpen();
+
+    const auto start = (int) juce::jmin ((juce::uint32) numPresets, readIndex (bandStartsOffset, (int) band));
+    const auto end = (int) juce::jmin ((juce::uint32) numPresets, readIndex (bandStartsOffset, (int) band + 1));
+    return { start, juce::jmax (start, end) };
+}
+
+int PresetDatabase::getBandOrderPosition (int index)
+{
+    Preset preset;
+
+    if (! getPreset (index, preset))
+        return -1;
+
+    // Within its band, by base frequency; presets sharing one are then in the order they were added
+    const auto positions = getBandPositions (preset.band);
+    auto frequencyAt = [this] (int position)
+    {
+        const auto other = juce::jmin ((juce::uint32) numPresets - 1, readIndex (bandIndexOffset, position));
+        return readFloat ((size_t) recordsOffset + (size_t) other * recordSize);
+    };
+
+    int low = positions.getStart(), high = positions.getEnd();
+
+    while (low < high)
+    {
+        const auto middle = low + (high - low) / 2;
+
+        if (frequencyAt (middle) < preset.baseFrequency)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    for (auto position = low; position < positions.getEnd(); ++position)
+        if ((int) readIndex (bandIndexOffset, position) == index)
+            return position;
+
+    return -1;
+}
+
+int PresetDatabase::findByName (const juce::String& namePrefix)
+{
+    ensureOpen();
+
+    if (namePrefix.isEmpty())
+        return -1;
+
+    // First name not below the prefix; any match is there
+    int low = 0, high = numPresets;
+
+    while (low < high)
+    {
+        const auto middle = low + (high - low) / 2;
+        const auto record = (size_t) recordsOffset + (size_t) juce::jmin ((juce::uint32) numPresets - 1,
+                                                                           readIndex (nameIndexOffset, middle)) * recordSize;
+
+        if (readString (readWord (record + 8)).compareIgnoreCase (namePrefix) < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    if (low >= numPresets)
+        return -1;
+
+    const auto index = (int) readIndex (nameIndexOffset, low);
+    Preset preset;
+
+    return getPreset (index, preset) && preset.name.startsWithIgnoreCase (namePrefix) ? index : -1;
+}
+
+int PresetDatabase::findNearestFrequency (float baseFrequencyHz)
+{
+    ensureOpen();
+
+    if (numPresets == 0)
+        return -1;
+
+    auto frequencyAt = [this] (int position)
+    {
+        const auto index = juce::jmin ((juce::uint32) numPresets - 1, readIndex (frequencyIndexOffset, position));
+        return readFloat ((size_t) recordsOffset + (size_t) index * recordSize);
+    };
+
+    int low = 0, high = numPresets;
+
+    while (low < high)
+    {
+        const auto middle = low + (high - low) / 2;
+
+        if (frequencyAt (middle) < baseFrequencyHz)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    // The neighbour below may be closer
+    if (low == numPresets
+        || (low > 0 && baseFrequencyHz - frequencyAt (low - 1) <= frequencyAt (low) - baseFrequencyHz))
+        --low;
+
+    return (int) juce::jmin ((juce::uint32) numPresets - 1, readIndex (frequencyIndexOffset, low));
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+    Preset catalogue read from a compact file, memory-mapped on first use.
+
+    Opening only maps the file and checks its header, so startup costs the
+    same for fifteen presets or a hundred thousand, and pages that are never
+    looked at are never read. Without a database file the factory presets
+    are served from a small in-memory copy in the same format.
+
+    File layout (little-endian):
+      - header: "BPDB", version, number of presets and the offsets of the
+        sections below;
+      - one fixed-size record per preset: base frequency, offset and the
+        file offsets of its name and description (NUL-terminated UTF-8);
+      - three indexes of record numbers: by name (case-insensitive), by
+        band and then base frequency, and by base frequency; plus the start
+        of each band within the band index;
+      - the strings.
+
+    Preset indices are record numbers, in the order the presets were added
+    to the Builder. Every accessor may be called from any thread.
+*/
+class PresetDatabase
+{
+public:
+    /** Brainwave band of a preset, from its binaural offset. */
+    enum class Band
+    {
+        delta,      // below 4 Hz
+        theta,      // 4-8 Hz
+        alpha,      // 8-13 Hz
+        beta,       // 13-30 Hz
+        gamma       // 30 Hz and above
+    };
+
+    static constexpr int numBands = 5;
+
+    static Band getBand (float offsetHz) noexcept;
+    static juce::String getBandName (Band band);
+
+    struct Preset
+    {
+        juce::String name;
+        juce::String description;
+        float baseFrequency = 0.0f;
+        float offset = 0.0f;
+        Band band = Band::delta;
+    };
+
+    //==============================================================================
+    /** Writes databases; the Builder keeps everything in memory until writeTo(). */
+    class Builder
+    {
+    public:
+        void add (const juce::String& name, float baseFrequency, float offset, const juce::String& description);
+        int getNumPresets() const noexcept  { return (int) entries.size(); }
+
+        bool writeTo (juce::OutputStream& stream) const;
+        bool writeTo (const juce::File& file) const;
+
+    private:
+        std::vector<Preset> entries;
+    };
+
+    //==============================================================================
+    /** Nothing is read until the first call that needs the catalogue. */
+    explicit PresetDatabase (const juce::File& databaseFile);
+    ~PresetDatabase();
+
+    int getNumPresets();
+
+    /** Returns false for an index out of range or a damaged record. */
+    bool getPreset (int index, Preset& preset);
+
+    /** Presets ordered by band, then by base frequency: the preset index at that position. */
+    int getIndexInBandOrder (int position);
+
+    /** Positions of a band in getIndexInBandOrder(). */
+    juce::Range<int> getBandPositions (Band band);
+
+    /** Where a preset sits in getIndexInBandOrder(); -1 for an invalid index. */
+    int getBandOrderPosition (int index);
+
+    /** First preset, in name order, whose name starts with the text (ignoring case); -1 if none. */
+    int findByName (const juce::String& namePrefix);
+
+    /** Preset with the base frequency closest to the given one; -1 when the catalogue is empty. */
+    int findNearestFrequency (float baseFrequencyHz);
+
+    /** False when the file was missing or unreadable and the factory presets are served instead. */
+    bool isUsingFile();
+
+    const juce::File& getFile() const noexcept  { return file; }
+
+    /** The built-in presets, as a database. */
+    static juce::MemoryBlock createFactoryDatabase();
+
+    static constexpr juce::uint32 formatVersion = 1;
+
+private:
+    void ensureOpen();
+    bool attach (const void* data, size_t size);
+
+    juce::uint32 readWord (size_t byteOffset) const noexcept;
+    float readFloat (size_t byteOffset) const noexcept;
+    juce::uint32 readIndex (juce::uint32 sectionOffset, int position) const noexcept;
+    juce::String readString (juce::uint32 byteOffset) const;
+
+    juce::File file;
+
+    juce::CriticalSection openLock;
+    std::atomic<bool> opened { false };
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    juce::MemoryBlock factoryData;
+
+    // Set once by ensureOpen(), read-only afterwards
+    const char* data = nullptr;
+    size_t dataSize = 0;
+    int numPresets = 0;
+    juce::uint32 recordsOffset = 0, nameIndexOffset = 0, bandIndexOffset = 0,
+                 frequencyIndexOffset = 0, bandStartsOffset = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetDatabase)
+};
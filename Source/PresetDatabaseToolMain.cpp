@@ -0,0 +1,153 @@
+#include "PresetDatabase.h"
+
+//==============================================================================
+/*
+    binaural-preset-db build CATALOGUE.csv OUTPUT.bpdb
+    binaural-preset-db list [DATABASE.bpdb]
+    binaural-preset-db nearest DATABASE.bpdb FREQUENCY
+
+    Authors the preset database the plugin reads from Presets.bpdb. A
+    catalogue has one preset per line:
+
+        name, base frequency (Hz), binaural offset (Hz), description
+
+    Blank lines and lines starting with # are skipped; a field holding a
+    comma goes in double quotes, and the description may also just run to
+    the end of the line. "list" prints a database back as a catalogue (the
+    factory presets when no file is given), so the factory set is a starting
+    point for a custom one; "nearest" looks a base frequency up.
+*/
+namespace
+{
+    juce::String quoteIfNeeded (const juce::String& field)
+    {
+        return field.containsChar (',') ? field.quoted() : field;
+    }
+
+    bool parseLine (const juce::String& line, int lineNumber, PresetDatabase::Builder& builder)
+    {
+        juce::StringArray fields;
+        fields.addTokens (line, ",", "\"");
+
+        if (fields.size() < 3)
+        {
+            std::cerr << "Line " << lineNumber << ": needs a name, a base frequency and an offset" << std::endl;
+            return false;
+        }
+
+        const auto name = fields[0].trim().unquoted();
+        const auto baseFrequency = fields[1].trim().getFloatValue();
+        const auto offset = fields[2].trim().getFloatValue();
+
+        fields.removeRange (0, 3);
+        const auto description = fields.joinIntoString (",").trim().unquoted();
+
+        // Offsets within the parameter range; bases may be sub-audio, like the Schumann preset
+        if (name.isEmpty() || ! (baseFrequency > 0.0f && baseFrequency <= 20000.0f) || ! (offset >= 0.0f && offset <= 100.0f))
+        {
+            std::cerr << "Line " << lineNumber << ": needs a name, a base frequency up to 20 kHz and an offset of 0-100 Hz"
+                      << std::endl;
+            return false;
+        }
+
+        builder.add (name, baseFrequency, offset, description);
+        return true;
+    }
+
+    int build (const juce::File& catalogue, const juce::File& output)
+    {
+        if (! catalogue.existsAsFile())
+        {
+            std::cerr << "Cannot read " << catalogue.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        juce::StringArray lines;
+        catalogue.readLines (lines);
+
+        PresetDatabase::Builder builder;
+
+        for (int i = 0; i < lines.size(); ++i)
+        {
+            const auto line = lines[i].trim();
+
+            if (line.isEmpty() || line.startsWithChar ('#'))
+                continue;
+
+            if (! parseLine (line, i + 1, builder))
+                return 1;
+        }
+
+        if (builder.getNumPresets() == 0 || ! builder.writeTo (output))
+        {
+            std::cerr << "Cannot write " << output.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        std::cout << "Wrote " << builder.getNumPresets() << " presets to " << output.getFullPathName() << std::endl;
+        return 0;
+    }
+
+    int list (PresetDatabase& database)
+    {
+        PresetDatabase::Preset preset;
+
+        std::cout << "# name, base frequency, offset, description" << std::endl;
+
+        for (int i = 0; i < database.getNumPresets(); ++i)
+            if (database.getPreset (i, preset))
+                std::cout << quoteIfNeeded (preset.name) << ", " << preset.baseFrequency << ", " << preset.offset
+                          << ", " << quoteIfNeeded (preset.description) << std::endl;
+
+        return 0;
+    }
+
+    int nearest (PresetDatabase& database, float baseFrequency)
+    {
+        PresetDatabase::Preset preset;
+        const auto index = database.findNearestFrequency (baseFrequency);
+
+        if (! database.getPreset (index, preset))
+        {
+            std::cerr << "The database is empty" << std::endl;
+            return 1;
+        }
+
+        std::cout << index << ": " << preset.name << " (" << preset.baseFrequency << " Hz, "
+                  << preset.offset << " Hz offset)" << std::endl;
+        return 0;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList arguments (argc, argv);
+    const auto command = arguments.size() > 0 ? arguments[0].text : juce::String();
+
+    if (command == "build" && arguments.size() == 3)
+        return build (arguments[1].resolveAsFile(), arguments[2].resolveAsFile());
+
+    if (command == "list" && arguments.size() <= 2)
+    {
+        PresetDatabase database (arguments.size() == 2 ? arguments[1].resolveAsFile() : juce::File());
+        return list (database);
+    }
+
+    if (command == "nearest" && arguments.size() == 3)
+    {
+        PresetDatabase database (arguments[1].resolveAsFile());
+
+        if (! database.isUsingFile())
+        {
+            std::cerr << "Cannot read " << arguments[1].text << std::endl;
+            return 1;
+        }
+
+        return nearest (database, arguments[2].text.getFloatValue());
+    }
+
+    std::cerr << "Usage: binaural-preset-db build CATALOGUE.csv OUTPUT.bpdb" << std::endl
+              << "       binaural-preset-db list [DATABASE.bpdb]" << std::endl
+              << "       binaural-preset-db nearest DATABASE.bpdb FREQUENCY" << std::endl;
+    return 1;
+}
@@ -0,0 +1,347 @@
+#include "RealtimeAudit.h"
+
+#if BINAURAL_RT_AUDIT
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <time.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    thread_local int realtimeDepth = 0;
+
+    // Set while a report is being made, so the allocations and locks of the
+    // report itself are not reported
+    thread_local bool reporting = false;
+
+    std::atomic<int> numViolations { 0 };
+    std::atomic<bool> abortOnViolation { std::getenv ("BINAURAL_RT_AUDIT_ABORT") != nullptr };
+
+    constexpr size_t maxReports = 256;
+    std::mutex reportsLock;
+    std::vector<RealtimeAudit::Report> reports;
+
+    const char* getViolationName (RealtimeAudit::Violation type) noexcept
+    {
+        switch (type)
+        {
+            case RealtimeAudit::Violation::allocation:    return "allocation";
+            case RealtimeAudit::Violation::deallocation:  return "deallocation";
+            case RealtimeAudit::Violation::lock:          return "lock";
+            case RealtimeAudit::Violation::blockingCall:  return "blocking call";
+        }
+
+        return "";
+    }
+}
+
+//==============================================================================
+namespace RealtimeAudit
+{
+    ScopedRealtimeSection::ScopedRealtimeSection() noexcept   { ++realtimeDepth; }
+    ScopedRealtimeSection::~ScopedRealtimeSection() noexcept  { --realtimeDepth; }
+
+    void reportViolation (Violation type, const char* function) noexcept
+    {
+        if (realtimeDepth == 0 || reporting)
+            return;
+
+        reporting = true;
+        ++numViolations;
+
+        Report report { type, function, juce::SystemStats::getStackBacktrace() };
+
+        std::fprintf (stderr, "[RT audit] %s in the audio thread: %s\n%s\n",
+                      getViolationName (type), function, report.stackTrace.toRawUTF8());
+
+        {
+            const std::lock_guard<std::mutex> lock (reportsLock);
+
+            if (reports.size() < maxReports)
+                reports.push_back (std::move (report));
+        }
+
+        reporting = false;
+
+        if (abortOnViolation)
+            std::abort();
+    }
+
+    int getNumViolations() noexcept
+    {
+        return numViolations.load();
+    }
+
+    std::vector<Report> getReports()
+    {
+        const std::lock_guard<std::mutex> lock (reportsLock);
+        return reports;
+    }
+
+    void clear()
+    {
+        const std::lock_guard<std::mutex> lock (reportsLock);
+        reports.clear();
+        numViolations = 0;
+    }
+
+    void setAbortOnViolation (bool shouldAbort) noexcept
+    {
+        abortOnViolation = shouldAbort;
+    }
+}
+
+//==============================================================================
+// Heap: the replaced operators and the interposed C allocators below report,
+// then allocate through these so one call is not reported twice
+#if JUCE_LINUX
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void __libc_free (void*);
+}
+#endif
+
+namespace
+{
+    void* allocateUnreported (std::size_t size) noexcept
+    {
+       #if JUCE_LINUX
+        return __libc_malloc (size != 0 ? size : 1);
+       #else
+        return std::malloc (size != 0 ? size : 1);
+       #endif
+    }
+
+    void freeUnreported (void* ptr) noexcept
+    {
+       #if JUCE_LINUX
+        __libc_free (ptr);
+       #else
+        std::free (ptr);
+       #endif
+    }
+
+    void* allocateAlignedUnreported (std::size_t size, std::align_val_t alignment) noexcept
+    {
+        const auto bytes = size != 0 ? size : 1;
+
+       #if JUCE_LINUX
+        return __libc_memalign ((size_t) alignment, bytes);
+       #elif JUCE_WINDOWS
+        return _aligned_malloc (bytes, (size_t) alignment);
+       #else
+        void* ptr = nullptr;
+        return posix_memalign (&ptr, juce::jmax ((size_t) alignment, sizeof (void*)), bytes) == 0 ? ptr : nullptr;
+       #endif
+    }
+
+    void freeAlignedUnreported (void* ptr) noexcept
+    {
+       #if JUCE_WINDOWS
+        _aligned_free (ptr);
+       #else
+        freeUnreported (ptr);
+       #endif
+    }
+}
+
+void* operator new (std::size_t size)
+{
+    RealtimeAudit::reportViolation (RealtimeAudit::Violation::allocation, "operator new");
+
+    if (auto* ptr = allocateUnreported (size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    RealtimeAudit::reportViolation (RealtimeAudit::Violation::allocation, "operator new[]");
+
+    if (auto* ptr = allocateUnreported (size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    RealtimeAudit::reportViolation (RealtimeAudit::Violation::allocation, "operator new (nothrow)");
+    return allocateUnreported (size);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    RealtimeAudit::reportViolation (RealtimeAudit::Violation::allocation, "operator new[] (nothrow)");
+    return allocateUnreported (size);
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    RealtimeAudit::reportViolation (RealtimeAudit::Violation::allocation, "operator new (aligned)");
+
+    if (auto* ptr = allocateAlignedUnreported (size, alignment))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment)
+{
+    RealtimeAudit::reportViolation (RealtimeAudit::Violation::allocation, "operator new[] (aligned)");
+
+    if (auto* ptr = allocateAlignedUnreported (size, alignment))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    RealtimeAudit::reportViolation (RealtimeAudit::Violation::allocation, "operator new (aligned, nothrow)");
+    return allocateAlignedUnreported (size, alignment);
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    RealtimeAudit::reportViolation (RealtimeAudit::Violation::allocation, "operator new[] (aligned, nothrow)");
+    return allocateAlignedUnreported (size, alignment);
+}
+
+void operator delete (void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeAudit::reportViolation (RealtimeAudit::Violation::deallocation, "operator delete");
+
+    freeUnreported (ptr);
+}
+
+void operator delete[] (void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeAudit::reportViolation (RealtimeAudit::Violation::deallocation, "operator delete[]");
+
+    freeUnreported (ptr);
+}
+
+void operator delete (void* ptr, std::align_val_t) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeAudit::reportViolation (RealtimeAudit::Violation::deallocation, "operator delete (aligned)");
+
+    freeAlignedUnreported (ptr);
+}
+
+void operator delete[] (void* ptr, std::align_val_t) noexcept
+{
+    if (ptr != nullptr)
+        RealtimeAudit::reportViolation (RealtimeAudit::Violation::deallocation, "operator delete[] (aligned)");
+
+    freeAlignedUnreported (ptr);
+}
+
+void operator delete (void* ptr, std::size_t) noexcept    { operator delete (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept  { operator delete[] (ptr); }
+
+void operator delete (void* ptr, std::size_t, std::align_val_t alignment) noexcept    { operator delete (ptr, alignment); }
+void operator delete[] (void* ptr, std::size_t, std::align_val_t alignment) noexcept  { operator delete[] (ptr, alignment); }
+
+//==============================================================================
+// Locks, blocking calls and the C allocators: ELF symbol interposition.
+// The lock and blocking calls forward to libc through dlsym; the allocators
+// forward to glibc's __libc_ entry points, since dlsym itself may allocate.
+#if JUCE_LINUX
+
+#define BINAURAL_RT_INTERPOSE(returnType, name, violation, params, args)                   \
+    extern "C" returnType name params                                                       \
+    {                                                                                       \
+        RealtimeAudit::reportViolation (RealtimeAudit::Violation::violation, #name);        \
+        static auto* next = reinterpret_cast<returnType (*) params> (dlsym (RTLD_NEXT, #name)); \
+        return next args;                                                                   \
+    }
+
+#define BINAURAL_RT_INTERPOSE_ALLOCATOR(returnType, name, violation, params, body)         \
+    extern "C" returnType name params                                                       \
+    {                                                                                       \
+        RealtimeAudit::reportViolation (RealtimeAudit::Violation::violation, #name);        \
+        body                                                                                \
+    }
+
+BINAURAL_RT_INTERPOSE (int, pthread_mutex_lock, lock, (pthread_mutex_t* m), (m))
+BINAURAL_RT_INTERPOSE (int, pthread_rwlock_rdlock, lock, (pthread_rwlock_t* l), (l))
+BINAURAL_RT_INTERPOSE (int, pthread_rwlock_wrlock, lock, (pthread_rwlock_t* l), (l))
+BINAURAL_RT_INTERPOSE (int, pthread_cond_wait, blockingCall, (pthread_cond_t* c, pthread_mutex_t* m), (c, m))
+BINAURAL_RT_INTERPOSE (int, pthread_cond_timedwait, blockingCall,
+                       (pthread_cond_t* c, pthread_mutex_t* m, const struct timespec* t), (c, m, t))
+BINAURAL_RT_INTERPOSE (int, pthread_join, blockingCall, (pthread_t t, void** r), (t, r))
+BINAURAL_RT_INTERPOSE (int, sem_wait, blockingCall, (sem_t* s), (s))
+BINAURAL_RT_INTERPOSE (int, nanosleep, blockingCall, (const struct timespec* a, struct timespec* b), (a, b))
+BINAURAL_RT_INTERPOSE (int, usleep, blockingCall, (useconds_t u), (u))
+BINAURAL_RT_INTERPOSE (ssize_t, read, blockingCall, (int f, void* b, size_t n), (f, b, n))
+BINAURAL_RT_INTERPOSE (ssize_t, write, blockingCall, (int f, const void* b, size_t n), (f, b, n))
+
+BINAURAL_RT_INTERPOSE_ALLOCATOR (void*, malloc, allocation, (size_t n) noexcept, { return __libc_malloc (n); })
+BINAURAL_RT_INTERPOSE_ALLOCATOR (void*, calloc, allocation, (size_t c, size_t n) noexcept, { return __libc_calloc (c, n); })
+BINAURAL_RT_INTERPOSE_ALLOCATOR (void*, realloc, allocation, (void* p, size_t n) noexcept, { return __libc_realloc (p, n); })
+BINAURAL_RT_INTERPOSE_ALLOCATOR (void*, aligned_alloc, allocation, (size_t a, size_t n) noexcept, { return __libc_memalign (a, n); })
+
+BINAURAL_RT_INTERPOSE_ALLOCATOR (int, posix_memalign, allocation, (void** p, size_t a, size_t n) noexcept,
+{
+    if (a < sizeof (void*) || (a & (a - 1)) != 0)
+        return EINVAL;
+
+    auto* ptr = __libc_memalign (a, n);
+
+    if (ptr == nullptr)
+        return ENOMEM;
+
+    *p = ptr;
+    return 0;
+})
+
+// free (nullptr) is a no-op, so only real releases are reported
+extern "C" void free (void* p) noexcept
+{
+    if (p != nullptr)
+        RealtimeAudit::reportViolation (RealtimeAudit::Violation::deallocation, "free");
+
+    __libc_free (p);
+}
+
+#undef BINAURAL_RT_INTERPOSE_ALLOCATOR
+#undef BINAURAL_RT_INTERPOSE
+
+#endif
+
+#else
+
+//==============================================================================
+// Audit disabled: the scope is never used and nothing is ever reported
+namespace RealtimeAudit
+{
+    ScopedRealtimeSection::ScopedRealtimeSection() noexcept  {}
+    ScopedRealtimeSection::~ScopedRealtimeSection() noexcept {}
+
+    void reportViolation (Violation, const char*) noexcept  {}
+    int getNumViolations() noexcept                          { return 0; }
+    std::vector<Report> getReports()                         { return {}; }
+    void clear()                                             {}
+    void setAbortOnViolation (bool) noexcept                 {}
+}
+
+#endif
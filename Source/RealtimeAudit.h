@@ -0,0 +1,63 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+    Real-time safety audit for the audio thread.
+
+    Configure with -DBINAURAL_RT_AUDIT=ON to get a build where every heap
+    allocation (global operator new/delete, aligned or not, and on Linux the
+    malloc family as well), and on Linux every mutex, rwlock, condition or
+    semaphore wait, sleep and read/write call, made inside a
+    BINAURAL_REALTIME_SCOPE is reported with the call stack that made it.
+    Reports go to stderr and are kept for getReports(); set the environment
+    variable BINAURAL_RT_AUDIT_ABORT (or call setAbortOnViolation) to abort on
+    the first one so an automated run fails at the offending call.
+
+    Interception is by symbol interposition, so this is meant for standalone
+    and test builds rather than plugins loaded into a host. Without the
+    option the scope macro expands to nothing and none of this is compiled.
+*/
+namespace RealtimeAudit
+{
+    enum class Violation
+    {
+        allocation,
+        deallocation,
+        lock,
+        blockingCall
+    };
+
+    struct Report
+    {
+        Violation type;
+        juce::String function;
+        juce::String stackTrace;
+    };
+
+    /** Marks the calling thread as real-time until the scope ends. Nestable. */
+    class ScopedRealtimeSection
+    {
+    public:
+        ScopedRealtimeSection() noexcept;
+        ~ScopedRealtimeSection() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeSection)
+    };
+
+    /** Called by the interposed functions; does nothing outside a real-time section. */
+    void reportViolation (Violation type, const char* function) noexcept;
+
+    int getNumViolations() noexcept;
+    std::vector<Report> getReports();
+    void clear();
+
+    void setAbortOnViolation (bool shouldAbort) noexcept;
+}
+
+#if BINAURAL_RT_AUDIT
+ #define BINAURAL_REALTIME_SCOPE  const RealtimeAudit::ScopedRealtimeSection realtimeAuditScope
+#else
+ #define BINAURAL_REALTIME_SCOPE
+#endif
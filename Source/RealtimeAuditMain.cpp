@@ -0,0 +1,236 @@
+#include "PluginProcessor.h"
+#include "RealtimeAudit.h"
+
+#if ! BINAURAL_RT_AUDIT
+ #error "binaural-realtime-audit needs a -DBINAURAL_RT_AUDIT=ON build"
+#endif
+
+//==============================================================================
+/*
+    binaural-realtime-audit [--seconds S] [--sample-rate SR] [--block-size N]
+
+    Drives processBlock through what a session runs into (parameter glides,
+    presets, modulation, MIDI in every mode, muting and idling, the
+    spatializer, transport starts and jumps) with uneven block sizes, in the
+    audit build. Every allocation, lock or blocking call made on the audio
+    thread is reported on stderr with its stack; the program exits with 1 if
+    there was any. Registered with CTest as realtime-audit.
+*/
+namespace
+{
+    void setParameter (BinauralAudioProcessor& processor, const juce::String& parameterID, float value)
+    {
+        auto* parameter = processor.getValueTreeState().getParameter (parameterID);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    void setModulation (BinauralAudioProcessor& processor, int slot, ModulationEngine::Shape shape,
+                        ModulationEngine::Target target, float rateHz, float depth, bool audioRate)
+    {
+        using P = BinauralAudioProcessor;
+        setParameter (processor, P::getModulationParameterID (P::MOD_SHAPE_ID, slot), (float) shape);
+        setParameter (processor, P::getModulationParameterID (P::MOD_TARGET_ID, slot), (float) target);
+        setParameter (processor, P::getModulationParameterID (P::MOD_RATE_ID, slot), rateHz);
+        setParameter (processor, P::getModulationParameterID (P::MOD_DEPTH_ID, slot), depth);
+        setParameter (processor, P::getModulationParameterID (P::MOD_AUDIO_RATE_ID, slot), audioRate ? 1.0f : 0.0f);
+    }
+
+    /** A host that keeps playing, for the phase lock. */
+    class TestPlayHead final : public juce::AudioPlayHead
+    {
+    public:
+        juce::Optional<PositionInfo> getPosition() const override
+        {
+            PositionInfo position;
+            position.setIsPlaying (true);
+            position.setTimeInSamples (timeInSamples);
+            return position;
+        }
+
+        juce::int64 timeInSamples = 0;
+    };
+
+    struct Scenario
+    {
+        const char* name;
+
+        // Before prepareToPlay
+        std::function<void (BinauralAudioProcessor&)> setUp;
+
+        // Between blocks, outside the audited section
+        std::function<void (BinauralAudioProcessor&, int blockIndex)> betweenBlocks;
+
+        bool sendMidi = false;
+        bool useTransport = false;
+    };
+
+    // Notes, a controller and bends spread over the blocks, on two channels for MPE
+    void addMidi (juce::MidiBuffer& midi, int blockIndex, int numSamples)
+    {
+        const auto note = 48 + (blockIndex / 8) % 24;
+        const auto channel = 1 + (blockIndex / 8) % 2;
+
+        switch (blockIndex % 8)
+        {
+            case 0:  midi.addEvent (juce::MidiMessage::noteOn (channel, note, (juce::uint8) 100), numSamples / 2); break;
+            case 2:  midi.addEvent (juce::MidiMessage::controllerEvent (channel, 1, blockIndex % 128), 0); break;
+            case 3:  midi.addEvent (juce::MidiMessage::pitchWheel (channel, (blockIndex * 997) % 16384), numSamples - 1); break;
+            case 5:  midi.addEvent (juce::MidiMessage::noteOff (channel, note), numSamples / 3); break;
+            default: break;
+        }
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    using P = BinauralAudioProcessor;
+    using Shape = ModulationEngine::Shape;
+    using Target = ModulationEngine::Target;
+
+    const juce::ArgumentList arguments (argc, argv);
+
+    const auto durationSeconds = arguments.containsOption ("--seconds")
+                                     ? arguments.getValueForOption ("--seconds").getDoubleValue()
+                                     : 10.0;
+    const auto sampleRate = arguments.containsOption ("--sample-rate")
+                                ? arguments.getValueForOption ("--sample-rate").getDoubleValue()
+                                : 48000.0;
+    const auto blockSize = arguments.containsOption ("--block-size")
+                               ? arguments.getValueForOption ("--block-size").getIntValue()
+                               : 512;
+
+    if (durationSeconds <= 0.0 || sampleRate < 8000.0 || blockSize < 16)
+    {
+        std::cerr << "Needs a positive duration, 8 kHz or more and blocks of at least 16 samples" << std::endl;
+        return 1;
+    }
+
+    // The processor's parameter state needs the message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    RealtimeAudit::setAbortOnViolation (false);
+
+    const Scenario scenarios[] = {
+        { "Parameter glides",
+          nullptr,
+          [] (P& processor, int blockIndex)
+          {
+              if (blockIndex % 50 == 0)
+              {
+                  setParameter (processor, P::BASE_FREQUENCY_ID, blockIndex % 100 == 0 ? 200.0f : 320.0f);
+                  setParameter (processor, P::BINAURAL_OFFSET_ID, blockIndex % 100 == 0 ? 6.0f : 10.0f);
+                  setParameter (processor, P::LEFT_VOLUME_ID, blockIndex % 100 == 0 ? -6.0f : -60.0f);
+              }
+          } },
+
+        { "Presets",
+          nullptr,
+          [] (P& processor, int blockIndex)
+          {
+              if (blockIndex % 20 == 0)
+                  processor.applyPreset ((blockIndex / 20) % processor.getPresetDatabase().getNumPresets());
+          } },
+
+        { "Modulation",
+          [] (P& processor)
+          {
+              setModulation (processor, 0, Shape::sine, Target::binauralOffset, 0.5f, 2.0f, false);
+              setModulation (processor, 1, Shape::randomWalk, Target::masterVolume, 4.0f, -6.0f, true);
+              setModulation (processor, 2, Shape::rampUp, Target::baseFrequency, 0.2f, 50.0f, false);
+          },
+          nullptr },
+
+        { "Mute and idle",
+          nullptr,
+          [] (P& processor, int blockIndex)
+          {
+              if (blockIndex % 200 == 0)
+                  setParameter (processor, P::MUTE_ID, blockIndex % 400 == 0 ? 1.0f : 0.0f);
+          } },
+
+        { "Spatializer",
+          [] (P& processor) { setParameter (processor, P::SPATIALIZER_ID, 1.0f); },
+          nullptr },
+
+        { "Mono MIDI",
+          [] (P& processor) { setParameter (processor, P::MIDI_MODE_ID, 0.0f); },
+          nullptr, true },
+
+        { "Poly MIDI",
+          [] (P& processor) { setParameter (processor, P::MIDI_MODE_ID, 1.0f); },
+          nullptr, true },
+
+        { "MPE MIDI",
+          [] (P& processor) { setParameter (processor, P::MIDI_MODE_ID, 2.0f); },
+          nullptr, true },
+
+        { "Phase lock with transport jumps",
+          [] (P& processor)
+          {
+              setParameter (processor, P::PHASE_LOCK_ID, 1.0f);
+              setModulation (processor, 0, Shape::triangle, Target::binauralOffset, 1.0f, 1.0f, false);
+          },
+          [] (P& processor, int blockIndex)
+          {
+              if (blockIndex % 50 == 0)
+                  setParameter (processor, P::BASE_FREQUENCY_ID, blockIndex % 100 == 0 ? 200.0f : 240.0f);
+          },
+          false, true }
+    };
+
+    // Hosts do not always send full blocks
+    const int blockSizes[] = { blockSize, blockSize / 2, 37 };
+    const auto totalSamples = (juce::int64) (durationSeconds * sampleRate);
+    int totalViolations = 0;
+
+    for (const auto& scenario : scenarios)
+    {
+        P processor;
+        TestPlayHead playHead;
+
+        if (scenario.setUp != nullptr)
+            scenario.setUp (processor);
+
+        if (scenario.useTransport)
+            processor.setPlayHead (&playHead);
+
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<float> buffer (processor.getTotalNumOutputChannels(), blockSize);
+        juce::MidiBuffer midi;
+        midi.ensureSize (1024);
+
+        RealtimeAudit::clear();
+        juce::int64 rendered = 0;
+
+        for (int blockIndex = 0; rendered < totalSamples; ++blockIndex)
+        {
+            const auto numSamples = blockSizes[blockIndex % juce::numElementsInArray (blockSizes)];
+            buffer.setSize (buffer.getNumChannels(), numSamples, false, false, true);
+            midi.clear();
+
+            if (scenario.sendMidi)
+                addMidi (midi, blockIndex, numSamples);
+
+            if (scenario.betweenBlocks != nullptr)
+                scenario.betweenBlocks (processor, blockIndex);
+
+            processor.processBlock (buffer, midi);
+            rendered += numSamples;
+
+            // Loop back every few hundred blocks, like a cycle region
+            playHead.timeInSamples = blockIndex % 300 == 299 ? 0 : playHead.timeInSamples + numSamples;
+        }
+
+        processor.setPlayHead (nullptr);
+        processor.releaseResources();
+
+        const auto violations = RealtimeAudit::getNumViolations();
+        totalViolations += violations;
+        std::cout << scenario.name << ": "
+                  << (violations == 0 ? juce::String ("clean") : juce::String (violations) + " violation(s)")
+                  << std::endl;
+    }
+
+    std::cout << (totalViolations == 0 ? "processBlock is real-time safe" : "Real-time violations FOUND") << std::endl;
+    return totalViolations == 0 ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+#include "RenderCache.h"
+
+#if JUCE_LINUX
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <sys/ioctl.h>
+ #include <linux/fs.h>
+#elif JUCE_MAC
+ #include <unistd.h>
+ #include <sys/clonefile.h>
+#endif
+
+//==============================================================================
+RenderCache::RenderCache (const juce::File& cacheDirectory)
+    : directory (cacheDirectory),
+      processLock (getProcessLock (cacheDirectory)),
+      lock ("BinauralRenderCache_" + juce::String::toHexString (cacheDirectory.getFullPathName().hashCode64()))
+{
+}
+
+std::mutex& RenderCache::getProcessLock (const juce::File& cacheDirectory)
+{
+    // Never removed: one small mutex per directory ever used
+    static std::mutex mapLock;
+    static std::map<juce::String, std::unique_ptr<std::mutex>> locks;
+
+    const std::lock_guard<std::mutex> guard (mapLock);
+    auto& entry = locks[cacheDirectory.getFullPathName()];
+
+    if (entry == nullptr)
+        entry = std::make_unique<std::mutex>();
+
+    return *entry;
+}
+
+juce::String RenderCache::makeKey (const juce::String& renderSpec)
+{
+    return juce::SHA256 (renderSpec.toUTF8()).toHexString();
+}
+
+juce::File RenderCache::getDataFile (const juce::String& key) const
+{
+    return directory.getChildFile (key + ".render");
+}
+
+juce::File RenderCache::getMetadataFile (const juce::String& key) const
+{
+    return directory.getChildFile (key + ".json");
+}
+
+//==============================================================================
+bool RenderCache::fetch (const juce::String& key, const juce::File& destination, juce::var& metadata)
+{
+    if (! enabled)
+        return false;
+
+    const std::lock_guard<std::mutex> processGuard (processLock);
+    juce::InterProcessLock::ScopedLockType scopedLock (lock);
+
+    if (! scopedLock.isLocked())
+        return false;
+
+    const auto dataFile = getDataFile (key);
+    const auto metadataFile = getMetadataFile (key);
+
+    if (! dataFile.existsAsFile() || ! metadataFile.existsAsFile())
+        return false;
+
+    auto storedMetadata = juce::JSON::parse (metadataFile);
+
+    // A hard-linked export that was edited in place no longer matches its entry
+    if ((juce::int64) storedMetadata.getProperty ("size", -1) != dataFile.getSize())
+    {
+        dataFile.deleteFile();
+        metadataFile.deleteFile();
+        return false;
+    }
+
+    destination.deleteFile();
+
+    if (! placeFile (dataFile, destination, true))
+        return false;
+
+    // Mark as recently used for the LRU trim
+    const auto now = juce::Time::getCurrentTime();
+    dataFile.setLastModificationTime (now);
+    metadataFile.setLastModificationTime (now);
+
+    metadata = storedMetadata.getProperty ("render", {});
+    return true;
+}
+
+bool RenderCache::store (const juce::String& key, const juce::File& renderedFile, const juce::var& metadata)
+{
+    if (! enabled || ! renderedFile.existsAsFile() || renderedFile.getSize() > maximumSize)
+        return false;
+
+    const std::lock_guard<std::mutex> processGuard (processLock);
+    juce::InterProcessLock::ScopedLockType scopedLock (lock);
+
+    if (! scopedLock.isLocked() || ! directory.createDirectory())
+        return false;
+
+    // Clone or copy under a temporary name, then rename into place. Never a
+    // hard link: the caller's export would share its bytes with the entry,
+    // and editing it would silently change the cache
+    const auto temporary = directory.getNonexistentChildFile (key, ".tmp", false);
+
+    if (! placeFile (renderedFile, temporary, false))
+        return false;
+
+    auto* stored = new juce::DynamicObject();
+    stored->setProperty ("size", temporary.getSize());
+    stored->setProperty ("render", metadata);
+
+    if (! temporary.moveFileTo (getDataFile (key))
+        || ! getMetadataFile (key).replaceWithText (juce::JSON::toString (juce::var (stored))))
+    {
+        temporary.deleteFile();
+        return false;
+    }
+
+    trimToSize();
+    return true;
+}
+
+void RenderCache::clear()
+{
+    const std::lock_guard<std::mutex> processGuard (processLock);
+    juce::InterProcessLock::ScopedLockType scopedLock (lock);
+
+    if (scopedLock.isLocked())
+        directory.deleteRecursively();
+}
+
+//==============================================================================
+void RenderCache::trimToSize()
+{
+    auto entries = directory.findChildFiles (juce::File::findFiles, false, "*.render");
+    juce::int64 totalSize = 0;
+
+    for (const auto& entry : entries)
+        totalSize += entry.getSize();
+
+    if (totalSize <= maximumSize)
+        return;
+
+    std::sort (entries.begin(), entries.end(), [] (const juce::File& a, const juce::File& b)
+               { return a.getLastModificationTime() < b.getLastModificationTime(); });
+
+    for (const auto& entry : entries)
+    {
+        if (totalSize <= maximumSize)
+            break;
+
+        totalSize -= entry.getSize();
+        entry.deleteFile();
+        entry.withFileExtension ("json").deleteFile();
+    }
+}
+
+bool RenderCache::placeFile (const juce::File& source, const juce::File& destination, bool allowHardLink)
+{
+    const auto sourcePath = source.getFullPathName();
+    const auto destinationPath = destination.getFullPathName();
+
+   #if JUCE_LINUX
+    // Copy-on-write clone (btrfs, XFS...)
+    const auto in = open (sourcePath.toRawUTF8(), O_RDONLY);
+
+    if (in >= 0)
+    {
+        const auto out = open (destinationPath.toRawUTF8(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        const auto cloned = out >= 0 && ioctl (out, FICLONE, in) == 0;
+
+        if (out >= 0)
+            close (out);
+
+        close (in);
+
+        if (cloned)
+            return true;
+
+        if (out >= 0)
+            unlink (destinationPath.toRawUTF8());
+    }
+   #elif JUCE_MAC
+    if (clonefile (sourcePath.toRawUTF8(), destinationPath.toRawUTF8(), 0) == 0)
+        return true;
+   #endif
+
+   #if JUCE_LINUX || JUCE_MAC
+    if (allowHardLink && link (sourcePath.toRawUTF8(), destinationPath.toRawUTF8()) == 0)
+        return true;
+   #endif
+
+    return source.copyFileTo (destination);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_cryptography/juce_cryptography.h>
+
+//==============================================================================
+/**
+    Content-addressed cache of finished exports.
+
+    Entries are keyed by the SHA-256 of a render spec string that the caller
+    builds from everything that affects the output (parameters, rate,
+    duration, format, code version...). Each entry is the rendered file plus
+    a small JSON metadata file, both named after the key.
+
+    A hit is placed at the destination as a copy-on-write clone where the
+    file system supports it, otherwise as a hard link, otherwise as a copy.
+    A hard-linked export shares its bytes with the entry, so it should be
+    replaced rather than edited in place. Stores only clone or copy, so the
+    cache never shares bytes with the file it was given. Hits refresh the entry's
+    modification time, and stores evict the least recently used entries
+    until the cache is back under its size cap.
+
+    Lookups and stores are serialised with a mutex per cache directory within
+    the process, since the file lock behind InterProcessLock does not exclude
+    other instances in the same process, and across processes with a named
+    InterProcessLock. Entries are written under a temporary name and
+    renamed into place, so concurrent workers never see a partial file.
+    Rendering itself happens outside the lock; two workers missing the same
+    key both render and the second store simply replaces the first.
+*/
+class RenderCache
+{
+public:
+    /** Bump when a DSP change alters renders so old entries stop matching. */
+    static constexpr int formatVersion = 3;
+
+    explicit RenderCache (const juce::File& cacheDirectory);
+
+    void setEnabled (bool shouldBeEnabled) noexcept  { enabled = shouldBeEnabled; }
+    bool isEnabled() const noexcept                  { return enabled; }
+
+    void setMaximumSize (juce::int64 bytes) noexcept  { maximumSize = bytes; }
+    juce::int64 getMaximumSize() const noexcept       { return maximumSize; }
+
+    const juce::File& getDirectory() const noexcept  { return directory; }
+
+    static juce::String makeKey (const juce::String& renderSpec);
+
+    /** Places the entry for key at destination and returns its metadata, or
+        returns false on a miss.
+    */
+    bool fetch (const juce::String& key, const juce::File& destination, juce::var& metadata);
+
+    /** Adds a finished render, then trims the cache to its size cap. */
+    bool store (const juce::String& key, const juce::File& renderedFile, const juce::var& metadata);
+
+    void clear();
+
+private:
+    juce::File getDataFile (const juce::String& key) const;
+    juce::File getMetadataFile (const juce::String& key) const;
+
+    void trimToSize();
+
+    static bool placeFile (const juce::File& source, const juce::File& destination, bool allowHardLink);
+
+    /** The same mutex for every RenderCache on one directory. */
+    static std::mutex& getProcessLock (const juce::File& cacheDirectory);
+
+    juce::File directory;
+    std::mutex& processLock;
+    juce::InterProcessLock lock;
+    juce::int64 maximumSize = (juce::int64) 4 * 1024 * 1024 * 1024;
+    bool enabled = true;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderCache)
+};
@@ -0,0 +1,480 @@
+#include "RenderDaemon.h"
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+namespace
+{
+    // Longest request line accepted; a job is a few hundred bytes
+    constexpr size_t maxLineLength = 64 * 1024;
+
+    // Jobs never calibrate: a calibration takes seconds and every other
+    // client would wait for it. Without an override or a profile entry
+    // (exports on this machine fill the shared profile) they use this size
+    constexpr int defaultBlockSize = 1024;
+
+    // Encoded output sent down the socket is built in memory first; larger
+    // jobs must stream PCM or write to a path
+    constexpr juce::int64 maxInMemoryBytes = 256 * 1024 * 1024;
+
+    // A reader only blocks in recv and waits for its jobs
+    constexpr size_t readerStackSize = 256 * 1024;
+
+    #if JUCE_MAC
+     constexpr int sendFlags = 0;
+    #else
+     constexpr int sendFlags = MSG_NOSIGNAL;
+    #endif
+}
+
+//==============================================================================
+/** Reads one client's requests; closes its socket when destroyed. */
+class RenderDaemon::Connection final : public juce::Thread
+{
+public:
+    Connection (RenderDaemon& d, int socket)
+        : Thread ("RenderDaemon connection", readerStackSize), daemon (d), clientSocket (socket)
+    {
+    }
+
+    ~Connection() override
+    {
+        stopThread (-1);
+        ::close (clientSocket);
+    }
+
+    void shutdown() noexcept  { ::shutdown (clientSocket, SHUT_RDWR); }
+
+    void run() override  { daemon.serve (clientSocket); }
+
+private:
+    RenderDaemon& daemon;
+    const int clientSocket;
+};
+
+/** One request line, rendered on a worker; owned by the reader waiting for it. */
+class RenderDaemon::RenderJob final : public juce::ThreadPoolJob
+{
+public:
+    RenderJob (RenderDaemon& d, int socket, const juce::String& requestLine)
+        : ThreadPoolJob ("RenderDaemon job"), daemon (d), clientSocket (socket), line (requestLine)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        keepConnection = daemon.handleJob (clientSocket, line);
+        return jobHasFinished;
+    }
+
+    // Stays false when stop() removes the job before it runs
+    bool keepConnection = false;
+
+private:
+    RenderDaemon& daemon;
+    const int clientSocket;
+    const juce::String line;
+};
+
+//==============================================================================
+RenderDaemon::RenderDaemon (const juce::File& socket, int numWorkerThreads)
+    : Thread ("RenderDaemon listener"),
+      socketFile (socket),
+      blockSizeTuner (juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                          .getChildFile ("BinauralGenerator")
+                          .getChildFile ("BlockSizeProfile.json")),
+      workers (juce::jmax (1, numWorkerThreads))
+{
+    formatManager.registerBasicFormats();
+}
+
+RenderDaemon::~RenderDaemon()
+{
+    stop();
+}
+
+juce::File RenderDaemon::getDefaultSocketFile()
+{
+    const auto runtimeDirectory = juce::SystemStats::getEnvironmentVariable ("XDG_RUNTIME_DIR", {});
+
+    if (runtimeDirectory.isNotEmpty())
+        return juce::File (runtimeDirectory).getChildFile ("binaural-render.sock");
+
+    return juce::File ("/tmp").getChildFile ("binaural-render-" + juce::String ((int) getuid()) + ".sock");
+}
+
+juce::Result RenderDaemon::start()
+{
+    const auto path = socketFile.getFullPathName();
+    sockaddr_un address {};
+
+    if ((size_t) path.getNumBytesAsUTF8() >= sizeof (address.sun_path))
+        return juce::Result::fail ("Socket path too long: " + path);
+
+    address.sun_family = AF_UNIX;
+    std::memcpy (address.sun_path, path.toRawUTF8(), path.getNumBytesAsUTF8());
+
+    listenSocket = ::socket (AF_UNIX, SOCK_STREAM, 0);
+
+    if (listenSocket < 0)
+        return juce::Result::fail ("Cannot create socket");
+
+    #if JUCE_MAC
+    const int noSigPipe = 1;
+    ::setsockopt (listenSocket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof (noSigPipe));
+    #endif
+
+    // A socket file left by a daemon that did not shut down cleanly
+    socketFile.deleteFile();
+
+    if (::bind (listenSocket, reinterpret_cast<const sockaddr*> (&address), sizeof (address)) != 0
+        || ::listen (listenSocket, SOMAXCONN) != 0)
+    {
+        ::close (listenSocket);
+        listenSocket = -1;
+        return juce::Result::fail ("Cannot listen on " + path);
+    }
+
+    // Only this user's tools may submit jobs
+    ::chmod (path.toRawUTF8(), 0600);
+
+    stopping = false;
+    startThread();
+    return juce::Result::ok();
+}
+
+void RenderDaemon::stop()
+{
+    if (listenSocket < 0)
+        return;
+
+    stopThread (2000);
+
+    {
+        const juce::ScopedLock sl (clientLock);
+        stopping = true;
+
+        for (auto* connection : connections)
+            connection->shutdown();
+    }
+
+    // Readers waiting on a removed job see it gone and return
+    workers.removeAllJobs (true, 10000);
+
+    // Destroyed outside the lock, which a reader may be waiting for
+    juce::OwnedArray<Connection> closing;
+
+    {
+        const juce::ScopedLock sl (clientLock);
+        closing.swapWith (connections);
+    }
+
+    closing.clear();
+
+    ::close (listenSocket);
+    listenSocket = -1;
+    socketFile.deleteFile();
+}
+
+//==============================================================================
+void RenderDaemon::run()
+{
+    while (! threadShouldExit())
+    {
+        // Short poll so stop() is noticed without closing the socket under accept()
+        pollfd listener { listenSocket, POLLIN, 0 };
+
+        const auto ready = ::poll (&listener, 1, 200);
+
+        {
+            // Finished connections are dropped here, off their own threads
+            const juce::ScopedLock sl (clientLock);
+
+            for (int i = connections.size(); --i >= 0;)
+                if (! connections[i]->isThreadRunning())
+                    connections.remove (i);
+        }
+
+        if (ready <= 0)
+            continue;
+
+        const auto clientSocket = ::accept (listenSocket, nullptr, nullptr);
+
+        if (clientSocket < 0)
+            continue;
+
+        #if JUCE_MAC
+        const int noSigPipe = 1;
+        ::setsockopt (clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof (noSigPipe));
+        #endif
+
+        const juce::ScopedLock sl (clientLock);
+        connections.add (new Connection (*this, clientSocket))->startThread();
+    }
+}
+
+void RenderDaemon::serve (int clientSocket)
+{
+    std::string pending;
+    char chunk[4096];
+
+    for (;;)
+    {
+        const auto newline = pending.find ('\n');
+
+        if (newline != std::string::npos)
+        {
+            const auto line = juce::String::fromUTF8 (pending.data(), (int) newline).trim();
+            pending.erase (0, newline + 1);
+
+            if (line.isNotEmpty() && ! submitJob (clientSocket, line))
+                return;
+
+            continue;
+        }
+
+        if (pending.size() > maxLineLength)
+        {
+            sendError (clientSocket, {}, "Request line too long");
+            return;
+        }
+
+        const auto numRead = ::recv (clientSocket, chunk, sizeof (chunk), 0);
+
+        if (numRead <= 0)
+            return;
+
+        pending.append (chunk, (size_t) numRead);
+    }
+}
+
+bool RenderDaemon::submitJob (int clientSocket, const juce::String& line)
+{
+    RenderJob job (*this, clientSocket, line);
+
+    {
+        const juce::ScopedLock sl (clientLock);
+
+        if (stopping)
+            return false;
+
+        workers.addJob (&job, false);
+    }
+
+    // Returns once the job has run, or been removed by stop()
+    workers.waitForJobToFinish (&job, -1);
+    return job.keepConnection;
+}
+
+//==============================================================================
+bool RenderDaemon::handleJob (int clientSocket, const juce::String& line)
+{
+    juce::var job;
+
+    if (juce::JSON::parse (line, job).failed() || ! job.isObject())
+        return sendError (clientSocket, {}, "Request is not a JSON object");
+
+    const auto id = job.getProperty ("id", {});
+    const auto sampleRate = (double) job.getProperty ("sampleRate", 48000.0);
+    const auto duration = (double) job.getProperty ("duration", 0.0);
+    const auto output = job.getProperty ("output", "pcm").toString().toLowerCase();
+    const auto bitsPerSample = (int) job.getProperty ("bitsPerSample", 24);
+    const auto path = job.getProperty ("path", {}).toString();
+
+    if (! (sampleRate >= 8000.0 && sampleRate <= 384000.0) || ! (duration >= 0.0 && duration <= 24.0 * 3600.0))
+        return sendError (clientSocket, id, "Sample rate or duration out of range");
+
+    const auto settings = parseSettings (job.getProperty ("settings", {}));
+    const auto totalFrames = (juce::int64) std::llround (sampleRate * duration);
+    const auto blockSize = blockSizeTuner.getStoredBlockSize (settings, sampleRate).value_or (defaultBlockSize);
+
+    OfflineRenderer renderer (formatManager);
+
+    if (! renderer.prepare (settings, sampleRate, blockSize))
+        return sendError (clientSocket, id, "Cannot open background file");
+
+    juce::var header (new juce::DynamicObject());
+    auto* headerObject = header.getDynamicObject();
+    headerObject->setProperty ("id", id);
+    headerObject->setProperty ("status", "ok");
+    headerObject->setProperty ("channels", 2);
+    headerObject->setProperty ("sampleRate", sampleRate);
+    headerObject->setProperty ("frames", totalFrames);
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+
+    // Raw PCM goes out block by block, so the client can start playing at once
+    if (output == "pcm" && path.isEmpty())
+    {
+        headerObject->setProperty ("format", "f32le");
+        headerObject->setProperty ("bytes", totalFrames * 2 * (juce::int64) sizeof (float));
+
+        if (! sendHeader (clientSocket, header))
+            return false;
+
+        std::vector<float> interleaved ((size_t) blockSize * 2);
+
+        for (juce::int64 done = 0; done < totalFrames;)
+        {
+            const auto numToRender = (int) juce::jmin ((juce::int64) blockSize, totalFrames - done);
+            renderer.render (buffer, numToRender);
+
+            for (int i = 0; i < numToRender; ++i)
+            {
+                interleaved[(size_t) (2 * i)] = buffer.getSample (0, i);
+                interleaved[(size_t) (2 * i + 1)] = buffer.getSample (1, i);
+            }
+
+            if (! sendAll (clientSocket, interleaved.data(), (size_t) numToRender * 2 * sizeof (float)))
+                return false;
+
+            done += numToRender;
+        }
+
+        return true;
+    }
+
+    // Encoded: to the requested file, or into memory and then down the socket
+    if (path.isNotEmpty() && ! juce::File::isAbsolutePath (path))
+        return sendError (clientSocket, id, "Output path must be absolute");
+
+    const auto extension = path.isNotEmpty() ? juce::File (path).getFileExtension() : "." + output;
+    auto* format = formatManager.findFormatForFileExtension (extension);
+
+    if (format == nullptr || ! format->getPossibleBitDepths().contains (bitsPerSample))
+        return sendError (clientSocket, id, "Unsupported format " + extension + " at " + juce::String (bitsPerSample) + " bits");
+
+    // Judged by the uncompressed size, which the encoded file does not exceed by much
+    if (path.isEmpty() && totalFrames * 2 * (bitsPerSample / 8) > maxInMemoryBytes)
+        return sendError (clientSocket, id, "Encoded output over " + juce::String (maxInMemoryBytes / (1024 * 1024))
+                                                + " MB needs a \"path\"; or use \"pcm\"");
+
+    juce::MemoryBlock encoded;
+    std::unique_ptr<juce::OutputStream> stream;
+
+    if (path.isNotEmpty())
+    {
+        const juce::File file (path);
+        file.deleteFile();
+        auto fileStream = std::make_unique<juce::FileOutputStream> (file);
+
+        if (fileStream->failedToOpen())
+            return sendError (clientSocket, id, "Cannot write " + path);
+
+        stream = std::move (fileStream);
+    }
+    else
+    {
+        // Writes into encoded, which outlives the writer and the stream it owns
+        stream = std::make_unique<juce::MemoryOutputStream> (encoded, false);
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer (
+        format->createWriterFor (stream, juce::AudioFormatWriterOptions{}.withSampleRate (sampleRate)
+                                                                         .withNumChannels (2)
+                                                                         .withBitsPerSample (bitsPerSample)).release());
+
+    if (writer == nullptr)
+        return sendError (clientSocket, id, "Cannot create " + format->getFormatName() + " writer");
+
+    for (juce::int64 done = 0; done < totalFrames;)
+    {
+        const auto numToRender = (int) juce::jmin ((juce::int64) blockSize, totalFrames - done);
+        renderer.render (buffer, numToRender);
+
+        if (! writer->writeFromAudioSampleBuffer (buffer, 0, numToRender))
+            return sendError (clientSocket, id, "Write failed");
+
+        done += numToRender;
+    }
+
+    // Finishes the header and trims encoded to the written size
+    writer.reset();
+
+    headerObject->setProperty ("format", format->getFormatName());
+
+    if (path.isNotEmpty())
+    {
+        headerObject->setProperty ("path", path);
+        headerObject->setProperty ("bytes", 0);
+        return sendHeader (clientSocket, header);
+    }
+
+    headerObject->setProperty ("bytes", (juce::int64) encoded.getSize());
+    return sendHeader (clientSocket, header) && sendAll (clientSocket, encoded.getData(), encoded.getSize());
+}
+
+OfflineRenderer::Settings RenderDaemon::parseSettings (const juce::var& json)
+{
+    OfflineRenderer::Settings settings;
+
+    auto read = [&json] (const char* name, auto& field)
+    {
+        if (json.hasProperty (name))
+            field = static_cast<std::remove_reference_t<decltype (field)>> (json.getProperty (name, {}));
+    };
+
+    read ("baseFrequency", settings.baseFrequency);
+    read ("binauralOffset", settings.binauralOffset);
+    read ("leftVolumeDb", settings.leftVolumeDb);
+    read ("rightVolumeDb", settings.rightVolumeDb);
+    read ("masterVolumeDb", settings.masterVolumeDb);
+    read ("masterTrimDb", settings.masterTrimDb);
+    read ("limiter", settings.limiter);
+    read ("limiterCeilingDb", settings.limiterCeilingDb);
+    read ("limiterLookAhead", settings.limiterLookAhead);
+    read ("spatializer", settings.spatializer);
+    read ("leftAzimuth", settings.leftAzimuth);
+    read ("rightAzimuth", settings.rightAzimuth);
+    read ("spatializerLatency", settings.spatializerLatency);
+    read ("backgroundVolumeDb", settings.backgroundVolumeDb);
+
+    const auto backgroundFile = json.getProperty ("backgroundFile", {}).toString();
+
+    if (juce::File::isAbsolutePath (backgroundFile))
+        settings.backgroundFile = juce::File (backgroundFile);
+
+    // Same limits as the plugin parameters
+    settings.baseFrequency = juce::jlimit (20.0f, 20000.0f, settings.baseFrequency);
+    settings.binauralOffset = juce::jlimit (0.0f, 100.0f, settings.binauralOffset);
+    settings.limiterLookAhead = juce::jlimit (0, 4096, settings.limiterLookAhead);
+    settings.spatializerLatency = juce::jlimit (0, 8192, settings.spatializerLatency);
+    return settings;
+}
+
+//==============================================================================
+bool RenderDaemon::sendAll (int clientSocket, const void* data, size_t numBytes)
+{
+    auto* bytes = static_cast<const char*> (data);
+
+    while (numBytes > 0)
+    {
+        const auto numSent = ::send (clientSocket, bytes, numBytes, sendFlags);
+
+        if (numSent <= 0)
+            return false;
+
+        bytes += numSent;
+        numBytes -= (size_t) numSent;
+    }
+
+    return true;
+}
+
+bool RenderDaemon::sendHeader (int clientSocket, const juce::var& header)
+{
+    const auto line = juce::JSON::toString (header, true) + "\n";
+    return sendAll (clientSocket, line.toRawUTF8(), line.getNumBytesAsUTF8());
+}
+
+bool RenderDaemon::sendError (int clientSocket, const juce::var& id, const juce::String& message)
+{
+    auto* error = new juce::DynamicObject();
+    error->setProperty ("id", id);
+    error->setProperty ("status", "error");
+    error->setProperty ("message", message);
+    return sendHeader (clientSocket, juce::var (error));
+}
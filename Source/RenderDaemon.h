@@ -0,0 +1,85 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "OfflineRenderer.h"
+#include "BlockSizeTuner.h"
+
+//==============================================================================
+/**
+    Long-lived render server for authoring tools, listening on a Unix domain
+    socket so previews skip process start-up and format registration.
+
+    Each client sends jobs as one JSON object per line:
+
+        {"id": "a1", "sampleRate": 48000, "duration": 4.0,
+         "settings": {"baseFrequency": 200, "binauralOffset": 6, ...},
+         "output": "pcm" | "wav" | "aiff" | "flac" | "ogg", "bitsPerSample": 24,
+         "path": "/abs/file.wav"}
+
+    "settings" takes the OfflineRenderer::Settings field names
+    (backgroundFile as an absolute path); missing fields keep their
+    defaults. Every job gets one JSON line back, then the audio:
+
+        {"id": "a1", "status": "ok", "format": "f32le", "channels": 2,
+         "sampleRate": 48000, "frames": 192000, "bytes": 1536000}
+
+    "pcm" (the default) streams interleaved 32-bit float frames as they are
+    rendered; the file formats are encoded in memory and sent whole, up to
+    256 MB of uncompressed audio (about 15 minutes at 48 kHz, 24 bits). With
+    "path" the file is written there instead, at any length, and "bytes" is 0. Failures
+    answer {"id", "status": "error", "message"} and keep the connection open.
+
+    Each connection has its own small reader thread, which hands its jobs to
+    a pool of worker threads and waits for each one, so several clients
+    render at once, the jobs of one connection run in order, and an idle
+    connection never holds a worker. Jobs use the
+    block size from the tuner's override or profile and never calibrate, so
+    one client's first job does not hold up the others.
+*/
+class RenderDaemon  : private juce::Thread
+{
+public:
+    RenderDaemon (const juce::File& socketFile, int numWorkerThreads = juce::SystemStats::getNumCpus());
+    ~RenderDaemon() override;
+
+    /** Binds the socket (replacing a stale one) and starts accepting clients. */
+    juce::Result start();
+
+    /** Stops accepting, waits for running jobs and removes the socket. */
+    void stop();
+
+    const juce::File& getSocketFile() const noexcept  { return socketFile; }
+
+    /** $XDG_RUNTIME_DIR/binaural-render.sock, or a per-user file in /tmp. */
+    static juce::File getDefaultSocketFile();
+
+private:
+    class Connection;
+    class RenderJob;
+
+    void run() override;
+    void serve (int clientSocket);
+    bool submitJob (int clientSocket, const juce::String& line);
+    bool handleJob (int clientSocket, const juce::String& line);
+
+    static OfflineRenderer::Settings parseSettings (const juce::var& json);
+    static bool sendAll (int clientSocket, const void* data, size_t numBytes);
+    static bool sendHeader (int clientSocket, const juce::var& header);
+    static bool sendError (int clientSocket, const juce::var& id, const juce::String& message);
+
+    const juce::File socketFile;
+    int listenSocket = -1;
+
+    // Open connections, shut down by stop() so their readers return.
+    // Once stopping is set no more jobs are submitted
+    juce::CriticalSection clientLock;
+    juce::OwnedArray<Connection> connections;
+    bool stopping = false;
+
+    // Shared by every job: registration happens once, lookups are read-only
+    juce::AudioFormatManager formatManager;
+    BlockSizeTuner blockSizeTuner;
+    juce::ThreadPool workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderDaemon)
+};
@@ -0,0 +1,56 @@
+#include "RenderDaemon.h"
+
+#include <csignal>
+
+//==============================================================================
+/*
+    binaural-render-daemon [--socket PATH] [--workers N]
+
+    Serves render jobs on a Unix domain socket until SIGINT or SIGTERM (see
+    RenderDaemon.h for the protocol).
+*/
+namespace
+{
+    // Only a lock-free flag may be touched from a signal handler
+    std::atomic<bool> shutdownRequested { false };
+
+    void requestShutdown (int)
+    {
+        shutdownRequested = true;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList arguments (argc, argv);
+
+    const auto socketFile = arguments.containsOption ("--socket")
+                                ? juce::File (arguments.getValueForOption ("--socket"))
+                                : RenderDaemon::getDefaultSocketFile();
+    const auto numWorkers = arguments.containsOption ("--workers")
+                                ? arguments.getValueForOption ("--workers").getIntValue()
+                                : juce::SystemStats::getNumCpus();
+
+    // Clients that hang up mid-stream show up as failed sends, not signals
+    std::signal (SIGPIPE, SIG_IGN);
+    std::signal (SIGINT, requestShutdown);
+    std::signal (SIGTERM, requestShutdown);
+
+    RenderDaemon daemon (socketFile, numWorkers);
+    const auto result = daemon.start();
+
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Listening on " << socketFile.getFullPathName() << " with "
+              << juce::jmax (1, numWorkers) << " workers" << std::endl;
+
+    while (! shutdownRequested)
+        juce::Thread::sleep (200);
+
+    daemon.stop();
+    return 0;
+}
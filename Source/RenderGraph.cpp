@@ -0,0 +1,303 @@
+#include "RenderGraph.h"
+
+//==============================================================================
+RenderGraph::NodeID RenderGraph::addNode (std::unique_ptr<RenderNode> node)
+{
+    jassert (node != nullptr);
+
+    inputSources.emplace_back ((size_t) node->getNumInputs());
+    nodes.push_back (std::move (node));
+    return (NodeID) nodes.size() - 1;
+}
+
+RenderNode* RenderGraph::getNode (NodeID id) const noexcept
+{
+    return juce::isPositiveAndBelow (id, (int) nodes.size()) ? nodes[(size_t) id].get() : nullptr;
+}
+
+bool RenderGraph::connect (NodeID source, int sourcePort, NodeID destination, int destinationPort)
+{
+    auto* sourceNode = getNode (source);
+    auto* destinationNode = getNode (destination);
+
+    if (sourceNode == nullptr || destinationNode == nullptr
+         || ! juce::isPositiveAndBelow (sourcePort, sourceNode->getNumOutputs())
+         || ! juce::isPositiveAndBelow (destinationPort, destinationNode->getNumInputs()))
+    {
+        jassertfalse;
+        return false;
+    }
+
+    inputSources[(size_t) destination][(size_t) destinationPort] = { source, sourcePort };
+    return true;
+}
+
+void RenderGraph::setOutput (int outputChannel, NodeID source, int sourcePort)
+{
+    jassert (outputChannel >= 0);
+
+    if ((size_t) outputChannel >= outputSources.size())
+        outputSources.resize ((size_t) outputChannel + 1);
+
+    outputSources[(size_t) outputChannel] = { source, sourcePort };
+}
+
+void RenderGraph::clear()
+{
+    nodes.clear();
+    inputSources.clear();
+    outputSources.clear();
+    schedule.clear();
+    inputPointers.clear();
+    outputPointers.clear();
+    graphOutputPointers.clear();
+    numScratchBuffers = 0;
+}
+
+//==============================================================================
+bool RenderGraph::prepare (const juce::dsp::ProcessSpec& spec, int numOutputChannels)
+{
+    std::vector<NodeID> order;
+
+    if (! buildSchedule (order))
+    {
+        jassertfalse; // cycles are not supported
+        schedule.clear();
+        return false;
+    }
+
+    scratch.setSize (1, (int) spec.maximumBlockSize);
+    assignBuffers (order, numOutputChannels);
+
+    for (auto id : order)
+        nodes[(size_t) id]->prepare (spec);
+
+    return true;
+}
+
+void RenderGraph::reset()
+{
+    for (auto& node : nodes)
+        node->reset();
+}
+
+bool RenderGraph::buildSchedule (std::vector<NodeID>& order) const
+{
+    const auto numNodes = nodes.size();
+
+    // Only nodes that feed an output are scheduled
+    std::vector<bool> reachable (numNodes, false);
+    std::vector<NodeID> stack;
+
+    for (const auto& output : outputSources)
+        if (getNode (output.node) != nullptr)
+            stack.push_back (output.node);
+
+    while (! stack.empty())
+    {
+        const auto id = stack.back();
+        stack.pop_back();
+
+        if (reachable[(size_t) id])
+            continue;
+
+        reachable[(size_t) id] = true;
+
+        for (const auto& source : inputSources[(size_t) id])
+            if (getNode (source.node) != nullptr)
+                stack.push_back (source.node);
+    }
+
+    // Kahn's algorithm, lowest ID first so the order is deterministic
+    std::vector<int> pendingInputs (numNodes, 0);
+    std::vector<std::vector<NodeID>> consumers (numNodes);
+    size_t numReachable = 0;
+
+    for (size_t id = 0; id < numNodes; ++id)
+    {
+        if (! reachable[id])
+            continue;
+
+        ++numReachable;
+
+        for (const auto& source : inputSources[id])
+        {
+            if (getNode (source.node) == nullptr)
+                continue;
+
+            ++pendingInputs[id];
+            consumers[(size_t) source.node].push_back ((NodeID) id);
+        }
+    }
+
+    std::vector<NodeID> ready;
+
+    for (size_t id = numNodes; id-- > 0;)
+        if (reachable[id] && pendingInputs[id] == 0)
+            ready.push_back ((NodeID) id);
+
+    order.clear();
+
+    while (! ready.empty())
+    {
+        const auto id = ready.back();
+        ready.pop_back();
+        order.push_back (id);
+
+        for (auto consumer : consumers[(size_t) id])
+            if (--pendingInputs[(size_t) consumer] == 0)
+                ready.push_back (consumer);
+
+        std::sort (ready.begin(), ready.end(), std::greater<NodeID>());
+    }
+
+    return order.size() == numReachable;
+}
+
+void RenderGraph::assignBuffers (const std::vector<NodeID>& order, int numOutputChannels)
+{
+    const auto numSteps = (int) order.size();
+    const auto numNodes = nodes.size();
+
+    // Liveness: the last step that reads each output port (-1 = never read)
+    std::vector<std::vector<int>> lastUse (numNodes);
+    std::vector<std::vector<int>> bufferOf (numNodes);
+
+    for (size_t id = 0; id < numNodes; ++id)
+    {
+        lastUse[id].assign ((size_t) nodes[id]->getNumOutputs(), -1);
+        bufferOf[id].assign ((size_t) nodes[id]->getNumOutputs(), -1);
+    }
+
+    for (int step = 0; step < numSteps; ++step)
+        for (const auto& source : inputSources[(size_t) order[(size_t) step]])
+            if (getNode (source.node) != nullptr)
+                lastUse[(size_t) source.node][(size_t) source.port] = step;
+
+    for (const auto& output : outputSources)
+        if (getNode (output.node) != nullptr)
+            lastUse[(size_t) output.node][(size_t) output.port] = numSteps;
+
+    // Greedy allocation over the schedule, recycling buffers as values die
+    std::vector<int> freeBuffers;
+    int numBuffers = 0;
+
+    auto takeBuffer = [&]
+    {
+        if (freeBuffers.empty())
+            return numBuffers++;
+
+        const auto buffer = freeBuffers.back();
+        freeBuffers.pop_back();
+        return buffer;
+    };
+
+    for (int step = 0; step < numSteps; ++step)
+    {
+        const auto id = (size_t) order[(size_t) step];
+        const auto& node = *nodes[id];
+        const auto& sources = inputSources[id];
+        std::vector<Port> inheritedInputs;
+
+        for (int port = 0; port < node.getNumOutputs(); ++port)
+        {
+            // Run in place when the matching input dies here and is read only once
+            if (node.canProcessInPlace() && port < node.getNumInputs())
+            {
+                const auto source = sources[(size_t) port];
+
+                if (getNode (source.node) != nullptr
+                     && lastUse[(size_t) source.node][(size_t) source.port] == step
+                     && std::count_if (sources.begin(), sources.end(), [source] (const Port& p)
+                                       { return p.node == source.node && p.port == source.port; }) == 1)
+                {
+                    bufferOf[id][(size_t) port] = bufferOf[(size_t) source.node][(size_t) source.port];
+                    inheritedInputs.push_back (source);
+                    continue;
+                }
+            }
+
+            bufferOf[id][(size_t) port] = takeBuffer();
+        }
+
+        // Release inputs whose last reader was this step
+        std::vector<Port> released;
+
+        for (const auto& source : sources)
+        {
+            if (getNode (source.node) == nullptr || lastUse[(size_t) source.node][(size_t) source.port] != step)
+                continue;
+
+            auto samePort = [source] (const Port& p) { return p.node == source.node && p.port == source.port; };
+
+            if (std::any_of (inheritedInputs.begin(), inheritedInputs.end(), samePort)
+                 || std::any_of (released.begin(), released.end(), samePort))
+                continue;
+
+            released.push_back (source);
+            freeBuffers.push_back (bufferOf[(size_t) source.node][(size_t) source.port]);
+        }
+
+        // Outputs nobody reads still need somewhere to be written to
+        for (int port = 0; port < node.getNumOutputs(); ++port)
+            if (lastUse[id][(size_t) port] < 0)
+                freeBuffers.push_back (bufferOf[id][(size_t) port]);
+    }
+
+    // Last channel stays silent and feeds unconnected inputs
+    numScratchBuffers = numBuffers;
+    scratch.setSize (numBuffers + 1, scratch.getNumSamples());
+    scratch.clear();
+
+    const auto* silence = scratch.getReadPointer (numBuffers);
+
+    schedule.clear();
+    inputPointers.clear();
+    outputPointers.clear();
+
+    for (auto id : order)
+    {
+        auto& node = *nodes[(size_t) id];
+        schedule.push_back ({ &node, inputPointers.size(), outputPointers.size() });
+
+        for (const auto& source : inputSources[(size_t) id])
+            inputPointers.push_back (getNode (source.node) != nullptr
+                                        ? scratch.getReadPointer (bufferOf[(size_t) source.node][(size_t) source.port])
+                                        : silence);
+
+        for (int port = 0; port < node.getNumOutputs(); ++port)
+            outputPointers.push_back (scratch.getWritePointer (bufferOf[(size_t) id][(size_t) port]));
+    }
+
+    graphOutputPointers.assign ((size_t) numOutputChannels, nullptr);
+
+    for (size_t channel = 0; channel < graphOutputPointers.size() && channel < outputSources.size(); ++channel)
+    {
+        const auto& output = outputSources[channel];
+
+        if (getNode (output.node) != nullptr)
+            graphOutputPointers[channel] = scratch.getReadPointer (bufferOf[(size_t) output.node][(size_t) output.port]);
+    }
+}
+
+//==============================================================================
+void RenderGraph::process (float* const* outputs, int numOutputChannels, int numSamples) noexcept
+{
+    jassert (numSamples <= scratch.getNumSamples());
+
+    for (const auto& step : schedule)
+        step.node->process (inputPointers.data() + step.firstInput,
+                            outputPointers.data() + step.firstOutput,
+                            numSamples);
+
+    for (int channel = 0; channel < numOutputChannels; ++channel)
+    {
+        const auto* source = (size_t) channel < graphOutputPointers.size() ? graphOutputPointers[(size_t) channel]
+                                                                          : nullptr;
+
+        if (source != nullptr)
+            juce::FloatVectorOperations::copy (outputs[channel], source, numSamples);
+        else
+            juce::FloatVectorOperations::clear (outputs[channel], numSamples);
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+//==============================================================================
+/**
+    Base class for a processing node in a RenderGraph.
+
+    A node has a fixed number of mono input and output ports. process() is
+    called once per block with one pointer per port; the per-sample loop lives
+    inside the node, so the virtual call is paid once per block, never per
+    sample. Nodes must not allocate in process().
+*/
+class RenderNode
+{
+public:
+    RenderNode (int numInputPorts, int numOutputPorts)
+        : numInputs (numInputPorts), numOutputs (numOutputPorts)
+    {
+    }
+
+    virtual ~RenderNode() = default;
+
+    int getNumInputs() const noexcept   { return numInputs; }
+    int getNumOutputs() const noexcept  { return numOutputs; }
+
+    virtual void prepare (const juce::dsp::ProcessSpec&) {}
+    virtual void reset() {}
+
+    /** Output port n may share its buffer with input port n when this returns
+        true, which lets the graph run element-wise nodes in place.
+    */
+    virtual bool canProcessInPlace() const noexcept  { return false; }
+
+    virtual void process (const float* const* inputs, float* const* outputs, int numSamples) noexcept = 0;
+
+private:
+    const int numInputs, numOutputs;
+
+    JUCE_DECLARE_NON_COPYABLE (RenderNode)
+};
+
+//==============================================================================
+/**
+    Small processing graph that renders a fixed number of output channels.
+
+    Nodes and connections are edited freely before prepare(). prepare() then
+    schedules the nodes reachable from the outputs in topological order and
+    assigns scratch buffers by liveness: a buffer returns to the pool right
+    after the last node that reads it, so the peak working set is the largest
+    number of signals alive at any one step rather than one buffer per port.
+    process() only walks the precomputed schedule.
+*/
+class RenderGraph
+{
+public:
+    using NodeID = int;
+
+    RenderGraph() = default;
+
+    /** Adds a node and returns a reference to it; its ID is written to idOut. */
+    template <typename NodeType, typename... Args>
+    NodeType& addNode (NodeID& idOut, Args&&... args)
+    {
+        auto node = std::make_unique<NodeType> (std::forward<Args> (args)...);
+        auto& ref = *node;
+        idOut = addNode (std::move (node));
+        return ref;
+    }
+
+    NodeID addNode (std::unique_ptr<RenderNode> node);
+    RenderNode* getNode (NodeID id) const noexcept;
+
+    /** Feeds an output port into an input port; an input takes a single source. */
+    bool connect (NodeID source, int sourcePort, NodeID destination, int destinationPort);
+
+    /** Routes a node output to one of the graph's output channels. */
+    void setOutput (int outputChannel, NodeID source, int sourcePort);
+
+    void clear();
+
+    /** Builds the schedule and scratch buffers; returns false if the graph has a cycle. */
+    bool prepare (const juce::dsp::ProcessSpec& spec, int numOutputChannels);
+    void reset();
+
+    /** Renders numSamples into the output channels. Unrouted outputs are cleared. */
+    void process (float* const* outputs, int numOutputChannels, int numSamples) noexcept;
+
+    int getNumScratchBuffers() const noexcept  { return numScratchBuffers; }
+
+private:
+    struct Port
+    {
+        NodeID node = -1;
+        int port = 0;
+    };
+
+    struct Step
+    {
+        RenderNode* node;
+        size_t firstInput, firstOutput;
+    };
+
+    bool buildSchedule (std::vector<NodeID>& order) const;
+    void assignBuffers (const std::vector<NodeID>& order, int numOutputChannels);
+
+    std::vector<std::unique_ptr<RenderNode>> nodes;
+    std::vector<std::vector<Port>> inputSources;   // per node, per input port
+    std::vector<Port> outputSources;               // per graph output channel
+
+    // Compiled schedule
+    std::vector<Step> schedule;
+    std::vector<const float*> inputPointers;
+    std::vector<float*> outputPointers;
+    std::vector<const float*> graphOutputPointers;
+    juce::AudioBuffer<float> scratch;
+    int numScratchBuffers = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderGraph)
+};
@@ -0,0 +1,510 @@
+#pragma once
+
+#include "RenderGraph.h"
+#include "BinauralOscillator.h"
+#include "BackgroundLayer.h"
+#include "LookAheadLimiter.h"
+
+//==============================================================================
+/** Sine carrier. */
+class OscillatorNode final : public RenderNode
+{
+public:
+    OscillatorNode() : RenderNode (0, 1) {}
+
+    BinauralOscillator& getOscillator() noexcept  { return oscillator; }
+
+    void prepare (const juce::dsp::ProcessSpec& spec) override  { oscillator.prepare (spec); }
+    void reset() override                                      { oscillator.reset(); }
+
+    void process (const float* const*, float* const* outputs, int numSamples) noexcept override
+    {
+        oscillator.renderBlock (outputs[0], numSamples);
+    }
+
+private:
+    BinauralOscillator oscillator;
+};
+
+//==============================================================================
+/** White or pink noise from a xorshift generator. */
+class NoiseNode final : public RenderNode
+{
+public:
+    enum class Colour
+    {
+        White,
+        Pink
+    };
+
+    explicit NoiseNode (Colour noiseColour = Colour::White)
+        : RenderNode (0, 1), colour (noiseColour)
+    {
+    }
+
+    void setLevel (float amplitude) noexcept  { level = amplitude; }
+
+    void reset() override
+    {
+        state = 0x9e3779b9u;
+        pink = {};
+    }
+
+    void process (const float* const*, float* const* outputs, int numSamples) noexcept override
+    {
+        auto* dest = outputs[0];
+
+        if (colour == Colour::White)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                dest[i] = level * nextWhite();
+
+            return;
+        }
+
+        // Paul Kellet's economy pink filter
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto white = nextWhite();
+            pink[0] = 0.99765f * pink[0] + white * 0.0990460f;
+            pink[1] = 0.96300f * pink[1] + white * 0.2965164f;
+            pink[2] = 0.57000f * pink[2] + white * 1.0526913f;
+            dest[i] = level * 0.25f * (pink[0] + pink[1] + pink[2] + white * 0.1848f);
+        }
+    }
+
+private:
+    float nextWhite() noexcept
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (float) state * (2.0f / 4294967296.0f) - 1.0f;
+    }
+
+    const Colour colour;
+    float level = 1.0f;
+    juce::uint32 state = 0x9e3779b9u;
+    std::array<float, 3> pink {};
+};
+
+//==============================================================================
+/** Streams a BackgroundLayer as a stereo pair; silent while no layer is set. */
+class FilePlayerNode final : public RenderNode
+{
+public:
+    FilePlayerNode() : RenderNode (0, 2) {}
+
+    void setLayer (BackgroundLayer* newLayer) noexcept  { layer = newLayer; }
+    void setGain (float amplitude) noexcept             { gain = amplitude; }
+    void setWaitForData (bool shouldWait) noexcept      { waitForData = shouldWait; }
+
+    bool isSilent() const noexcept  { return layer == nullptr || gain == 0.0f; }
+
+    /** Per-sample gain factors for the next block, or nullptr. */
+    void setGainModulation (const float* factors) noexcept  { gainModulation = factors; }
+
+    void process (const float* const*, float* const* outputs, int numSamples) noexcept override
+    {
+        juce::FloatVectorOperations::clear (outputs[0], numSamples);
+        juce::FloatVectorOperations::clear (outputs[1], numSamples);
+
+        if (layer == nullptr)
+            return;
+
+        layer->addTo (outputs[0], outputs[1], numSamples, gain, waitForData);
+
+        if (gainModulation != nullptr)
+        {
+            juce::FloatVectorOperations::multiply (outputs[0], gainModulation, numSamples);
+            juce::FloatVectorOperations::multiply (outputs[1], gainModulation, numSamples);
+        }
+    }
+
+private:
+    BackgroundLayer* layer = nullptr;
+    const float* gainModulation = nullptr;
+    float gain = 1.0f;
+    bool waitForData = false;
+};
+
+//==============================================================================
+/** Smoothed gain applied to every channel alike. */
+class GainNode final : public RenderNode
+{
+public:
+    explicit GainNode (int numChannels) : RenderNode (numChannels, numChannels) {}
+
+    void setGainLinear (float amplitude) noexcept  { gain.setTargetValue (amplitude); }
+
+    /** Per-sample gain factors for the next block, on top of the gain, or nullptr. */
+    void setGainModulation (const float* factors) noexcept  { gainModulation = factors; }
+
+    /** True once the gain has settled at zero. */
+    bool isSilent() const noexcept  { return ! gain.isSmoothing() && gain.getTargetValue() == 0.0f; }
+
+    /** Moves the gain ramp on by numSamples without processing. */
+    void advance (int numSamples) noexcept  { gain.skip (numSamples); }
+
+    bool canProcessInPlace() const noexcept override  { return true; }
+
+    void prepare (const juce::dsp::ProcessSpec& spec) override
+    {
+        gain.reset (spec.sampleRate, 0.02);
+        ramp.resize (spec.maximumBlockSize);
+    }
+
+    void reset() override
+    {
+        gain.setCurrentAndTargetValue (gain.getTargetValue());
+    }
+
+    void process (const float* const* inputs, float* const* outputs, int numSamples) noexcept override
+    {
+        if (! gain.isSmoothing() && gainModulation == nullptr)
+        {
+            for (int channel = 0; channel < getNumOutputs(); ++channel)
+                juce::FloatVectorOperations::copyWithMultiply (outputs[channel], inputs[channel],
+                                                               gain.getTargetValue(), numSamples);
+            return;
+        }
+
+        if (gain.isSmoothing())
+            for (int i = 0; i < numSamples; ++i)
+                ramp[(size_t) i] = gain.getNextValue();
+        else
+            juce::FloatVectorOperations::fill (ramp.data(), gain.getTargetValue(), numSamples);
+
+        if (gainModulation != nullptr)
+            juce::FloatVectorOperations::multiply (ramp.data(), gainModulation, numSamples);
+
+        for (int channel = 0; channel < getNumOutputs(); ++channel)
+            juce::FloatVectorOperations::multiply (outputs[channel], inputs[channel], ramp.data(), numSamples);
+    }
+
+private:
+    juce::SmoothedValue<float> gain { 1.0f };
+    std::vector<float> ramp;
+    const float* gainModulation = nullptr;
+};
+
+//==============================================================================
+/** Constant-power mono to stereo panner; pan runs from -1 (left) to 1 (right). */
+class PanNode final : public RenderNode
+{
+public:
+    PanNode() : RenderNode (1, 2) {}
+
+    bool canProcessInPlace() const noexcept override  { return true; }
+
+    void setPan (float newPan) noexcept
+    {
+        const auto angle = (juce::jlimit (-1.0f, 1.0f, newPan) + 1.0f) * juce::MathConstants<float>::pi * 0.25f;
+        leftGain = std::cos (angle);
+        rightGain = std::sin (angle);
+    }
+
+    void process (const float* const* inputs, float* const* outputs, int numSamples) noexcept override
+    {
+        // Right first: the left output may share the input's buffer
+        juce::FloatVectorOperations::copyWithMultiply (outputs[1], inputs[0], rightGain, numSamples);
+        juce::FloatVectorOperations::copyWithMultiply (outputs[0], inputs[0], leftGain, numSamples);
+    }
+
+private:
+    float leftGain = juce::MathConstants<float>::sqrt2 * 0.5f;
+    float rightGain = juce::MathConstants<float>::sqrt2 * 0.5f;
+};
+
+//==============================================================================
+/**
+    Fixed pool of binaural voices (a left/right oscillator pair per note).
+
+    Voices are allocated up front; starting a note takes a free voice or
+    steals the oldest one, and a released voice returns to the pool once its
+    fade-out has finished. Nothing here allocates after prepare().
+*/
+class VoicePoolNode final : public RenderNode
+{
+public:
+    static constexpr int maxVoices = 16;
+    static constexpr int numChannels = 16;
+
+    VoicePoolNode() : RenderNode (0, 2)
+    {
+        bendRatios.fill (1.0f);
+    }
+
+    void prepare (const juce::dsp::ProcessSpec& spec) override
+    {
+        for (auto& voice : voices)
+        {
+            voice.left.prepare (spec);
+            voice.right.prepare (spec);
+            voice.tailLeft.prepare (spec);
+            voice.tailRight.prepare (spec);
+        }
+
+        scratch.resize (spec.maximumBlockSize);
+        reset();
+    }
+
+    void reset() override
+    {
+        for (auto& voice : voices)
+        {
+            voice.left.setAmplitude (0.0f);
+            voice.right.setAmplitude (0.0f);
+            voice.left.reset();
+            voice.right.reset();
+            voice.note = -1;
+            voice.active = false;
+            voice.tailActive = false;
+        }
+    }
+
+    void noteOn (int channel, int note, float frequency, float velocity) noexcept
+    {
+        auto& voice = findVoiceToStart();
+
+        // A stolen voice that is still sounding fades out on the tail pair
+        // rather than being cut, so the steal does not click
+        if (voice.active)
+        {
+            voice.tailLeft = voice.left;
+            voice.tailRight = voice.right;
+            voice.tailLeft.setAmplitude (0.0f);
+            voice.tailRight.setAmplitude (0.0f);
+            voice.tailActive = true;
+        }
+
+        voice.channel = juce::jlimit (0, numChannels - 1, channel);
+        voice.note = note;
+        voice.noteFrequency = frequency;
+        voice.velocity = velocity;
+        voice.active = true;
+        voice.age = ++voiceCounter;
+
+        // Restart from silence so the new note fades in
+        voice.left.setAmplitude (0.0f);
+        voice.right.setAmplitude (0.0f);
+        voice.left.reset();
+        voice.right.reset();
+        updatePitch (voice, true);
+        voice.left.setAmplitude (velocity * leftVolume);
+        voice.right.setAmplitude (velocity * rightVolume);
+    }
+
+    void noteOff (int channel, int note) noexcept
+    {
+        for (auto& voice : voices)
+        {
+            if (voice.note == note && voice.channel == channel)
+            {
+                voice.note = -1;
+                voice.left.setAmplitude (0.0f);
+                voice.right.setAmplitude (0.0f);
+            }
+        }
+    }
+
+    void allNotesOff() noexcept
+    {
+        for (auto& voice : voices)
+        {
+            voice.note = -1;
+            voice.left.setAmplitude (0.0f);
+            voice.right.setAmplitude (0.0f);
+        }
+    }
+
+    void setPitchBend (int channel, float ratio) noexcept
+    {
+        bendRatios[(size_t) juce::jlimit (0, numChannels - 1, channel)] = ratio;
+
+        for (auto& voice : voices)
+            if (voice.active && voice.channel == channel)
+                updatePitch (voice, true);
+    }
+
+    void setBinauralOffset (float offsetHz) noexcept
+    {
+        binauralOffset = offsetHz;
+
+        for (auto& voice : voices)
+            if (voice.active)
+                updatePitch (voice, false);
+    }
+
+    bool hasActiveVoices() const noexcept
+    {
+        return std::any_of (voices.begin(), voices.end(), [] (const Voice& voice) { return voice.active || voice.tailActive; });
+    }
+
+    /** Moves the sounding voices on by numSamples without rendering them. */
+    void advance (int numSamples) noexcept
+    {
+        for (auto& voice : voices)
+        {
+            if (voice.tailActive)
+            {
+                voice.tailLeft.advance (numSamples);
+                voice.tailRight.advance (numSamples);
+                voice.tailActive = ! (voice.tailLeft.isSilent() && voice.tailRight.isSilent());
+            }
+
+            if (! voice.active)
+                continue;
+
+            voice.left.advance (numSamples);
+            voice.right.advance (numSamples);
+
+            if (voice.note < 0 && voice.left.isSilent() && voice.right.isSilent())
+                voice.active = false;
+        }
+    }
+
+    void setVolumes (float left, float right) noexcept
+    {
+        leftVolume = left;
+        rightVolume = right;
+
+        for (auto& voice : voices)
+        {
+            if (voice.note >= 0)
+            {
+                voice.left.setAmplitude (voice.velocity * leftVolume);
+                voice.right.setAmplitude (voice.velocity * rightVolume);
+            }
+        }
+    }
+
+    void process (const float* const*, float* const* outputs, int numSamples) noexcept override
+    {
+        juce::FloatVectorOperations::clear (outputs[0], numSamples);
+        juce::FloatVectorOperations::clear (outputs[1], numSamples);
+
+        for (auto& voice : voices)
+        {
+            if (voice.tailActive)
+            {
+                renderInto (voice.tailLeft, voice.tailRight, outputs, numSamples);
+                voice.tailActive = ! (voice.tailLeft.isSilent() && voice.tailRight.isSilent());
+            }
+
+            if (! voice.active)
+                continue;
+
+            renderInto (voice.left, voice.right, outputs, numSamples);
+
+            // Released and faded out: back to the pool
+            if (voice.note < 0 && voice.left.isSilent() && voice.right.isSilent())
+                voice.active = false;
+        }
+    }
+
+private:
+    struct Voice
+    {
+        BinauralOscillator left, right;
+        BinauralOscillator tailLeft, tailRight;    // a stolen note fading out
+        int channel = 0;
+        int note = -1;             // -1 once released
+        float noteFrequency = 440.0f;
+        float velocity = 0.0f;
+        bool active = false;       // still sounding, possibly fading out
+        bool tailActive = false;
+        juce::uint32 age = 0;
+    };
+
+    void renderInto (BinauralOscillator& left, BinauralOscillator& right, float* const* outputs, int numSamples) noexcept
+    {
+        left.renderBlock (scratch.data(), numSamples);
+        juce::FloatVectorOperations::add (outputs[0], scratch.data(), numSamples);
+
+        right.renderBlock (scratch.data(), numSamples);
+        juce::FloatVectorOperations::add (outputs[1], scratch.data(), numSamples);
+    }
+
+    Voice& findVoiceToStart() noexcept
+    {
+        Voice* oldest = &voices.front();
+
+        for (auto& voice : voices)
+        {
+            if (! voice.active)
+                return voice;
+
+            if (voice.age < oldest->age)
+                oldest = &voice;
+        }
+
+        return *oldest;
+    }
+
+    void updatePitch (Voice& voice, bool immediately) noexcept
+    {
+        const auto frequency = voice.noteFrequency * bendRatios[(size_t) voice.channel];
+        voice.left.setFrequency (frequency, immediately);
+        voice.right.setFrequency (frequency + binauralOffset, immediately);
+    }
+
+    std::array<Voice, maxVoices> voices;
+    std::array<float, numChannels> bendRatios;
+    std::vector<float> scratch;
+    juce::uint32 voiceCounter = 0;
+
+    float binauralOffset = 10.0f;
+    float leftVolume = 1.0f;
+    float rightVolume = 1.0f;
+};
+
+//==============================================================================
+/** Sums its inputs into one output. */
+class MixNode final : public RenderNode
+{
+public:
+    explicit MixNode (int numInputs) : RenderNode (numInputs, 1) {}
+
+    bool canProcessInPlace() const noexcept override  { return true; }
+
+    void process (const float* const* inputs, float* const* outputs, int numSamples) noexcept override
+    {
+        if (outputs[0] != inputs[0])
+            juce::FloatVectorOperations::copy (outputs[0], inputs[0], numSamples);
+
+        for (int input = 1; input < getNumInputs(); ++input)
+            juce::FloatVectorOperations::add (outputs[0], inputs[input], numSamples);
+    }
+};
+
+//==============================================================================
+/** Look-ahead brickwall limiter across all of its channels. */
+class LimiterNode final : public RenderNode
+{
+public:
+    explicit LimiterNode (int numChannels) : RenderNode (numChannels, numChannels) {}
+
+    LookAheadLimiter& getLimiter() noexcept  { return limiter; }
+
+    bool canProcessInPlace() const noexcept override  { return true; }
+
+    void prepare (const juce::dsp::ProcessSpec& spec) override
+    {
+        limiter.prepare ({ spec.sampleRate, spec.maximumBlockSize, (juce::uint32) getNumOutputs() });
+    }
+
+    void reset() override  { limiter.reset(); }
+
+    void process (const float* const* inputs, float* const* outputs, int numSamples) noexcept override
+    {
+        for (int channel = 0; channel < getNumOutputs(); ++channel)
+            if (outputs[channel] != inputs[channel])
+                juce::FloatVectorOperations::copy (outputs[channel], inputs[channel], numSamples);
+
+        limiter.process (outputs, getNumOutputs(), numSamples);
+    }
+
+private:
+    LookAheadLimiter limiter;
+};
@@ -0,0 +1,83 @@
+#include "SeamlessLoop.h"
+
+namespace
+{
+    double getCycleError (float frequency, double sampleRate, int numSamples) noexcept
+    {
+        // Same increment as BinauralOscillator: the float frequency over the rate
+        const auto cycles = (double) frequency / sampleRate * (double) numSamples;
+        return std::abs (cycles - std::round (cycles));
+    }
+
+    float getRetunedFrequency (float frequency, double sampleRate, int numSamples) noexcept
+    {
+        const auto cycles = std::round ((double) frequency / sampleRate * (double) numSamples);
+        return (float) (cycles * sampleRate / (double) numSamples);
+    }
+}
+
+//==============================================================================
+double SeamlessLoop::getPhaseError (float leftFrequency, float rightFrequency, double sampleRate,
+                                    int numSamples) noexcept
+{
+    return juce::jmax (getCycleError (leftFrequency, sampleRate, numSamples),
+                       getCycleError (rightFrequency, sampleRate, numSamples));
+}
+
+SeamlessLoop::Plan SeamlessLoop::plan (float leftFrequency, float rightFrequency, double sampleRate,
+                                       double targetSeconds, bool needsCrossfade, double tolerance)
+{
+    const auto target = juce::jmax (1, juce::roundToInt (targetSeconds * sampleRate));
+    const auto searchRange = target / 10;
+
+    Plan best;
+    best.lengthSamples = target;
+    best.leftFrequency = leftFrequency;
+    best.rightFrequency = rightFrequency;
+    best.phaseError = getPhaseError (leftFrequency, rightFrequency, sampleRate, target);
+
+    // Tries one candidate; returns true once it is good enough to stop the search
+    auto tryLength = [&] (int length, bool retune)
+    {
+        if (length < 1)
+            return false;
+
+        auto left = leftFrequency;
+        auto right = rightFrequency;
+
+        if (retune)
+        {
+            left = getRetunedFrequency (leftFrequency, sampleRate, length);
+            right = getRetunedFrequency (rightFrequency, sampleRate, length);
+
+            if (std::abs (left - leftFrequency) > maxRetuneHz || std::abs (right - rightFrequency) > maxRetuneHz)
+                return false;
+        }
+
+        const auto error = getPhaseError (left, right, sampleRate, length);
+
+        if (error < best.phaseError)
+        {
+            best.lengthSamples = length;
+            best.leftFrequency = left;
+            best.rightFrequency = right;
+            best.phaseError = error;
+        }
+
+        return error <= tolerance;
+    };
+
+    // Nearest to the requested length first, so the first match is the one to keep
+    for (auto retune : { false, true })
+    {
+        for (int distance = 0; distance <= searchRange && best.phaseError > tolerance; ++distance)
+            if (tryLength (target + distance, retune) || tryLength (target - distance, retune))
+                break;
+    }
+
+    if (needsCrossfade || best.phaseError > tolerance)
+        best.crossfadeSamples = juce::jmin (best.lengthSamples / 2,
+                                            juce::roundToInt (crossfadeSeconds * sampleRate));
+
+    return best;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+    Picks loop lengths for repeating exports.
+
+    A loop of N samples wraps without a click when both carriers complete a
+    whole number of cycles in it. plan() looks for such a length within
+    +/-10 % of the requested one, nearest first, checking the phase the
+    oscillators actually accumulate from their float frequencies:
+
+    1. with the carriers as they are;
+    2. failing that, with each carrier retuned to the nearest whole number of
+       cycles, as long as no carrier moves by more than maxRetuneHz (a few
+       hundredths of a hertz for loops of tens of seconds);
+    3. failing that, at the length with the smallest mismatch, with a
+       crossfade to hide the wrap.
+
+    A bed layer does not repeat, so it always asks for the crossfade as well;
+    the carriers still get a whole number of cycles so the fade is
+    transparent on them.
+*/
+class SeamlessLoop
+{
+public:
+    struct Plan
+    {
+        int lengthSamples = 0;
+
+        // Carrier frequencies to render the loop with (possibly retuned)
+        float leftFrequency = 440.0f;
+        float rightFrequency = 450.0f;
+
+        // 0 when the loop repeats exactly; otherwise the length of the
+        // crossfade from the loop's end into the audio before its start
+        int crossfadeSamples = 0;
+
+        // Largest carrier phase mismatch at the wrap, in cycles
+        double phaseError = 0.0;
+
+        bool isSeamless() const noexcept  { return crossfadeSamples == 0; }
+    };
+
+    /** About -64 dB of step at the wrap for a full-scale carrier. */
+    static constexpr double defaultTolerance = 1.0e-4;
+    static constexpr float maxRetuneHz = 0.05f;
+    static constexpr double crossfadeSeconds = 1.0;
+
+    static Plan plan (float leftFrequency, float rightFrequency, double sampleRate,
+                      double targetSeconds, bool needsCrossfade = false,
+                      double tolerance = defaultTolerance);
+
+    /** Phase mismatch in cycles after numSamples, worst of the two carriers. */
+    static double getPhaseError (float leftFrequency, float rightFrequency, double sampleRate,
+                                 int numSamples) noexcept;
+};
@@ -0,0 +1,139 @@
+#include "SessionState.h"
+
+namespace
+{
+    juce::RangedAudioParameter* asRanged (juce::AudioProcessorParameter* parameter) noexcept
+    {
+        return dynamic_cast<juce::RangedAudioParameter*> (parameter);
+    }
+
+    float readFloat (const char* source) noexcept
+    {
+        const auto bits = juce::ByteOrder::littleEndianInt (source);
+        float value;
+        std::memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+}
+
+//==============================================================================
+juce::uint32 SessionState::hashParameterID (const juce::String& parameterID) noexcept
+{
+    // FNV-1a over the UTF-8 bytes; fixed here so it never depends on String::hashCode
+    juce::uint32 hash = 2166136261u;
+
+    for (auto* c = parameterID.toRawUTF8(); *c != 0; ++c)
+    {
+        hash ^= (juce::uint8) *c;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+void SessionState::write (juce::AudioProcessor& processor, const Contents& contents, juce::MemoryBlock& destData)
+{
+    const auto& parameters = processor.getParameters();
+    const auto backgroundBytes = (int) contents.backgroundFile.getNumBytesAsUTF8();
+
+    destData.reset();
+    juce::MemoryOutputStream stream (destData, false);
+    stream.preallocate ((size_t) (headerSize + entrySize * parameters.size() + 8 + backgroundBytes));
+
+    int numParameters = 0;
+
+    for (auto* parameter : parameters)
+        if (asRanged (parameter) != nullptr)
+            ++numParameters;
+
+    stream.writeInt ((int) magic);
+    stream.writeShort ((short) currentVersion);
+    stream.writeShort ((short) numParameters);
+
+    for (auto* parameter : parameters)
+    {
+        if (auto* ranged = asRanged (parameter))
+        {
+            stream.writeInt ((int) hashParameterID (ranged->getParameterID()));
+            stream.writeFloat (ranged->convertFrom0to1 (ranged->getValue()));
+        }
+    }
+
+    stream.writeInt ((int) backgroundFileTag);
+    stream.writeInt (backgroundBytes);
+    stream.write (contents.backgroundFile.toRawUTF8(), (size_t) backgroundBytes);
+}
+
+bool SessionState::isBinaryState (const void* data, int sizeInBytes) noexcept
+{
+    return data != nullptr && sizeInBytes >= headerSize
+        && juce::ByteOrder::littleEndianInt (data) == magic;
+}
+
+bool SessionState::read (const void* data, int sizeInBytes, juce::AudioProcessor& processor, Contents& contents)
+{
+    if (! isBinaryState (data, sizeInBytes))
+        return false;
+
+    const auto* bytes = static_cast<const char*> (data);
+    const auto version = juce::ByteOrder::littleEndianShort (bytes + 4);
+
+    // A newer layout would be misread rather than rejected below
+    if (version == 0 || version > currentVersion)
+        return false;
+
+    const auto numEntries = (int) juce::ByteOrder::littleEndianShort (bytes + 6);
+    const auto* entries = bytes + headerSize;
+    const auto* chunks = entries + numEntries * entrySize;
+    const auto* end = bytes + sizeInBytes;
+
+    if (chunks > end)
+        return false;
+
+    // Validate the chunk list before touching anything
+    Contents newContents;
+
+    for (auto* chunk = chunks; chunk != end;)
+    {
+        if (end - chunk < 8)
+            return false;
+
+        const auto tag = juce::ByteOrder::littleEndianInt (chunk);
+        const auto size = juce::ByteOrder::littleEndianInt (chunk + 4);
+
+        if (size > (juce::uint32) (end - chunk - 8))
+            return false;
+
+        if (tag == backgroundFileTag)
+            newContents.backgroundFile = juce::String::fromUTF8 (chunk + 8, (int) size);
+
+        chunk += 8 + size;
+    }
+
+    for (auto* parameter : processor.getParameters())
+    {
+        auto* ranged = asRanged (parameter);
+
+        if (ranged == nullptr)
+            continue;
+
+        const auto hash = hashParameterID (ranged->getParameterID());
+        auto normalised = ranged->getDefaultValue();
+
+        for (int i = 0; i < numEntries; ++i)
+        {
+            const auto* entry = entries + i * entrySize;
+
+            if (juce::ByteOrder::littleEndianInt (entry) == hash)
+            {
+                normalised = ranged->convertTo0to1 (readFloat (entry + 4));
+                break;
+            }
+        }
+
+        ranged->setValueNotifyingHost (normalised);
+    }
+
+    contents = newContents;
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+//==============================================================================
+/**
+    Compact binary plugin state.
+
+    Layout (little-endian):
+        "BGST"  uint16 version  uint16 numParameters
+        numParameters x { uint32 id hash, float32 value }
+        chunks until the end: { uint32 tag, uint32 size, size bytes }
+
+    Parameter IDs are stored as FNV-1a hashes and values denormalised, so
+    parameters can be added, removed, reordered or have their ranges changed
+    without breaking old sessions; parameters missing from the data go back
+    to their defaults. Readers skip chunk tags they do not know, which keeps
+    newer sessions loadable by older builds. Only a change to the layout
+    above bumps currentVersion, and read() refuses versions newer than its own.
+
+    Loading is a single walk over the bytes with no text parsing or tree
+    building. Data that does not start with the magic is left to the caller,
+    which falls back to the XML state written by earlier versions.
+*/
+class SessionState
+{
+public:
+    static constexpr juce::uint16 currentVersion = 1;
+
+    /** Chunk tags. */
+    static constexpr juce::uint32 backgroundFileTag = 0x4c464742; // "BGFL"
+
+    struct Contents
+    {
+        juce::String backgroundFile;
+    };
+
+    static void write (juce::AudioProcessor& processor, const Contents& contents, juce::MemoryBlock& destData);
+
+    static bool isBinaryState (const void* data, int sizeInBytes) noexcept;
+
+    /** Applies the parameter values and fills contents; returns false (and
+        changes nothing) if the data is truncated, malformed or has a layout
+        version this build does not know.
+    */
+    static bool read (const void* data, int sizeInBytes, juce::AudioProcessor& processor, Contents& contents);
+
+    static juce::uint32 hashParameterID (const juce::String& parameterID) noexcept;
+
+private:
+    static constexpr juce::uint32 magic = 0x54534742; // "BGST"
+    static constexpr int headerSize = 8;
+    static constexpr int entrySize = 8;
+};
@@ -0,0 +1,226 @@
+#include "SpectrumAnalyzer.h"
+
+namespace
+{
+    constexpr float minFrequency = 20.0f;
+    constexpr float maxFrequency = 20000.0f;
+    constexpr float minDecibels = -100.0f;
+    constexpr float envelopeReleaseSeconds = 0.005f;
+}
+
+//==============================================================================
+SpectrumAnalyzer::SpectrumAnalyzer (AnalyzerFeed& feed, std::function<double()> sampleRateSource)
+    : analyzerFeed (feed),
+      getSampleRate (std::move (sampleRateSource))
+{
+    history.setSize (2, fftSize);
+    history.clear();
+    incoming.setSize (2, AnalyzerFeed::capacity);
+    fftData.resize ((size_t) fftSize * 2);
+
+    for (auto& magnitudes : magnitudesDb)
+        magnitudes.assign ((size_t) fftSize / 2, minDecibels);
+
+    envelope.assign ((size_t) envelopePoints, 0.0f);
+
+    setOpaque (true);
+    analyzerFeed.setActive (true);
+    startTimerHz (framesPerSecond);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    stopTimer();
+    analyzerFeed.setActive (false);
+}
+
+//==============================================================================
+void SpectrumAnalyzer::timerCallback()
+{
+    const auto rate = getSampleRate != nullptr ? getSampleRate() : 0.0;
+    sampleRate = rate > 0.0 ? rate : 44100.0;
+
+    const auto numNew = analyzerFeed.pull (incoming.getWritePointer (0), incoming.getWritePointer (1),
+                                           incoming.getNumSamples());
+
+    // Nothing new: keep the cached paths, skip the FFT
+    if (numNew == 0)
+        return;
+
+    updateEnvelope (incoming.getReadPointer (0), incoming.getReadPointer (1), numNew);
+
+    const auto numToAppend = juce::jmin (numNew, fftSize);
+    const auto numToKeep = fftSize - numToAppend;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* data = history.getWritePointer (channel);
+        std::memmove (data, data + numToAppend, (size_t) numToKeep * sizeof (float));
+        juce::FloatVectorOperations::copy (data + numToKeep,
+                                           incoming.getReadPointer (channel, numNew - numToAppend),
+                                           numToAppend);
+    }
+
+    analyseSpectrum();
+    rebuildPaths();
+    repaint();
+}
+
+void SpectrumAnalyzer::analyseSpectrum()
+{
+    // Hann coherent gain is 0.5, so a full-scale sine reads 0 dB
+    const auto scale = 4.0f / (float) fftSize;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        std::fill (fftData.begin(), fftData.end(), 0.0f);
+        juce::FloatVectorOperations::copy (fftData.data(), history.getReadPointer (channel), fftSize);
+        window.multiplyWithWindowingTable (fftData.data(), (size_t) fftSize);
+        fft.performFrequencyOnlyForwardTransform (fftData.data());
+
+        auto& magnitudes = magnitudesDb[(size_t) channel];
+
+        for (size_t bin = 0; bin < magnitudes.size(); ++bin)
+            magnitudes[bin] = juce::Decibels::gainToDecibels (fftData[bin] * scale, minDecibels);
+    }
+
+    leftPeakHz = findPeakFrequency (magnitudesDb[0]);
+    rightPeakHz = findPeakFrequency (magnitudesDb[1]);
+}
+
+float SpectrumAnalyzer::findPeakFrequency (const std::vector<float>& magnitudes) const
+{
+    size_t peakBin = 1;
+
+    for (size_t bin = 2; bin + 1 < magnitudes.size(); ++bin)
+        if (magnitudes[bin] > magnitudes[peakBin])
+            peakBin = bin;
+
+    if (magnitudes[peakBin] <= minDecibels + 10.0f)
+        return 0.0f;
+
+    // Parabolic interpolation on the log magnitudes around the peak bin
+    const auto a = magnitudes[peakBin - 1];
+    const auto b = magnitudes[peakBin];
+    const auto c = magnitudes[peakBin + 1];
+    const auto denominator = a - 2.0f * b + c;
+    const auto offset = denominator != 0.0f ? 0.5f * (a - c) / denominator : 0.0f;
+
+    return ((float) peakBin + offset) * (float) sampleRate / (float) fftSize;
+}
+
+void SpectrumAnalyzer::updateEnvelope (const float* left, const float* right, int numSamples)
+{
+    const auto samplesPerPoint = juce::jmax (1, (int) (sampleRate * envelopeSeconds / envelopePoints));
+    const auto release = std::exp (-1.0f / (envelopeReleaseSeconds * (float) sampleRate));
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Peak follower on the acoustic sum, where the beat shows as amplitude modulation
+        envelopePeak = juce::jmax (std::abs (left[i] + right[i]), envelopePeak * release);
+
+        if (++envelopeCounter >= samplesPerPoint)
+        {
+            envelope[(size_t) envelopeWritePosition] = envelopePeak;
+            envelopeWritePosition = (envelopeWritePosition + 1) % envelopePoints;
+            envelopeCounter = 0;
+        }
+    }
+}
+
+//==============================================================================
+void SpectrumAnalyzer::rebuildPaths()
+{
+    const auto area = spectrumArea.toFloat();
+    const auto width = juce::jmax (1, spectrumArea.getWidth());
+    const auto binWidth = (float) sampleRate / (float) fftSize;
+    const auto logRange = std::log (maxFrequency / minFrequency);
+
+    auto toY = [&area] (float decibels)
+    {
+        const auto normalised = juce::jlimit (0.0f, 1.0f, decibels / minDecibels);
+        return area.getY() + normalised * area.getHeight();
+    };
+
+    juce::Path* const spectrumPaths[] = { &leftSpectrumPath, &rightSpectrumPath };
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        const auto& magnitudes = magnitudesDb[(size_t) channel];
+        auto& path = *spectrumPaths[channel];
+        path.clear();
+
+        // One point per pixel column, keeping the loudest bin that falls in it
+        for (int x = 0; x < width; ++x)
+        {
+            const auto lowHz = minFrequency * std::exp (logRange * (float) x / (float) width);
+            const auto highHz = minFrequency * std::exp (logRange * (float) (x + 1) / (float) width);
+            const auto lowBin = juce::jlimit (1, (int) magnitudes.size() - 1, (int) (lowHz / binWidth));
+            const auto highBin = juce::jlimit (lowBin, (int) magnitudes.size() - 1, (int) (highHz / binWidth));
+
+            auto level = minDecibels;
+
+            for (int bin = lowBin; bin <= highBin; ++bin)
+                level = juce::jmax (level, magnitudes[(size_t) bin]);
+
+            const auto px = area.getX() + (float) x;
+
+            if (x == 0)
+                path.startNewSubPath (px, toY (level));
+            else
+                path.lineTo (px, toY (level));
+        }
+    }
+
+    // Envelope, oldest point on the left
+    envelopePath.clear();
+    const auto envelopeBounds = envelopeArea.toFloat();
+
+    for (int point = 0; point < envelopePoints; ++point)
+    {
+        const auto value = juce::jlimit (0.0f, 2.0f, envelope[(size_t) ((envelopeWritePosition + point) % envelopePoints)]);
+        const auto px = envelopeBounds.getX() + envelopeBounds.getWidth() * (float) point / (float) (envelopePoints - 1);
+        const auto py = envelopeBounds.getBottom() - envelopeBounds.getHeight() * value * 0.5f;
+
+        if (point == 0)
+            envelopePath.startNewSubPath (px, py);
+        else
+            envelopePath.lineTo (px, py);
+    }
+}
+
+void SpectrumAnalyzer::resized()
+{
+    auto area = getLocalBounds().reduced (4);
+    area.removeFromBottom (18); // readout
+    envelopeArea = area.removeFromBottom (area.getHeight() / 3);
+    area.removeFromBottom (4);
+    spectrumArea = area;
+    rebuildPaths();
+}
+
+void SpectrumAnalyzer::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colour (0xff1a1a1a));
+
+    g.setColour (juce::Colour (0xff2f2f2f));
+    g.fillRect (spectrumArea);
+    g.fillRect (envelopeArea);
+
+    g.setColour (juce::Colour (0xff4a9eff));
+    g.strokePath (leftSpectrumPath, juce::PathStrokeType (1.2f));
+    g.setColour (juce::Colours::orange);
+    g.strokePath (rightSpectrumPath, juce::PathStrokeType (1.2f));
+    g.setColour (juce::Colours::lightgreen);
+    g.strokePath (envelopePath, juce::PathStrokeType (1.2f));
+
+    juce::String readout = "L " + juce::String (leftPeakHz, 2) + " Hz   R " + juce::String (rightPeakHz, 2) + " Hz";
+
+    if (leftPeakHz > 0.0f && rightPeakHz > 0.0f)
+        readout += "   Beat " + juce::String (std::abs (rightPeakHz - leftPeakHz), 2) + " Hz";
+
+    g.setColour (juce::Colours::white);
+    g.setFont (13.0f);
+    g.drawText (readout, getLocalBounds().reduced (6, 2).removeFromBottom (16),
+                juce::Justification::centredLeft);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include "AnalyzerFeed.h"
+
+//==============================================================================
+/**
+    Spectrum and beat-envelope view for the editor.
+
+    Pulls from the processor's AnalyzerFeed on a capped-rate timer, runs the
+    FFT on the message thread and only rebuilds its paths when new audio has
+    arrived. The feed is switched on for as long as this component exists.
+*/
+class SpectrumAnalyzer final : public juce::Component,
+                               private juce::Timer
+{
+public:
+    SpectrumAnalyzer (AnalyzerFeed& feed, std::function<double()> sampleRateSource);
+    ~SpectrumAnalyzer() override;
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+    void analyseSpectrum();
+    void updateEnvelope (const float* left, const float* right, int numSamples);
+    void rebuildPaths();
+    float findPeakFrequency (const std::vector<float>& magnitudes) const;
+
+    static constexpr int fftOrder = 14;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int framesPerSecond = 30;
+    static constexpr int envelopePoints = 512;
+    static constexpr double envelopeSeconds = 2.0;
+
+    AnalyzerFeed& analyzerFeed;
+    std::function<double()> getSampleRate;
+
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann };
+
+    // Most recent fftSize frames per channel, oldest first
+    juce::AudioBuffer<float> history;
+    juce::AudioBuffer<float> incoming;
+    std::vector<float> fftData;
+    std::array<std::vector<float>, 2> magnitudesDb;
+
+    // Peak of |L + R| per envelope point, circular
+    std::vector<float> envelope;
+    int envelopeWritePosition = 0;
+    float envelopePeak = 0.0f;
+    int envelopeCounter = 0;
+
+    float leftPeakHz = 0.0f;
+    float rightPeakHz = 0.0f;
+    double sampleRate = 44100.0;
+
+    juce::Rectangle<int> spectrumArea, envelopeArea;
+    juce::Path leftSpectrumPath, rightSpectrumPath, envelopePath;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyzer)
+};
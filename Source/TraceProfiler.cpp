@@ -0,0 +1,146 @@
+#include "TraceProfiler.h"
+
+thread_local TraceProfiler* TraceProfiler::current = nullptr;
+
+//==============================================================================
+TraceProfiler::~TraceProfiler()
+{
+    stop();
+}
+
+void TraceProfiler::start()
+{
+    {
+        const juce::ScopedLock sl (lock);
+        events.clear();
+        events.reserve (4096);
+        threadIds.clear();
+        threadNames.clear();
+    }
+
+    bytesWritten = 0;
+    samplesProcessed = 0;
+    startTicks = stopTicks = juce::Time::getHighResolutionTicks();
+    running = true;
+}
+
+void TraceProfiler::stop()
+{
+    if (running.exchange (false))
+        stopTicks = juce::Time::getHighResolutionTicks();
+}
+
+void TraceProfiler::record (const char* name, juce::int64 start, juce::int64 end)
+{
+    const auto threadId = juce::Thread::getCurrentThreadId();
+    const juce::ScopedLock sl (lock);
+
+    auto thread = (int) (std::find (threadIds.begin(), threadIds.end(), threadId) - threadIds.begin());
+
+    if (thread == (int) threadIds.size())
+    {
+        auto* juceThread = juce::Thread::getCurrentThread();
+        threadIds.push_back (threadId);
+        threadNames.add (juceThread != nullptr ? juceThread->getThreadName() : juce::String ("Thread " + juce::String (thread + 1)));
+    }
+
+    events.push_back ({ name, start, end, thread });
+}
+
+double TraceProfiler::ticksToMicroseconds (juce::int64 ticks) const noexcept
+{
+    return juce::Time::highResolutionTicksToSeconds (ticks) * 1.0e6;
+}
+
+//==============================================================================
+juce::var TraceProfiler::getSummary() const
+{
+    const juce::ScopedLock sl (lock);
+
+    struct Totals
+    {
+        juce::int64 total = 0, self = 0;
+        int count = 0;
+    };
+
+    std::map<juce::String, Totals> stages;
+
+    // Self time: each event minus the events nested directly inside it on its thread
+    auto sorted = events;
+    std::sort (sorted.begin(), sorted.end(), [] (const Event& a, const Event& b)
+               { return a.thread != b.thread ? a.thread < b.thread
+                                             : (a.start != b.start ? a.start < b.start : a.end > b.end); });
+
+    std::vector<std::pair<const Event*, juce::int64>> open; // event, time taken by children
+
+    auto close = [&] (const Event& event, juce::int64 childTime)
+    {
+        auto& totals = stages[event.name];
+        totals.total += event.end - event.start;
+        totals.self += event.end - event.start - childTime;
+        ++totals.count;
+    };
+
+    for (const auto& event : sorted)
+    {
+        while (! open.empty() && (open.back().first->thread != event.thread || open.back().first->end <= event.start))
+        {
+            close (*open.back().first, open.back().second);
+            open.pop_back();
+        }
+
+        if (! open.empty())
+            open.back().second += event.end - event.start;
+
+        open.emplace_back (&event, 0);
+    }
+
+    for (auto it = open.rbegin(); it != open.rend(); ++it)
+        close (*it->first, it->second);
+
+    auto* stageList = new juce::DynamicObject();
+
+    for (const auto& [name, totals] : stages)
+    {
+        auto* stage = new juce::DynamicObject();
+        stage->setProperty ("totalMs", ticksToMicroseconds (totals.total) / 1000.0);
+        stage->setProperty ("selfMs", ticksToMicroseconds (totals.self) / 1000.0);
+        stage->setProperty ("count", totals.count);
+        stageList->setProperty (name, juce::var (stage));
+    }
+
+    const auto endTicks = running ? juce::Time::getHighResolutionTicks() : stopTicks;
+    const auto wallSeconds = juce::Time::highResolutionTicksToSeconds (endTicks - startTicks);
+
+    auto* summary = new juce::DynamicObject();
+    summary->setProperty ("wallSeconds", wallSeconds);
+    summary->setProperty ("bytesWritten", bytesWritten.load());
+    summary->setProperty ("samples", samplesProcessed.load());
+    summary->setProperty ("samplesPerSecond", wallSeconds > 0.0 ? (double) samplesProcessed.load() / wallSeconds : 0.0);
+    summary->setProperty ("stages", juce::var (stageList));
+    return juce::var (summary);
+}
+
+bool TraceProfiler::writeChromeTrace (const juce::File& file) const
+{
+    const juce::ScopedLock sl (lock);
+
+    // Written by hand: the JSON classes would build a var per event
+    juce::MemoryOutputStream json;
+    json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    for (int thread = 0; thread < threadNames.size(); ++thread)
+        json << (thread > 0 ? "," : "")
+             << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << thread
+             << ",\"args\":{\"name\":" << juce::JSON::toString (threadNames[thread]) << "}}";
+
+    // Every thread that recorded an event has a name entry above, so each event follows a comma
+    for (const auto& event : events)
+        json << ",{\"ph\":\"X\",\"cat\":\"export\",\"name\":\"" << event.name
+             << "\",\"pid\":1,\"tid\":" << event.thread
+             << ",\"ts\":" << juce::String (ticksToMicroseconds (event.start - startTicks), 3)
+             << ",\"dur\":" << juce::String (ticksToMicroseconds (event.end - event.start), 3) << "}";
+
+    json << "]}";
+    return file.replaceWithData (json.getData(), json.getDataSize());
+}
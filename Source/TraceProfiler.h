@@ -0,0 +1,156 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+    Scoped trace instrumentation for exports.
+
+    BINAURAL_TRACE_SCOPE ("name") times the enclosing scope and records it in
+    the profiler attached to the calling thread with a ScopedAttach. Nothing
+    is global: the job that owns a profiler attaches it on its own thread, and
+    helper threads it starts (the bed reader) attach the one that was current
+    where they were started, so scopes from other exports or from playback
+    never land in it. With none attached a scope costs one thread-local load,
+    so the macros stay in place in release builds. A profiler must outlive
+    every thread it is attached to.
+
+    After a run, writeChromeTrace() emits Chrome/Perfetto trace JSON
+    (load it in ui.perfetto.dev or chrome://tracing) and getSummary() gives
+    total and self time per stage, bytes written and samples per second.
+    Recording takes a lock, which is fine for offline work; never start a
+    profiler around the real-time audio thread.
+*/
+class TraceProfiler
+{
+public:
+    TraceProfiler() = default;
+    ~TraceProfiler();
+
+    /** Clears the previous run and starts the clock; scopes are only
+        recorded from threads the profiler is attached to.
+    */
+    void start();
+    void stop();
+
+    void addBytesWritten (juce::int64 numBytes) noexcept  { bytesWritten += numBytes; }
+    void addSamples (juce::int64 numSamples) noexcept     { samplesProcessed += numSamples; }
+
+    /** Per-stage totals plus job counters, as a JSON object. */
+    juce::var getSummary() const;
+
+    bool writeChromeTrace (const juce::File& file) const;
+
+    /** The profiler attached to the calling thread, or nullptr. */
+    static TraceProfiler* getCurrent() noexcept  { return current; }
+
+    //==============================================================================
+    /** Attaches a profiler (or none) to the calling thread until the end of the scope. */
+    class ScopedAttach
+    {
+    public:
+        explicit ScopedAttach (TraceProfiler* profiler) noexcept
+            : previous (current)
+        {
+            current = profiler;
+        }
+
+        ~ScopedAttach()
+        {
+            current = previous;
+        }
+
+    private:
+        TraceProfiler* const previous;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedAttach)
+    };
+
+    //==============================================================================
+    class Scope
+    {
+    public:
+        explicit Scope (const char* stageName) noexcept
+            : profiler (getCurrent()), name (stageName),
+              startTicks (profiler != nullptr ? juce::Time::getHighResolutionTicks() : 0)
+        {
+        }
+
+        ~Scope()
+        {
+            if (profiler != nullptr)
+                profiler->record (name, startTicks, juce::Time::getHighResolutionTicks());
+        }
+
+    private:
+        TraceProfiler* const profiler;
+        const char* const name;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+
+private:
+    struct Event
+    {
+        const char* name;
+        juce::int64 start, end;
+        int thread;
+    };
+
+    void record (const char* name, juce::int64 start, juce::int64 end);
+    double ticksToMicroseconds (juce::int64 ticks) const noexcept;
+
+    static thread_local TraceProfiler* current;
+
+    mutable juce::CriticalSection lock;
+    std::vector<Event> events;
+    std::vector<juce::Thread::ThreadID> threadIds;
+    juce::StringArray threadNames;
+
+    juce::int64 startTicks = 0, stopTicks = 0;
+    std::atomic<bool> running { false };
+    std::atomic<juce::int64> bytesWritten { 0 }, samplesProcessed { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TraceProfiler)
+};
+
+#define BINAURAL_TRACE_SCOPE(stageName)  const TraceProfiler::Scope JUCE_JOIN_MACRO (traceScope, __LINE__) (stageName)
+
+//==============================================================================
+/**
+    Passes writes through to another stream, timing them as the "disk write"
+    stage and counting the bytes in the calling thread's profiler.
+*/
+class TracingOutputStream  : public juce::OutputStream
+{
+public:
+    explicit TracingOutputStream (std::unique_ptr<juce::OutputStream> destination)
+        : output (std::move (destination))
+    {
+    }
+
+    void flush() override
+    {
+        BINAURAL_TRACE_SCOPE ("disk write");
+        output->flush();
+    }
+
+    bool setPosition (juce::int64 newPosition) override  { return output->setPosition (newPosition); }
+    juce::int64 getPosition() override                   { return output->getPosition(); }
+
+    bool write (const void* data, size_t numBytes) override
+    {
+        BINAURAL_TRACE_SCOPE ("disk write");
+
+        if (auto* profiler = TraceProfiler::getCurrent())
+            profiler->addBytesWritten ((juce::int64) numBytes);
+
+        return output->write (data, numBytes);
+    }
+
+private:
+    std::unique_ptr<juce::OutputStream> output;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TracingOutputStream)
+};